@@ -1,5 +1,7 @@
 /* Simple demo file to experiment with the VGA controller on the DE1-SoC
  * Computer System by Altera.
+ *
+ * gcc clear_screen.c vga_fill.c ../vga_dev.c -I.. -o clear_screen
  */
 
 #include <stdio.h>
@@ -8,34 +10,21 @@
 #include <sys/mman.h>
 #include <sys/shm.h>
 #include "address_map_arm_brl4.h"
+#include "vga_dev.h"
+#include "vga_fill.h"
 
 
 int main()
 {
-    int fd;
-    if ( (fd = open("/dev/mem", (O_RDWR|O_SYNC))) == -1 ) {
-        printf("Error: failed to open \"/dev/mem\".\n");
-        close(fd);
-        return 1;
-    }
+    // /dev/mem, or plain memory when DE1_SIM is set (see vga_dev.h)
+    vga_dev_t dev;
+    if (vga_dev_open(&dev, NULL) != 0) return 1;
+    void *pixel_buffer_addr = dev.pixel_base;
 
-    void *pixel_buffer_addr;
-    if ( (pixel_buffer_addr = mmap(NULL, FPGA_ONCHIP_SPAN,
-                                   (PROT_READ|PROT_WRITE),
-                                   MAP_SHARED, fd, FPGA_ONCHIP_BASE))
-            == MAP_FAILED )
-    {
-        printf("Error: failed to map the pixel buffer.\n");
-        close(fd);
-        return 1;
-    }
-
-    volatile unsigned int *pixel = (unsigned int *)pixel_buffer_addr;
-    int count = 131072;
-    while ( count > 0 ) {
-        *pixel++ = 0x0000;
-        --count;
-    }
+    // the 640 visible bytes of each of the 480 rows, 16 at a time; the
+    // other 384 bytes of each 1024-byte row are not shown
+    vga_fill(pixel_buffer_addr, 1024, 0, 0, 640, 480, 0x00);
 
+    vga_dev_close(&dev);
     return 0;
 }
\ No newline at end of file
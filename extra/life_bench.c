@@ -0,0 +1,298 @@
+///////////////////////////////////////
+/// Headless generation throughput
+/// benchmark for the Life engines
+/// compile with
+/// gcc life_bench.c life_bits.c life_byte.c life_pool.c life_hash.c life_sparse.c life_rule.c life_pattern.c -o life_bench -O2 -mfpu=neon -pthread
+/// usage: life_bench [-s WxH,...] [-p empty,guns,soup] [-e engine,...]
+///                   [-g gens] [-w warmup] [-r reps] [-t threads]
+///   sweeps every size x pattern x engine and prints one JSON document
+///   on stdout, progress on stderr. engines: bits, bits-full, bits-par,
+///   byte-<kernel> (byte = fastest kernel), byte-par, hash, sparse
+///   defaults: all four sizes 320x240 640x480 4096x4096 16384x16384,
+///   all patterns, bits,bits-full,bits-par,byte,byte-par,hash,sparse,
+///   10 generations after 2 of warmup, 3 repetitions.
+///   hash steps one generation at a time; hash and sparse are loaded from
+///   the seeded grid; runs whose grid cannot be allocated are reported
+///   with "skipped"
+///////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "life_bits.h"
+#include "life_byte.h"
+#include "life_pool.h"
+#include "life_hash.h"
+#include "life_sparse.h"
+#include "life_pattern.h"
+
+// one engine under test
+typedef struct bench {
+	const char *name;
+	int kind;               // BENCH_*
+	int kernel;             // byte kernel
+	life_bits_t bits;
+	life_byte_t byte;
+	life_hash_t hash;
+	life_sparse_t sparse;
+} bench_t;
+
+#define BENCH_BITS      0
+#define BENCH_BITS_FULL 1
+#define BENCH_BITS_PAR  2
+#define BENCH_BYTE      3
+#define BENCH_BYTE_PAR  4
+#define BENCH_HASH      5
+#define BENCH_SPARSE    6
+
+life_pool_t pool;
+
+/****************************************************************************************
+ * Engine adapters
+****************************************************************************************/
+void bits_set(void *g, int x, int y, int alive){
+	life_bits_set((life_bits_t *)g, x, y, alive);
+}
+
+void byte_set(void *g, int x, int y, int alive){
+	life_byte_set((life_byte_t *)g, x, y, alive);
+}
+
+void step_bits_band(void *g, int lo, int hi){
+	life_bits_step_tiles((life_bits_t *)g, lo, hi);
+}
+
+void step_byte_band(void *g, int lo, int hi){
+	life_byte_step_rows((life_byte_t *)g, lo, hi);
+}
+
+int bench_lookup(bench_t *b, const char *name){
+	memset(b, 0, sizeof(*b));
+	b->name = name;
+	if (strcmp(name, "bits") == 0) b->kind = BENCH_BITS;
+	else if (strcmp(name, "bits-full") == 0) b->kind = BENCH_BITS_FULL;
+	else if (strcmp(name, "bits-par") == 0) b->kind = BENCH_BITS_PAR;
+	else if (strcmp(name, "byte-par") == 0) b->kind = BENCH_BYTE_PAR;
+	else if (strcmp(name, "hash") == 0) b->kind = BENCH_HASH;
+	else if (strcmp(name, "sparse") == 0) b->kind = BENCH_SPARSE;
+	else if (strcmp(name, "byte") == 0) {
+		b->kind = BENCH_BYTE;
+		b->kernel = LIFE_KERNEL_AUTO;
+	}
+	else if (strncmp(name, "byte-", 5) == 0) {
+		b->kind = BENCH_BYTE;
+		b->kernel = life_byte_kernel_lookup(name + 5);
+		if (b->kernel < 0 || !life_byte_kernel_available(b->kernel)) return -1;
+	}
+	else return -1;
+	if (b->kind == BENCH_BYTE_PAR) b->kernel = LIFE_KERNEL_AUTO;
+	return 0;
+}
+
+// allocate and seed; the hash and sparse engines are loaded from a bits grid
+int bench_start(bench_t *b, int w, int h, const char *pattern){
+	life_set_fn set = bits_set;
+	void *g = &b->bits;
+	int err;
+
+	if (b->kind == BENCH_BYTE || b->kind == BENCH_BYTE_PAR) {
+		if (life_byte_init(&b->byte, w, h, b->kernel) != 0) return -1;
+		set = byte_set;
+		g = &b->byte;
+	}
+	else if (life_bits_init(&b->bits, w, h) != 0) return -1;
+	b->bits.track = b->kind != BENCH_BITS_FULL;
+
+	if (strcmp(pattern, "guns") == 0) life_pattern_four_guns(set, g, w, h);
+	else if (strcmp(pattern, "soup") == 0) life_pattern_soup(set, g, w, h, 5760);
+
+	if (b->kind == BENCH_HASH) {
+		err = life_hash_init(&b->hash, 0) != 0 ||
+		      life_hash_load_bits(&b->hash, &b->bits, 0, 0) != 0;
+		life_bits_free(&b->bits);
+		if (err) {
+			life_hash_free(&b->hash);
+			return -1;
+		}
+	}
+	if (b->kind == BENCH_SPARSE) {
+		err = life_sparse_init(&b->sparse) != 0 ||
+		      life_sparse_load_bits(&b->sparse, &b->bits, 0, 0) != 0;
+		life_bits_free(&b->bits);
+		if (err) {
+			life_sparse_free(&b->sparse);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int bench_step(bench_t *b){
+	switch (b->kind) {
+	case BENCH_BITS:
+	case BENCH_BITS_FULL:
+		life_bits_step(&b->bits);
+		break;
+	case BENCH_BITS_PAR:
+		life_pool_run(&pool, step_bits_band, &b->bits, b->bits.tiles_y);
+		life_bits_swap(&b->bits);
+		break;
+	case BENCH_BYTE:
+		life_byte_step(&b->byte);
+		break;
+	case BENCH_BYTE_PAR:
+		life_pool_run(&pool, step_byte_band, &b->byte, b->byte.height);
+		life_byte_swap(&b->byte);
+		break;
+	case BENCH_HASH:
+		return life_hash_step_pow2(&b->hash, 0);
+	case BENCH_SPARSE:
+		return life_sparse_step(&b->sparse);
+	}
+	return 0;
+}
+
+long bench_population(bench_t *b){
+	if (b->kind == BENCH_HASH) return (long)life_hash_population(&b->hash);
+	if (b->kind == BENCH_SPARSE) return life_sparse_population(&b->sparse);
+	if (b->kind == BENCH_BYTE || b->kind == BENCH_BYTE_PAR) return life_byte_population(&b->byte);
+	return life_bits_population(&b->bits);
+}
+
+void bench_stop(bench_t *b){
+	if (b->kind == BENCH_HASH) life_hash_free(&b->hash);
+	else if (b->kind == BENCH_SPARSE) life_sparse_free(&b->sparse);
+	else if (b->kind == BENCH_BYTE || b->kind == BENCH_BYTE_PAR) life_byte_free(&b->byte);
+	else life_bits_free(&b->bits);
+}
+
+/****************************************************************************************
+ * Timing
+****************************************************************************************/
+double now_ns(void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+int cmp_double(const void *a, const void *b){
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+// nearest-rank percentile of n sorted values
+double percentile(const double *v, int n, int p){
+	int k = (p * n + 99) / 100;
+	if (k < 1) k = 1;
+	return v[k-1];
+}
+
+/****************************************************************************************
+ * One size x pattern x engine run, printed as a JSON object
+****************************************************************************************/
+void bench_run(const char *engine, int w, int h, const char *pattern,
+	       int gens, int warmup, int reps, int first){
+	bench_t b;
+	double *lat, t, total = 0, cells;
+	int r, g, n = 0, ok = 1;
+	long pop = 0;
+
+	printf("%s\n    {\"engine\": \"%s\", \"width\": %d, \"height\": %d, \"pattern\": \"%s\"",
+	       first ? "" : ",", engine, w, h, pattern);
+	if (bench_lookup(&b, engine) != 0) {
+		printf(", \"skipped\": \"unknown or unavailable engine\"}");
+		return;
+	}
+	lat = malloc(sizeof(double) * gens * reps);
+	for (r=0; r<reps && ok; r++) {
+		if (bench_start(&b, w, h, pattern) != 0) {
+			ok = 0;
+			break;
+		}
+		for (g=0; g<warmup && ok; g++) ok = bench_step(&b) == 0;
+		for (g=0; g<gens && ok; g++) {
+			t = now_ns();
+			ok = bench_step(&b) == 0;
+			lat[n] = now_ns() - t;
+			total += lat[n++];
+		}
+		pop = bench_population(&b);
+		bench_stop(&b);
+		fprintf(stderr, "%s %dx%d %s rep %d: %.3f ms/gen\n", engine, w, h, pattern, r,
+			total / (n ? n : 1) / 1e6);
+	}
+	if (!ok || n == 0) {
+		printf(", \"skipped\": \"%s\"}", r == 0 ? "could not allocate" : "step failed");
+		free(lat);
+		return;
+	}
+	qsort(lat, n, sizeof(double), cmp_double);
+	cells = (double)w * h * n;
+	printf(", \"threads\": %d, \"warmup\": %d, \"generations\": %d, \"reps\": %d,\n"
+	       "     \"seconds\": %.6f, \"cells_per_sec\": %.4e, \"ns_per_cell\": %.6f,\n"
+	       "     \"p50_ms\": %.6f, \"p99_ms\": %.6f, \"population\": %ld}",
+	       (b.kind == BENCH_BITS_PAR || b.kind == BENCH_BYTE_PAR) ? pool.threads : 1,
+	       warmup, gens, reps, total / 1e9, cells / (total / 1e9), total / cells,
+	       percentile(lat, n, 50) / 1e6, percentile(lat, n, 99) / 1e6, pop);
+	free(lat);
+}
+
+int main(int argc, char **argv)
+{
+	char sizes[256] = "320x240,640x480,4096x4096,16384x16384";
+	char patterns[256] = "empty,guns,soup";
+	char engines[256] = "bits,bits-full,bits-par,byte,byte-par,hash,sparse";
+	char *s, *p, *e, *sp, *pp, *ep, pat[256], eng[256];
+	int opt, gens = 10, warmup = 2, reps = 3, threads = 0, w, h, first = 1;
+
+	while ((opt = getopt(argc, argv, "s:p:e:g:w:r:t:")) != -1) {
+		switch (opt) {
+		case 's': snprintf(sizes, sizeof(sizes), "%s", optarg); break;
+		case 'p': snprintf(patterns, sizeof(patterns), "%s", optarg); break;
+		case 'e': snprintf(engines, sizeof(engines), "%s", optarg); break;
+		case 'g': gens = atoi(optarg); break;
+		case 'w': warmup = atoi(optarg); break;
+		case 'r': reps = atoi(optarg); break;
+		case 't': threads = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-s WxH,...] [-p empty,guns,soup] [-e engine,...] "
+				"[-g gens] [-w warmup] [-r reps] [-t threads]\n", argv[0]);
+			return(1);
+		}
+	}
+	if (gens < 1 || reps < 1 || warmup < 0) {
+		fprintf(stderr, "ERROR: need -g >= 1, -r >= 1, -w >= 0...\n");
+		return(1);
+	}
+	if (life_pool_init(&pool, threads) != 0) {
+		fprintf(stderr, "could not start the stepping threads, stepping on one\n");
+		life_pool_init(&pool, 1);
+	}
+
+	printf("{\"benchmark\": \"life\", \"online_cpus\": %d, \"byte_kernel\": \"%s\",\n \"results\": [",
+	       life_pool_online_cpus(), life_byte_kernel_name(life_byte_kernel_best()));
+	for (s = strtok_r(sizes, ",", &sp); s; s = strtok_r(NULL, ",", &sp)) {
+		if (sscanf(s, "%dx%d", &w, &h) != 2 || w < 1 || h < 1) {
+			fprintf(stderr, "ERROR: bad size \"%s\"...\n", s);
+			return(1);
+		}
+		// strtok_r keeps its place in each list, so walk copies
+		strcpy(pat, patterns);
+		for (p = strtok_r(pat, ",", &pp); p; p = strtok_r(NULL, ",", &pp)) {
+			if (strcmp(p, "empty") && strcmp(p, "guns") && strcmp(p, "soup")) {
+				fprintf(stderr, "ERROR: unknown pattern \"%s\"...\n", p);
+				return(1);
+			}
+			strcpy(eng, engines);
+			for (e = strtok_r(eng, ",", &ep); e; e = strtok_r(NULL, ",", &ep)) {
+				bench_run(e, w, h, p, gens, warmup, reps, first);
+				first = 0;
+				fflush(stdout);
+			}
+		}
+	}
+	printf("\n ]}\n");
+	life_pool_free(&pool);
+	return(0);
+}
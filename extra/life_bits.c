@@ -0,0 +1,367 @@
+///////////////////////////////////////
+/// Bit-packed Game of Life engine
+/// 64 cells per word, next generation
+/// from bitwise full-adder logic,
+/// skipping tiles that cannot change,
+/// with B3/S23 and a few other rules
+/// specialized, any other rule generic,
+/// on a plane with dead edges or a torus
+///////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "life_bits.h"
+
+/****************************************************************************************
+ * Allocate a width x height grid with every cell dead
+****************************************************************************************/
+int life_bits_init(life_bits_t *g, int width, int height)
+{
+	int b;
+	size_t size;
+
+	memset(g, 0, sizeof(*g));
+	if (width < 1 || height < 1) return -1;
+
+	g->width = width;
+	g->height = height;
+	g->words = (width + 63) >> 6;
+	g->stride = g->words + 2;
+
+	// halo row above and below
+	size = (size_t)(height + 2) * g->stride * sizeof(uint64_t);
+	for (b=0; b<2; b++) {
+		g->mem[b] = malloc(size);
+		if (g->mem[b] == NULL) {
+			life_bits_free(g);
+			return -1;
+		}
+		memset(g->mem[b], 0, size);
+	}
+	g->cur  = g->mem[0] + g->stride + 1;
+	g->next = g->mem[1] + g->stride + 1;
+
+	// padding bits past the right edge of the last word stay dead
+	g->pad_mask = (width & 63) ? (1ULL << (width & 63)) - 1 : ~0ULL;
+	life_rule_make(&g->rule, LIFE_RULE_LIFE_B, LIFE_RULE_LIFE_S);
+
+	// both buffers start out equal, so no tile is dirty yet
+	g->tiles_x = g->words;
+	g->tiles_y = (height + LIFE_TILE_ROWS - 1) / LIFE_TILE_ROWS;
+	g->track = 1;
+	g->dirty = calloc((size_t)g->tiles_x * g->tiles_y, 1);
+	g->dirty_next = calloc((size_t)g->tiles_x * g->tiles_y, 1);
+	g->stepped = calloc((size_t)g->tiles_x * g->tiles_y, 1);
+	if (g->dirty == NULL || g->dirty_next == NULL || g->stepped == NULL) {
+		life_bits_free(g);
+		return -1;
+	}
+	return 0;
+}
+
+void life_bits_free(life_bits_t *g)
+{
+	free(g->mem[0]);
+	free(g->mem[1]);
+	free(g->dirty);
+	free(g->dirty_next);
+	free(g->stepped);
+	memset(g, 0, sizeof(*g));
+}
+
+void life_bits_clear(life_bits_t *g)
+{
+	size_t size = (size_t)(g->height + 2) * g->stride * sizeof(uint64_t);
+	memset(g->mem[0], 0, size);
+	memset(g->mem[1], 0, size);
+}
+
+void life_bits_set_rule(life_bits_t *g, const life_rule_t *rule)
+{
+	// a tile that was still under the old rule may not be under the new one
+	g->rule = *rule;
+	memset(g->dirty, 1, (size_t)g->tiles_x * g->tiles_y);
+}
+
+/****************************************************************************************
+ * Toroidal halo of row y of buffer buf: the left halo word ends with the
+ * last cell of the row, the right one starts with the first, and the halo
+ * rows repeat the last and first rows, halo words included
+****************************************************************************************/
+static void life_bits_wrap_row(life_bits_t *g, uint64_t *buf, int y)
+{
+	uint64_t *p = LIFE_BITS_ROW(g, buf, y);
+	int last = g->width - 1;
+	size_t size = g->stride * sizeof(uint64_t);
+
+	p[-1] = ((p[last >> 6] >> (last & 63)) & 1) << 63;
+	p[g->words] = p[0];
+	if (y == 0) memcpy(LIFE_BITS_ROW(g, buf, g->height) - 1, p - 1, size);
+	if (y == g->height - 1) memcpy(LIFE_BITS_ROW(g, buf, -1) - 1, p - 1, size);
+}
+
+static void life_bits_wrap(life_bits_t *g, uint64_t *buf)
+{
+	int y;
+
+	for (y=0; y<g->height; y++) life_bits_wrap_row(g, buf, y);
+}
+
+void life_bits_set_wrap(life_bits_t *g, int wrap)
+{
+	int y, b;
+	uint64_t *p;
+
+	g->wrap = wrap != 0;
+	for (b=0; b<2; b++) {
+		if (g->wrap) {
+			life_bits_wrap(g, b ? g->next : g->cur);
+			continue;
+		}
+		// back to a dead halo
+		p = b ? g->next : g->cur;
+		memset(LIFE_BITS_ROW(g, p, -1) - 1, 0, g->stride * sizeof(uint64_t));
+		memset(LIFE_BITS_ROW(g, p, g->height) - 1, 0, g->stride * sizeof(uint64_t));
+		for (y=0; y<g->height; y++) {
+			LIFE_BITS_ROW(g, p, y)[-1] = 0;
+			LIFE_BITS_ROW(g, p, y)[g->words] = 0;
+		}
+	}
+	// the edge tiles now see different neighbours
+	memset(g->dirty, 1, (size_t)g->tiles_x * g->tiles_y);
+}
+
+/****************************************************************************************
+ * Single cell access, x = column, y = row
+****************************************************************************************/
+void life_bits_set(life_bits_t *g, int x, int y, int alive)
+{
+	uint64_t *word, bit;
+
+	if (x < 0 || y < 0 || x >= g->width || y >= g->height) return;
+	word = LIFE_BITS_ROW(g, g->cur, y) + (x >> 6);
+	bit = 1ULL << (x & 63);
+	if (alive) *word |= bit;
+	else *word &= ~bit;
+	// the spare buffer no longer matches this tile
+	LIFE_BITS_TILE(g, g->dirty, x >> 6, y / LIFE_TILE_ROWS) = 1;
+	if (g->wrap) life_bits_wrap_row(g, g->cur, y);
+}
+
+int life_bits_get(const life_bits_t *g, int x, int y)
+{
+	if (x < 0 || y < 0 || x >= g->width || y >= g->height) return 0;
+	return (LIFE_BITS_ROW(g, g->cur, y)[x >> 6] >> (x & 63)) & 1;
+}
+
+// forced inlining with a constant kernel argument is what turns the
+// functions below into one specialized copy per rule kernel
+#define LIFE_INLINE static inline __attribute__((always_inline))
+
+/****************************************************************************************
+ * Next state of the 64 cells in word p[0] of a row
+ * up, p, dn point at the same word of the row above, the row, and the row below;
+ * p[-1] and p[1] are the neighbouring words (or the zero halo)
+****************************************************************************************/
+LIFE_INLINE uint64_t life_bits_word(const life_bits_t *g, int kernel,
+				    const uint64_t *up, const uint64_t *p,
+				    const uint64_t *dn)
+{
+	// neighbours to the left are one bit lower, to the right one bit higher
+	uint64_t ul = (up[0] << 1) | (up[-1] >> 63), ur = (up[0] >> 1) | (up[1] << 63);
+	uint64_t ml = (p[0] << 1)  | (p[-1] >> 63),  mr = (p[0] >> 1)  | (p[1] << 63);
+	uint64_t dl = (dn[0] << 1) | (dn[-1] >> 63), dr = (dn[0] >> 1) | (dn[1] << 63);
+
+	switch (kernel) {
+	case LIFE_RULE_LIFE:
+		return life_bits_rule(ul, up[0], ur, ml, p[0], mr, dl, dn[0], dr);
+	case LIFE_RULE_HIGHLIFE:
+		return life_bits_rule_bs(ul, up[0], ur, ml, p[0], mr, dl, dn[0], dr,
+					 LIFE_RULE_HIGHLIFE_B, LIFE_RULE_HIGHLIFE_S);
+	case LIFE_RULE_SEEDS:
+		return life_bits_rule_bs(ul, up[0], ur, ml, p[0], mr, dl, dn[0], dr,
+					 LIFE_RULE_SEEDS_B, LIFE_RULE_SEEDS_S);
+	case LIFE_RULE_DAYNIGHT:
+		return life_bits_rule_bs(ul, up[0], ur, ml, p[0], mr, dl, dn[0], dr,
+					 LIFE_RULE_DAYNIGHT_B, LIFE_RULE_DAYNIGHT_S);
+	default:
+		return life_bits_rule_bs(ul, up[0], ur, ml, p[0], mr, dl, dn[0], dr,
+					 g->rule.birth, g->rule.survive);
+	}
+}
+
+/****************************************************************************************
+ * Last word of a toroidal row whose width is not a multiple of 64: its
+ * padding bits are filled with the cells the row wraps around to, so the
+ * last cell sees the first as its right neighbour. the bits past the
+ * padding read as dead, which only affects padding cells
+****************************************************************************************/
+LIFE_INLINE uint64_t life_bits_word_wrap(const life_bits_t *g, int kernel,
+					 const uint64_t *up, const uint64_t *p,
+					 const uint64_t *dn)
+{
+	int last = g->words - 1, pad = g->width & 63;
+	uint64_t u[3], m[3], d[3];
+
+	u[0] = up[last-1];
+	u[1] = up[last] | (up[0] << pad);
+	m[0] = p[last-1];
+	m[1] = p[last] | (p[0] << pad);
+	d[0] = dn[last-1];
+	d[1] = dn[last] | (dn[0] << pad);
+	u[2] = m[2] = d[2] = 0;
+	return life_bits_word(g, kernel, u+1, m+1, d+1);
+}
+
+/****************************************************************************************
+ * Did any tile in the 3x3 block around (tx, ty) change going into cur
+ * on a torus the block wraps around the edges
+****************************************************************************************/
+static int life_bits_near_dirty(const life_bits_t *g, int tx, int ty)
+{
+	int x, y, x0, x1, y0, y1;
+
+	if (g->wrap) {
+		for (y=ty-1; y<=ty+1; y++) {
+			y0 = y < 0 ? y + g->tiles_y : y >= g->tiles_y ? y - g->tiles_y : y;
+			for (x=tx-1; x<=tx+1; x++) {
+				x0 = x < 0 ? x + g->tiles_x : x >= g->tiles_x ? x - g->tiles_x : x;
+				if (LIFE_BITS_TILE(g, g->dirty, x0, y0)) return 1;
+			}
+		}
+		return 0;
+	}
+	x0 = tx > 0 ? tx-1 : 0;
+	x1 = tx < g->tiles_x-1 ? tx+1 : tx;
+	y0 = ty > 0 ? ty-1 : 0;
+	y1 = ty < g->tiles_y-1 ? ty+1 : ty;
+	for (y=y0; y<=y1; y++)
+		for (x=x0; x<=x1; x++)
+			if (LIFE_BITS_TILE(g, g->dirty, x, y)) return 1;
+	return 0;
+}
+
+/****************************************************************************************
+ * Compute tile rows [ty0, ty1) of the next generation
+ * a skipped tile keeps what the spare buffer holds, which is the current
+ * generation again: the tile did not change in the step that made cur
+****************************************************************************************/
+LIFE_INLINE void life_bits_tiles(life_bits_t *g, int ty0, int ty1, int kernel)
+{
+	int tx, ty, y, y1, w, last = g->words - 1;
+	int wrap_last = g->wrap && (g->width & 63);
+	const uint64_t *up, *p, *dn;
+	uint64_t *out, v;
+	uint8_t *act, *chg;
+
+	for (ty=ty0; ty<ty1; ty++) {
+		act = &LIFE_BITS_TILE(g, g->stepped, 0, ty);
+		chg = &LIFE_BITS_TILE(g, g->dirty_next, 0, ty);
+		for (tx=0; tx<g->tiles_x; tx++) {
+			act[tx] = !g->track || life_bits_near_dirty(g, tx, ty);
+			chg[tx] = 0;
+		}
+
+		y1 = (ty+1) * LIFE_TILE_ROWS;
+		if (y1 > g->height) y1 = g->height;
+		for (y=ty*LIFE_TILE_ROWS; y<y1; y++) {
+			out = LIFE_BITS_ROW(g, g->next, y);
+			p  = LIFE_BITS_ROW(g, g->cur, y);
+			up = p - g->stride;
+			dn = p + g->stride;
+			for (w=0; w<g->words; w++) {
+				if (!act[w]) continue;
+				if (w == last && wrap_last)
+					v = life_bits_word_wrap(g, kernel, up, p, dn);
+				else
+					v = life_bits_word(g, kernel, up+w, p+w, dn+w);
+				if (w == last) v &= g->pad_mask;
+				out[w] = v;
+				chg[w] |= v != p[w];
+			}
+		}
+	}
+}
+
+void life_bits_step_tiles(life_bits_t *g, int ty0, int ty1)
+{
+	switch (g->rule.kernel) {
+	case LIFE_RULE_LIFE:
+		life_bits_tiles(g, ty0, ty1, LIFE_RULE_LIFE);
+		break;
+	case LIFE_RULE_HIGHLIFE:
+		life_bits_tiles(g, ty0, ty1, LIFE_RULE_HIGHLIFE);
+		break;
+	case LIFE_RULE_SEEDS:
+		life_bits_tiles(g, ty0, ty1, LIFE_RULE_SEEDS);
+		break;
+	case LIFE_RULE_DAYNIGHT:
+		life_bits_tiles(g, ty0, ty1, LIFE_RULE_DAYNIGHT);
+		break;
+	default:
+		life_bits_tiles(g, ty0, ty1, LIFE_RULE_GENERIC);
+	}
+}
+
+void life_bits_swap(life_bits_t *g)
+{
+	uint64_t *t = g->cur;
+	uint8_t *d = g->dirty;
+	long k, n = (long)g->tiles_x * g->tiles_y;
+
+	g->cur = g->next;
+	g->next = t;
+	g->dirty = g->dirty_next;
+	g->dirty_next = d;
+	if (g->wrap) life_bits_wrap(g, g->cur);
+
+	g->active_tiles = g->changed_tiles = 0;
+	for (k=0; k<n; k++) {
+		g->active_tiles += g->stepped[k];
+		g->changed_tiles += g->dirty[k];
+	}
+}
+
+/****************************************************************************************
+ * After a whole generation was written into next some other way (the
+ * hash and sparse engines render into it): clear the padding bits and
+ * flag the tiles that differ from cur
+****************************************************************************************/
+void life_bits_mark_next(life_bits_t *g)
+{
+	int tx, ty, y, y1;
+	uint64_t *cur, *next, diff;
+
+	for (ty=0; ty<g->tiles_y; ty++) {
+		y1 = (ty+1) * LIFE_TILE_ROWS;
+		if (y1 > g->height) y1 = g->height;
+		for (tx=0; tx<g->tiles_x; tx++) {
+			diff = 0;
+			for (y=ty*LIFE_TILE_ROWS; y<y1; y++) {
+				cur = LIFE_BITS_ROW(g, g->cur, y);
+				next = LIFE_BITS_ROW(g, g->next, y);
+				if (tx == g->words-1) next[tx] &= g->pad_mask;
+				diff |= cur[tx] ^ next[tx];
+			}
+			LIFE_BITS_TILE(g, g->dirty_next, tx, ty) = diff != 0;
+		}
+	}
+}
+
+void life_bits_step(life_bits_t *g)
+{
+	life_bits_step_tiles(g, 0, g->tiles_y);
+	life_bits_swap(g);
+}
+
+long life_bits_population(const life_bits_t *g)
+{
+	long n = 0;
+	int y, w;
+	const uint64_t *p;
+
+	for (y=0; y<g->height; y++) {
+		p = LIFE_BITS_ROW(g, g->cur, y);
+		for (w=0; w<g->words; w++) n += __builtin_popcountll(p[w]);
+	}
+	return n;
+}
@@ -0,0 +1,154 @@
+/* Bit-packed Game of Life engine.
+ *
+ * Cells are stored 64 to a uint64_t, row-major: bit k of word w in row y is
+ * the cell at x = 64*w + k.  Each row carries a zero halo word on either
+ * side and the grid carries a zero halo row above and below, so the step
+ * loop reads its neighbours without any bounds checks and everything outside
+ * the grid counts as dead.
+ *
+ * The grid is also cut into tiles one word (64 cells) wide and
+ * LIFE_TILE_ROWS rows high, each flagged when it changed in the last step.
+ * A tile whose 3x3 tile neighbourhood did not change cannot change either,
+ * and the spare buffer already holds its cells, so the step skips it.
+ *
+ * The rule is B3/S23 unless life_bits_set_rule() picks another Life-like
+ * rule (see life_rule.h).
+ *
+ * life_bits_set_wrap() joins the edges into a torus instead: the halo then
+ * repeats the cells of the opposite edges (refreshed by life_bits_swap()
+ * and life_bits_set()), the step fills the padding bits of the last word
+ * from the start of the row, and the tiles on one edge count the tiles on
+ * the other as neighbours.
+ */
+#ifndef LIFE_BITS_H
+#define LIFE_BITS_H
+
+#include <stdint.h>
+#include "life_rule.h"
+
+typedef struct life_bits {
+	int width, height;      // cells
+	int words;              // data words per row
+	int stride;             // words per row, halo words included
+	uint64_t *cur;          // row 0, word 0 of the current generation
+	uint64_t *next;         // row 0, word 0 of the generation being built
+	uint64_t pad_mask;      // cells of the last word inside the grid
+	uint64_t *mem[2];       // allocations behind cur and next
+
+	int tiles_x, tiles_y;   // tile grid
+	int track;              // skip quiet tiles; 0 steps every tile
+	uint8_t *dirty;         // tiles that changed going into cur
+	uint8_t *dirty_next;    // tiles that change going into next
+	uint8_t *stepped;       // tiles computed by the last step
+	long active_tiles;      // tiles stepped by the last step
+	long changed_tiles;     // tiles that changed in the last step
+	life_rule_t rule;
+	int wrap;               // toroidal, the halo mirrors the far edges
+} life_bits_t;
+
+#define LIFE_TILE_ROWS 32
+
+// pointer to word 0 of row y in buffer buf (cur or next)
+#define LIFE_BITS_ROW(g, buf, y) ((buf) + (long)(y)*(g)->stride)
+// flag of tile (tx, ty) in a tile array (dirty, dirty_next, stepped)
+#define LIFE_BITS_TILE(g, flags, tx, ty) ((flags)[(long)(ty)*(g)->tiles_x + (tx)])
+
+/****************************************************************************************
+ * B3/S23 on 64 cells at once: each argument holds, at every bit, one of the
+ * eight neighbours of that bit's cell (ul = up-left ... dr = down-right),
+ * mc holds the cells themselves
+****************************************************************************************/
+static inline uint64_t life_bits_rule(uint64_t ul, uint64_t uc, uint64_t ur,
+				      uint64_t ml, uint64_t mc, uint64_t mr,
+				      uint64_t dl, uint64_t dc, uint64_t dr)
+{
+	uint64_t u0, u1, m0, m1, d0, d1, s0, k0, t, u;
+
+	// three 2-bit row sums: above and below count 0..3, the middle 0..2
+	u0 = ul ^ uc ^ ur;
+	u1 = (ul & uc) | (ur & (ul ^ uc));
+	m0 = ml ^ mr;
+	m1 = ml & mr;
+	d0 = dl ^ dc ^ dr;
+	d1 = (dl & dc) | (dr & (dl ^ dc));
+
+	// ones column of the total, and its carry into the twos column
+	s0 = u0 ^ m0 ^ d0;
+	k0 = (u0 & m0) | (d0 & (u0 ^ m0));
+
+	// sum is 2 or 3 exactly when one of the four twos-column
+	// inputs is set: none gives 0..1, two or more gives 4..9
+	t = u1 ^ m1;
+	u = d1 ^ k0;
+	t = (t ^ u) & ~((u1 & m1) | (d1 & k0));
+
+	// sum == 3 -> born/survive, sum == 2 -> keep current state
+	return t & (s0 | mc);
+}
+
+/****************************************************************************************
+ * Any B/S rule on 64 cells at once, same arguments as life_bits_rule
+ * the neighbour count is built as four bit planes, then every count in the
+ * rule adds the cells that have it. inlined with constant masks the unused
+ * counts fold away, which is how the specialized kernels are made; with
+ * masks only known at run time this is the generic kernel
+****************************************************************************************/
+static inline uint64_t life_bits_rule_bs(uint64_t ul, uint64_t uc, uint64_t ur,
+					 uint64_t ml, uint64_t mc, uint64_t mr,
+					 uint64_t dl, uint64_t dc, uint64_t dr,
+					 unsigned birth, unsigned survive)
+{
+	uint64_t u0, u1, m0, m1, d0, d1, k0, p0, q0, n[4], eq, out = 0;
+	int c;
+
+	u0 = ul ^ uc ^ ur;
+	u1 = (ul & uc) | (ur & (ul ^ uc));
+	m0 = ml ^ mr;
+	m1 = ml & mr;
+	d0 = dl ^ dc ^ dr;
+	d1 = (dl & dc) | (dr & (dl ^ dc));
+
+	// count = n0 + 2 n1 + 4 n2 + 8 n3: the ones column, then the four
+	// twos-column inputs u1, m1, d1 and the carry k0 added up
+	n[0] = u0 ^ m0 ^ d0;
+	k0 = (u0 & m0) | (d0 & (u0 ^ m0));
+	p0 = u1 ^ m1;
+	q0 = d1 ^ k0;
+	n[1] = p0 ^ q0;
+	n[2] = (u1 & m1) ^ (d1 & k0) ^ (p0 & q0);
+	n[3] = u1 & m1 & d1 & k0;
+
+#if defined(__GNUC__) && __GNUC__ >= 8
+#pragma GCC unroll 9
+#endif
+	for (c=0; c<9; c++) {
+		if (!(((birth | survive) >> c) & 1)) continue;
+		eq = ((c & 1) ? n[0] : ~n[0]) & ((c & 2) ? n[1] : ~n[1]) &
+		     ((c & 4) ? n[2] : ~n[2]) & ((c & 8) ? n[3] : ~n[3]);
+		out |= eq & ((((birth >> c) & 1) ? ~mc : 0) | (((survive >> c) & 1) ? mc : 0));
+	}
+	return out;
+}
+
+int  life_bits_init(life_bits_t *g, int width, int height);
+void life_bits_free(life_bits_t *g);
+void life_bits_clear(life_bits_t *g);
+// switch rules; every tile is stepped on the next step
+void life_bits_set_rule(life_bits_t *g, const life_rule_t *rule);
+// 1: toroidal, 0: everything outside the grid is dead (the default)
+void life_bits_set_wrap(life_bits_t *g, int wrap);
+
+void life_bits_set(life_bits_t *g, int x, int y, int alive);
+int  life_bits_get(const life_bits_t *g, int x, int y);
+
+// compute tile rows [ty0, ty1) of next from cur
+void life_bits_step_tiles(life_bits_t *g, int ty0, int ty1);
+// make next the current generation and count the tiles
+void life_bits_swap(life_bits_t *g);
+void life_bits_step(life_bits_t *g);
+// next was filled in by hand: clear its padding, flag the tiles that differ
+void life_bits_mark_next(life_bits_t *g);
+
+long life_bits_population(const life_bits_t *g);
+
+#endif
@@ -0,0 +1,423 @@
+///////////////////////////////////////
+/// Byte-per-cell Game of Life engine,
+/// row-major with a dead or toroidal halo, with scalar, SSE2/AVX2 and NEON
+/// line kernels, picked at run time,
+/// and a lookup-table kernel for any rule
+/// for NEON on the A9 compile with
+/// -mfpu=neon
+///////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "life_byte.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#include <immintrin.h>
+#define LIFE_HAVE_SSE2 1
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define LIFE_HAVE_AVX2 1
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LIFE_HAVE_NEON 1
+#if defined(__arm__)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+#endif
+
+static const char *kernel_names[LIFE_KERNEL_COUNT] = {
+	"scalar", "sse2", "avx2", "neon"
+};
+
+/****************************************************************************************
+ * Scalar kernel: the original neighbour sum, one byte at a time
+****************************************************************************************/
+static void life_line_scalar(const uint8_t *up, const uint8_t *p,
+			     const uint8_t *dn, uint8_t *out, int n)
+{
+	int j, sum;
+
+	for (j=0; j<n; j++) {
+		sum = up[j-1] + up[j] + up[j+1] +
+		      p[j-1]          + p[j+1] +
+		      dn[j-1] + dn[j] + dn[j+1] ;
+		if (sum == 3) out[j] = 1;
+		else if (sum == 2) out[j] = p[j];
+		else out[j] = 0;
+	}
+}
+
+/****************************************************************************************
+ * Lookup-table kernel: any B/S rule, next state indexed by cell and sum
+****************************************************************************************/
+static void life_line_lut(const uint8_t lut[2][9], const uint8_t *up,
+			  const uint8_t *p, const uint8_t *dn, uint8_t *out, int n)
+{
+	int j, sum;
+
+	for (j=0; j<n; j++) {
+		sum = up[j-1] + up[j] + up[j+1] +
+		      p[j-1]          + p[j+1] +
+		      dn[j-1] + dn[j] + dn[j+1] ;
+		out[j] = lut[p[j]][sum];
+	}
+}
+
+// Every vector kernel uses the same identity: with sum in 0..8 and the cell
+// 0 or 1, (sum | cell) == 3 holds exactly for sum == 3, or sum == 2 with the
+// cell alive.  Rows shorter than one vector fall back to the scalar kernel;
+// otherwise the last vector is aligned to the end of the row and overlaps
+// the one before it, which is harmless since out never aliases the inputs.
+
+#ifdef LIFE_HAVE_SSE2
+/****************************************************************************************
+ * SSE2 kernel: 16 cells per instruction
+****************************************************************************************/
+static inline void life_vec_sse2(const uint8_t *up, const uint8_t *p,
+				 const uint8_t *dn, uint8_t *out)
+{
+	__m128i sum, t;
+
+	sum = _mm_add_epi8(_mm_loadu_si128((const __m128i *)(up-1)),
+			   _mm_loadu_si128((const __m128i *)(up)));
+	sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *)(up+1)));
+	sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *)(p-1)));
+	sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *)(p+1)));
+	sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *)(dn-1)));
+	sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *)(dn)));
+	sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *)(dn+1)));
+	t = _mm_or_si128(sum, _mm_loadu_si128((const __m128i *)p));
+	t = _mm_cmpeq_epi8(t, _mm_set1_epi8(3));
+	_mm_storeu_si128((__m128i *)out, _mm_and_si128(t, _mm_set1_epi8(1)));
+}
+
+static void life_line_sse2(const uint8_t *up, const uint8_t *p,
+			   const uint8_t *dn, uint8_t *out, int n)
+{
+	int j;
+
+	if (n < 16) {
+		life_line_scalar(up, p, dn, out, n);
+		return;
+	}
+	for (j=0; j+16<=n; j+=16)
+		life_vec_sse2(up+j, p+j, dn+j, out+j);
+	if (j < n) {
+		j = n - 16;
+		life_vec_sse2(up+j, p+j, dn+j, out+j);
+	}
+}
+#endif
+
+#ifdef LIFE_HAVE_AVX2
+/****************************************************************************************
+ * AVX2 kernel: 32 cells per instruction, built for the host CPU at run time
+****************************************************************************************/
+__attribute__((target("avx2")))
+static inline void life_vec_avx2(const uint8_t *up, const uint8_t *p,
+				 const uint8_t *dn, uint8_t *out)
+{
+	__m256i sum, t;
+
+	sum = _mm256_add_epi8(_mm256_loadu_si256((const __m256i *)(up-1)),
+			      _mm256_loadu_si256((const __m256i *)(up)));
+	sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(up+1)));
+	sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(p-1)));
+	sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(p+1)));
+	sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(dn-1)));
+	sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(dn)));
+	sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(dn+1)));
+	t = _mm256_or_si256(sum, _mm256_loadu_si256((const __m256i *)p));
+	t = _mm256_cmpeq_epi8(t, _mm256_set1_epi8(3));
+	_mm256_storeu_si256((__m256i *)out, _mm256_and_si256(t, _mm256_set1_epi8(1)));
+}
+
+__attribute__((target("avx2")))
+static void life_line_avx2(const uint8_t *up, const uint8_t *p,
+			   const uint8_t *dn, uint8_t *out, int n)
+{
+	int j;
+
+	if (n < 32) {
+		life_line_sse2(up, p, dn, out, n);
+		return;
+	}
+	for (j=0; j+32<=n; j+=32)
+		life_vec_avx2(up+j, p+j, dn+j, out+j);
+	if (j < n) {
+		j = n - 32;
+		life_vec_avx2(up+j, p+j, dn+j, out+j);
+	}
+}
+#endif
+
+#ifdef LIFE_HAVE_NEON
+/****************************************************************************************
+ * NEON kernel: 16 cells per instruction
+****************************************************************************************/
+static inline void life_vec_neon(const uint8_t *up, const uint8_t *p,
+				 const uint8_t *dn, uint8_t *out)
+{
+	uint8x16_t sum, t;
+
+	sum = vaddq_u8(vld1q_u8(up-1), vld1q_u8(up));
+	sum = vaddq_u8(sum, vld1q_u8(up+1));
+	sum = vaddq_u8(sum, vld1q_u8(p-1));
+	sum = vaddq_u8(sum, vld1q_u8(p+1));
+	sum = vaddq_u8(sum, vld1q_u8(dn-1));
+	sum = vaddq_u8(sum, vld1q_u8(dn));
+	sum = vaddq_u8(sum, vld1q_u8(dn+1));
+	t = vceqq_u8(vorrq_u8(sum, vld1q_u8(p)), vdupq_n_u8(3));
+	vst1q_u8(out, vandq_u8(t, vdupq_n_u8(1)));
+}
+
+static void life_line_neon(const uint8_t *up, const uint8_t *p,
+			   const uint8_t *dn, uint8_t *out, int n)
+{
+	int j;
+
+	if (n < 16) {
+		life_line_scalar(up, p, dn, out, n);
+		return;
+	}
+	for (j=0; j+16<=n; j+=16)
+		life_vec_neon(up+j, p+j, dn+j, out+j);
+	if (j < n) {
+		j = n - 16;
+		life_vec_neon(up+j, p+j, dn+j, out+j);
+	}
+}
+#endif
+
+/****************************************************************************************
+ * Kernel dispatch
+****************************************************************************************/
+int life_byte_kernel_available(int kernel)
+{
+	switch (kernel) {
+	case LIFE_KERNEL_SCALAR:
+		return 1;
+#ifdef LIFE_HAVE_SSE2
+	case LIFE_KERNEL_SSE2:
+		return 1;
+#endif
+#ifdef LIFE_HAVE_AVX2
+	case LIFE_KERNEL_AVX2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+#ifdef LIFE_HAVE_NEON
+	case LIFE_KERNEL_NEON:
+#if defined(__arm__)
+		return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#else
+		return 1;
+#endif
+#endif
+	default:
+		return 0;
+	}
+}
+
+int life_byte_kernel_best(void)
+{
+	int k;
+	for (k=LIFE_KERNEL_COUNT-1; k>LIFE_KERNEL_SCALAR; k--)
+		if (life_byte_kernel_available(k)) return k;
+	return LIFE_KERNEL_SCALAR;
+}
+
+int life_byte_kernel_lookup(const char *name)
+{
+	int k;
+	if (strcmp(name, "auto") == 0) return LIFE_KERNEL_AUTO;
+	for (k=0; k<LIFE_KERNEL_COUNT; k++)
+		if (strcmp(name, kernel_names[k]) == 0) return k;
+	return -2;
+}
+
+const char *life_byte_kernel_name(int kernel)
+{
+	if (kernel < 0 || kernel >= LIFE_KERNEL_COUNT) return "?";
+	return kernel_names[kernel];
+}
+
+life_line_fn life_byte_kernel_fn(int kernel)
+{
+	if (!life_byte_kernel_available(kernel)) return NULL;
+	switch (kernel) {
+#ifdef LIFE_HAVE_SSE2
+	case LIFE_KERNEL_SSE2: return life_line_sse2;
+#endif
+#ifdef LIFE_HAVE_AVX2
+	case LIFE_KERNEL_AVX2: return life_line_avx2;
+#endif
+#ifdef LIFE_HAVE_NEON
+	case LIFE_KERNEL_NEON: return life_line_neon;
+#endif
+	default: return life_line_scalar;
+	}
+}
+
+/****************************************************************************************
+ * Allocate a width x height grid with every cell dead, stepped by the given
+ * kernel (LIFE_KERNEL_AUTO for the fastest one this CPU has)
+****************************************************************************************/
+int life_byte_init(life_byte_t *g, int width, int height, int kernel)
+{
+	size_t size;
+	int b;
+
+	memset(g, 0, sizeof(*g));
+	if (width < 1 || height < 1) return -1;
+	if (kernel == LIFE_KERNEL_AUTO) kernel = life_byte_kernel_best();
+	if ((g->line = life_byte_kernel_fn(kernel)) == NULL) return -1;
+
+	g->width = width;
+	g->height = height;
+	g->kernel = kernel;
+	// left pad, cells, at least one byte of right halo, then round
+	// up so every row starts 16-byte aligned
+	g->stride = (LIFE_BYTE_PAD + width + 1 + 15) & ~15;
+
+	// halo row above and below. the step never writes the halo,
+	// so it stays dead in both buffers
+	size = (size_t)(height + 2) * g->stride;
+	for (b=0; b<2; b++) {
+		if (posix_memalign((void **)&g->mem[b], 16, size) != 0) {
+			g->mem[b] = NULL;
+			life_byte_free(g);
+			return -1;
+		}
+		memset(g->mem[b], 0, size);
+	}
+	g->cur  = g->mem[0] + g->stride + LIFE_BYTE_PAD;
+	g->next = g->mem[1] + g->stride + LIFE_BYTE_PAD;
+	life_rule_make(&g->rule, LIFE_RULE_LIFE_B, LIFE_RULE_LIFE_S);
+	life_byte_set_rule(g, &g->rule);
+	return 0;
+}
+
+void life_byte_set_rule(life_byte_t *g, const life_rule_t *rule)
+{
+	int n;
+
+	g->rule = *rule;
+	for (n=0; n<9; n++) {
+		g->lut[0][n] = (rule->birth >> n) & 1;
+		g->lut[1][n] = (rule->survive >> n) & 1;
+	}
+}
+
+/****************************************************************************************
+ * Toroidal halo of row y of buffer buf: the halo bytes repeat the cells at
+ * the other end of the row, the halo rows the last and first rows
+****************************************************************************************/
+static void life_byte_wrap_row(life_byte_t *g, uint8_t *buf, int y)
+{
+	uint8_t *p = LIFE_BYTE_ROW(g, buf, y);
+
+	p[-1] = p[g->width-1];
+	p[g->width] = p[0];
+	if (y == 0) memcpy(LIFE_BYTE_ROW(g, buf, g->height) - 1, p - 1, g->width + 2);
+	if (y == g->height - 1) memcpy(LIFE_BYTE_ROW(g, buf, -1) - 1, p - 1, g->width + 2);
+}
+
+static void life_byte_wrap(life_byte_t *g, uint8_t *buf)
+{
+	int y;
+
+	for (y=0; y<g->height; y++) life_byte_wrap_row(g, buf, y);
+}
+
+void life_byte_set_wrap(life_byte_t *g, int wrap)
+{
+	int y, b;
+	uint8_t *p;
+
+	g->wrap = wrap != 0;
+	for (b=0; b<2; b++) {
+		p = b ? g->next : g->cur;
+		if (g->wrap) {
+			life_byte_wrap(g, p);
+			continue;
+		}
+		memset(LIFE_BYTE_ROW(g, p, -1) - 1, 0, g->width + 2);
+		memset(LIFE_BYTE_ROW(g, p, g->height) - 1, 0, g->width + 2);
+		for (y=0; y<g->height; y++) {
+			LIFE_BYTE_ROW(g, p, y)[-1] = 0;
+			LIFE_BYTE_ROW(g, p, y)[g->width] = 0;
+		}
+	}
+}
+
+void life_byte_free(life_byte_t *g)
+{
+	free(g->mem[0]);
+	free(g->mem[1]);
+	memset(g, 0, sizeof(*g));
+}
+
+void life_byte_set(life_byte_t *g, int x, int y, int alive)
+{
+	if (x < 0 || y < 0 || x >= g->width || y >= g->height) return;
+	LIFE_BYTE_ROW(g, g->cur, y)[x] = alive != 0;
+	if (g->wrap) life_byte_wrap_row(g, g->cur, y);
+}
+
+int life_byte_get(const life_byte_t *g, int x, int y)
+{
+	if (x < 0 || y < 0 || x >= g->width || y >= g->height) return 0;
+	return LIFE_BYTE_ROW(g, g->cur, y)[x];
+}
+
+/****************************************************************************************
+ * Compute rows [y0, y1) of the next generation
+****************************************************************************************/
+void life_byte_step_rows(life_byte_t *g, int y0, int y1)
+{
+	int y;
+	const uint8_t *p;
+
+	for (y=y0; y<y1; y++) {
+		p = LIFE_BYTE_ROW(g, g->cur, y);
+		if (g->rule.kernel == LIFE_RULE_LIFE)
+			g->line(p - g->stride, p, p + g->stride,
+				LIFE_BYTE_ROW(g, g->next, y), g->width);
+		else
+			life_line_lut((const uint8_t (*)[9])g->lut, p - g->stride, p,
+				      p + g->stride, LIFE_BYTE_ROW(g, g->next, y), g->width);
+	}
+}
+
+void life_byte_swap(life_byte_t *g)
+{
+	uint8_t *t = g->cur;
+	g->cur = g->next;
+	g->next = t;
+	if (g->wrap) life_byte_wrap(g, g->cur);
+}
+
+void life_byte_step(life_byte_t *g)
+{
+	life_byte_step_rows(g, 0, g->height);
+	life_byte_swap(g);
+}
+
+long life_byte_population(const life_byte_t *g)
+{
+	long n = 0;
+	int x, y;
+	const uint8_t *p;
+
+	for (y=0; y<g->height; y++) {
+		p = LIFE_BYTE_ROW(g, g->cur, y);
+		for (x=0; x<g->width; x++) n += p[x];
+	}
+	return n;
+}
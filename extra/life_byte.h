@@ -0,0 +1,80 @@
+/* Byte-per-cell Game of Life engine.
+ *
+ * One char per cell, as in the original life[640][480] arrays, but stored
+ * row-major like the VGA pixel buffer: cell (x, y) is row y, byte x.  Every
+ * row is padded with dead halo bytes on both sides and the grid has a dead
+ * halo row above and below, so the step reads neighbours without any edge
+ * tests and everything outside the grid counts as dead.  Each row is stepped
+ * with the sum == 3 / sum == 2 rule by a kernel picked at run time: plain C,
+ * SSE2 or AVX2 on x86 hosts, NEON on the A9.  Every kernel produces exactly
+ * the generations of the scalar one.  Rules other than B3/S23 (see
+ * life_rule.h) are stepped by a scalar lookup table on the neighbour sum.
+ *
+ * life_byte_set_wrap() makes the grid a torus: the halo bytes and rows then
+ * repeat the opposite edges, refreshed by life_byte_swap() and
+ * life_byte_set(), so the kernels are the same either way.
+ */
+#ifndef LIFE_BYTE_H
+#define LIFE_BYTE_H
+
+#include <stdint.h>
+#include "life_rule.h"
+
+enum {
+	LIFE_KERNEL_AUTO = -1,
+	LIFE_KERNEL_SCALAR = 0,
+	LIFE_KERNEL_SSE2,
+	LIFE_KERNEL_AVX2,
+	LIFE_KERNEL_NEON,
+	LIFE_KERNEL_COUNT
+};
+
+// next state of cells p[0..n-1] given the rows above and below;
+// p[-1], p[n] (and the same of up and dn) must be readable
+typedef void (*life_line_fn)(const uint8_t *up, const uint8_t *p,
+			     const uint8_t *dn, uint8_t *out, int n);
+
+typedef struct life_byte {
+	int width, height;      // cells
+	int stride;             // bytes per row, halo included
+	uint8_t *cur;           // row 0, cell 0 of the current generation
+	uint8_t *next;          // same, for the generation being built
+	uint8_t *mem[2];        // allocations behind cur and next
+	int kernel;             // LIFE_KERNEL_*
+	life_line_fn line;
+	life_rule_t rule;
+	uint8_t lut[2][9];      // next state by current state and sum
+	int wrap;               // toroidal, the halo mirrors the far edges
+} life_byte_t;
+
+// halo bytes left of each row; keeps cell 0 of every row 16-byte aligned
+#define LIFE_BYTE_PAD 16
+
+// pointer to cell 0 of row y in buffer buf (cur or next)
+#define LIFE_BYTE_ROW(g, buf, y) ((buf) + (long)(y)*(g)->stride)
+
+int  life_byte_init(life_byte_t *g, int width, int height, int kernel);
+void life_byte_free(life_byte_t *g);
+void life_byte_set_rule(life_byte_t *g, const life_rule_t *rule);
+// 1: toroidal, 0: everything outside the grid is dead (the default)
+void life_byte_set_wrap(life_byte_t *g, int wrap);
+
+void life_byte_set(life_byte_t *g, int x, int y, int alive);
+int  life_byte_get(const life_byte_t *g, int x, int y);
+
+// compute rows [y0, y1) of next from cur
+void life_byte_step_rows(life_byte_t *g, int y0, int y1);
+// make next the current generation
+void life_byte_swap(life_byte_t *g);
+void life_byte_step(life_byte_t *g);
+
+long life_byte_population(const life_byte_t *g);
+
+// kernel selection
+int  life_byte_kernel_available(int kernel);
+int  life_byte_kernel_best(void);
+int  life_byte_kernel_lookup(const char *name);
+const char *life_byte_kernel_name(int kernel);
+life_line_fn life_byte_kernel_fn(int kernel);
+
+#endif
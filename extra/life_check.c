@@ -0,0 +1,1295 @@
+///////////////////////////////////////
+/// Self-check of life_video_2, -c
+/// compiled in with it, see the compile
+/// line in life_video_2.c
+///////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <assert.h>
+#include "life_bits.h"
+#include "life_byte.h"
+#include "life_pool.h"
+#include "life_hash.h"
+#include "life_sparse.h"
+#include "life_rule.h"
+#include "life_pattern.h"
+#include "life_view.h"
+#include "life_triple.h"
+#include "life_snap.h"
+#include "life_cycle.h"
+#include "life_queue.h"
+#include "vga_span.h"
+#include "vga_fill.h"
+#include "vga_hud.h"
+#include "vga_raster.h"
+#include "life_check.h"
+
+int self_check(int, int, int);
+int self_check_run(int, int, int, int);
+int self_check_rules(int);
+int self_check_wrap(int, int);
+int self_check_sparse(int);
+int self_check_view(void);
+int self_check_triple(void);
+int self_check_cycle(int);
+int self_check_queue(void);
+int self_check_fill(void);
+int self_check_hud(void);
+int self_check_raster(void);
+int self_check_pattern(void);
+int self_check_snap(void);
+
+// the original loop's universe: its 640x480 array, less the outer
+// ring it held dead, as the engines see it
+#define LIFE_X0 1
+#define LIFE_Y0 1
+#define LIFE_W  638
+#define LIFE_H  478
+
+int life_check(int kernel, int threads){
+	return self_check(200, kernel, threads) || self_check_rules(100) ||
+	       self_check_wrap(100, threads) || self_check_sparse(100) || self_check_view() ||
+	       self_check_triple() || self_check_cycle(kernel) || self_check_queue() ||
+	       self_check_fill() || self_check_hud() || self_check_raster() ||
+	       self_check_pattern() || self_check_snap();
+}
+
+//////////////////////////////////////////////////////////
+// the engines as the patterns, the pool and the clock see them
+//////////////////////////////////////////////////////////
+static void bits_set(void *g, int x, int y, int alive){
+	life_bits_set((life_bits_t *)g, x, y, alive);
+}
+
+static int bits_get(void *g, int x, int y){
+	return life_bits_get((life_bits_t *)g, x, y);
+}
+
+static void sparse_set(void *s, int x, int y, int alive){
+	life_sparse_set((life_sparse_t *)s, x, y, alive);
+}
+
+static void step_bits_band(void *g, int lo, int hi){
+	life_bits_step_tiles((life_bits_t *)g, lo, hi);
+}
+
+static void step_byte_band(void *g, int lo, int hi){
+	life_byte_step_rows((life_byte_t *)g, lo, hi);
+}
+
+static int wrap_coord(int v, int n){
+	v %= n;
+	return v < 0 ? v + n : v;
+}
+
+static uint64_t now_ns(void){
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+//////////////////////////////////////////////////////////
+// self check
+//////////////////////////////////////////////////////////
+// steps a 50% random soup, then the four glider guns, with the
+// original 640x480 byte loop and asserts that every byte kernel,
+// and the bit-packed engine with and without tile skipping,
+// produce identical generations, the latter two also when split
+// across the -t stepping threads. the glider guns stay clear of the
+// dead border for that long, so the unbounded hash engine is checked
+// on them too, one generation at a time and in a single jump.
+// needs no hardware.
+char orig[640][480], orig_new[640][480] ;
+
+int self_check(int gens, int kernel, int threads){
+	return self_check_run(gens, 0, kernel, threads) || self_check_run(gens, 1, kernel, threads);
+}
+
+int self_check_run(int gens, int guns, int kernel, int threads){
+	life_byte_t vec[LIFE_KERNEL_COUNT], par;
+	life_bits_t bits, bits_par, bits_full, view;
+	life_hash_t hash, hash_jump;
+	life_sparse_t sparse;
+	life_pool_t pool;
+	int k, g, x, y, v, err, sum;
+	long active = 0;
+
+	// seed the reference array
+	memset(orig, 0, sizeof(orig));
+	if (guns) {
+		if (life_bits_init(&view, LIFE_W, LIFE_H) != 0) return 1;
+		life_pattern_four_guns(bits_set, &view, LIFE_W, LIFE_H);
+		for (x=1; x<639; x++)
+			for (y=1; y<479; y++)
+				orig[x][y] = life_bits_get(&view, x-LIFE_X0, y-LIFE_Y0);
+		life_bits_free(&view);
+	}
+	else {
+		srand(5760);
+		for (x=1; x<639; x++)
+			for (y=1; y<479; y++)
+				orig[x][y] = rand() & 1;
+	}
+
+	err = life_bits_init(&bits, LIFE_W, LIFE_H);
+	err |= life_bits_init(&bits_par, LIFE_W, LIFE_H);
+	err |= life_bits_init(&bits_full, LIFE_W, LIFE_H);
+	err |= life_byte_init(&par, LIFE_W, LIFE_H, kernel);
+	err |= life_pool_init(&pool, threads);
+	err |= life_bits_init(&view, LIFE_W, LIFE_H);
+	err |= life_hash_init(&hash, 1 << 18);
+	err |= life_hash_init(&hash_jump, 1 << 18);
+	err |= life_sparse_init(&sparse);
+	for (k=0; k<LIFE_KERNEL_COUNT; k++) {
+		vec[k].cur = NULL;
+		if (life_byte_kernel_available(k))
+			err |= life_byte_init(&vec[k], LIFE_W, LIFE_H, k);
+	}
+	assert(err == 0);
+	bits_full.track = 0;
+	for (x=1; x<639; x++) {
+		for (y=1; y<479; y++) {
+			v = orig[x][y];
+			life_bits_set(&view, x-LIFE_X0, y-LIFE_Y0, v);
+			life_bits_set(&bits, x-LIFE_X0, y-LIFE_Y0, v);
+			life_bits_set(&bits_full, x-LIFE_X0, y-LIFE_Y0, v);
+			life_bits_set(&bits_par, x-LIFE_X0, y-LIFE_Y0, v);
+			life_byte_set(&par, x-LIFE_X0, y-LIFE_Y0, v);
+			for (k=0; k<LIFE_KERNEL_COUNT; k++)
+				if (vec[k].cur) life_byte_set(&vec[k], x-LIFE_X0, y-LIFE_Y0, v);
+		}
+	}
+	if (guns) {
+		err = life_hash_load_bits(&hash, &view, LIFE_X0, LIFE_Y0);
+		err |= life_hash_load_bits(&hash_jump, &view, LIFE_X0, LIFE_Y0);
+		err |= life_hash_advance(&hash_jump, gens);
+		err |= life_sparse_load_bits(&sparse, &view, 0, 0);
+		assert(err == 0);
+	}
+	for (g=0; g<gens; g++) {
+		//leave the edges at zero for all time
+		for (x=1; x<639; x++) {
+			for (y=1; y<479; y++) {
+				sum = orig[x-1][y-1] + orig[x][y-1] + orig[x+1][y-1] +
+				      orig[x-1][y]                  + orig[x+1][y] +
+				      orig[x-1][y+1] + orig[x][y+1] + orig[x+1][y+1] ;
+				if (sum == 3) orig_new[x][y] = 1;
+				else if (sum == 2) orig_new[x][y] = orig[x][y];
+				else orig_new[x][y] = 0;
+			}
+		}
+		memcpy(orig, orig_new, sizeof(orig));
+
+		life_bits_step(&bits);
+		life_bits_step(&bits_full);
+		active += bits.active_tiles;
+		for (k=0; k<LIFE_KERNEL_COUNT; k++)
+			if (vec[k].cur) life_byte_step(&vec[k]);
+		life_pool_run(&pool, step_bits_band, &bits_par, bits_par.tiles_y);
+		life_bits_swap(&bits_par);
+		life_pool_run(&pool, step_byte_band, &par, par.height);
+		life_byte_swap(&par);
+		if (guns) {
+			assert(life_hash_step_pow2(&hash, 0) == 0);
+			life_hash_render(&hash, &view, LIFE_X0, LIFE_Y0);
+			life_bits_swap(&view);
+			assert(life_sparse_step(&sparse) == 0);
+		}
+
+		for (x=1; x<639; x++) {
+			for (y=1; y<479; y++) {
+				v = orig[x][y];
+				assert(life_bits_get(&bits, x-LIFE_X0, y-LIFE_Y0) == v);
+				assert(life_bits_get(&bits_full, x-LIFE_X0, y-LIFE_Y0) == v);
+				assert(life_bits_get(&bits_par, x-LIFE_X0, y-LIFE_Y0) == v);
+				assert(life_byte_get(&par, x-LIFE_X0, y-LIFE_Y0) == v);
+				if (guns) {
+					assert(life_bits_get(&view, x-LIFE_X0, y-LIFE_Y0) == v);
+					assert(life_sparse_get(&sparse, x-LIFE_X0, y-LIFE_Y0) == v);
+				}
+				for (k=0; k<LIFE_KERNEL_COUNT; k++)
+					if (vec[k].cur)
+						assert(life_byte_get(&vec[k], x-LIFE_X0, y-LIFE_Y0) == v);
+			}
+		}
+	}
+	printf("%s:\n", guns ? "glider guns" : "random soup");
+	for (k=0; k<LIFE_KERNEL_COUNT; k++) {
+		if (vec[k].cur == NULL) continue;
+		printf("%-6s ok\n", life_byte_kernel_name(k));
+		life_byte_free(&vec[k]);
+	}
+	printf("bits   ok, %.1f of %d tiles active per generation\n",
+	       (double)active / gens, bits.tiles_x * bits.tiles_y);
+	if (guns) {
+		life_hash_render(&hash_jump, &view, LIFE_X0, LIFE_Y0);
+		life_bits_swap(&view);
+		for (x=1; x<639; x++)
+			for (y=1; y<479; y++)
+				assert(life_bits_get(&view, x-LIFE_X0, y-LIFE_Y0) == orig[x][y]);
+		printf("hash   ok, %u nodes, %ld collections\n", hash.used, hash.gc_runs);
+		printf("sparse ok, %u chunks\n", sparse.used);
+	}
+	printf("%d threads ok\n%d generations, population %ld\n",
+	       pool.threads, gens, life_bits_population(&bits));
+	life_byte_free(&par);
+	life_bits_free(&bits);
+	life_bits_free(&bits_full);
+	life_bits_free(&bits_par);
+	life_bits_free(&view);
+	life_hash_free(&hash);
+	life_hash_free(&hash_jump);
+	life_sparse_free(&sparse);
+	life_pool_free(&pool);
+	return 0;
+}
+
+// a soup in the middle of a 1024x1024 bits grid, far enough from its
+// dead edges that they play no part, against the sparse engine with
+// the grid placed across the origin so that chunk coordinates go
+// negative, under Life and under a generic rule; then the soup is
+// cleared and every chunk has to go back to the pool. Last a burst of
+// lone cells, one a chunk, that die at once around a block: the pool
+// has to fall back to its smallest with the block still found in it
+int self_check_sparse(int gens){
+	life_bits_t bits, view;
+	life_sparse_t sparse;
+	life_rule_t r;
+	int p, g, x, y, err;
+	long chunks = 0;
+	uint32_t peak;
+
+	for (p=0; p<3; p+=2) {
+		life_rule_preset(&r, p);
+		err = life_bits_init(&bits, 1024, 1024);
+		err |= life_bits_init(&view, 1024, 1024);
+		err |= life_sparse_init(&sparse);
+		assert(err == 0);
+		life_bits_set_rule(&bits, &r);
+		life_sparse_set_rule(&sparse, &r);
+		srand(5760 + p);
+		for (y=384; y<640; y++)
+			for (x=384; x<640; x++)
+				life_bits_set(&bits, x, y, (rand() & 3) == 0);
+		assert(life_sparse_load_bits(&sparse, &bits, -500, -520) == 0);
+		for (g=0; g<gens; g++) {
+			life_bits_step(&bits);
+			assert(life_sparse_step(&sparse) == 0);
+			chunks += sparse.used;
+			life_sparse_render(&sparse, &view, -500, -520);
+			life_bits_swap(&view);
+			for (y=0; y<1024; y++)
+				assert(memcmp(LIFE_BITS_ROW(&bits, bits.cur, y), LIFE_BITS_ROW(&view, view.cur, y),
+					      bits.words * sizeof(uint64_t)) == 0);
+		}
+		assert(life_sparse_population(&sparse) == life_bits_population(&bits));
+		printf("sparse %-8s ok, %.1f chunks per generation, population %ld\n",
+		       life_rule_preset_name(p), (double)chunks / gens, life_sparse_population(&sparse));
+		for (y=-600; y<600; y++)
+			for (x=-600; x<600; x++)
+				life_sparse_set(&sparse, x, y, 0);
+		assert(life_sparse_step(&sparse) == 0 && sparse.used == 0);
+		life_bits_free(&bits);
+		life_bits_free(&view);
+		life_sparse_free(&sparse);
+		chunks = 0;
+	}
+
+	assert(life_sparse_init(&sparse) == 0);
+	for (y=-20; y<20; y++)
+		for (x=-20; x<20; x++)
+			assert(life_sparse_set(&sparse, x * LIFE_CHUNK + 30, y * LIFE_CHUNK + 30, 1) == 0);
+	for (y=0; y<2; y++)
+		for (x=0; x<2; x++)
+			assert(life_sparse_set(&sparse, 17 * LIFE_CHUNK + 10 + x, -5 * LIFE_CHUNK + 10 + y, 1) == 0);
+	peak = sparse.cap;
+	assert(peak >= 1600 && life_sparse_step(&sparse) == 0);
+	assert(sparse.used == 1 && sparse.cap < peak && life_sparse_population(&sparse) == 4);
+	for (y=0; y<2; y++)
+		for (x=0; x<2; x++)
+			assert(life_sparse_get(&sparse, 17 * LIFE_CHUNK + 10 + x, -5 * LIFE_CHUNK + 10 + y));
+	assert(life_sparse_step(&sparse) == 0 && life_sparse_population(&sparse) == 4);
+	printf("sparse burst    ok, pool %u chunks at the peak, %u after\n", peak, sparse.cap);
+	life_sparse_free(&sparse);
+	return 0;
+}
+
+// every preset rule on a random soup: the bits engine with the rule's
+// own kernel and with the generic one, and the byte lookup table,
+// against the original loop with the sum tests swapped for the rule
+int self_check_rules(int gens){
+	life_bits_t bits, bits_gen;
+	life_byte_t lut;
+	life_rule_t r, gen;
+	int p, g, x, y, v, err, sum;
+	char name[40];
+
+	for (p=0; p<life_rule_presets(); p++) {
+		life_rule_preset(&r, p);
+		gen = r;
+		gen.kernel = LIFE_RULE_GENERIC;
+		err = life_bits_init(&bits, LIFE_W, LIFE_H);
+		err |= life_bits_init(&bits_gen, LIFE_W, LIFE_H);
+		err |= life_byte_init(&lut, LIFE_W, LIFE_H, LIFE_KERNEL_SCALAR);
+		assert(err == 0);
+		life_bits_set_rule(&bits, &r);
+		life_bits_set_rule(&bits_gen, &gen);
+		life_byte_set_rule(&lut, &gen);
+
+		memset(orig, 0, sizeof(orig));
+		srand(5760 + p);
+		for (x=1; x<639; x++) {
+			for (y=1; y<479; y++) {
+				// sparse enough that the growing rules do not fill up at once
+				v = orig[x][y] = (rand() & 7) == 0;
+				life_bits_set(&bits, x-LIFE_X0, y-LIFE_Y0, v);
+				life_bits_set(&bits_gen, x-LIFE_X0, y-LIFE_Y0, v);
+				life_byte_set(&lut, x-LIFE_X0, y-LIFE_Y0, v);
+			}
+		}
+		for (g=0; g<gens; g++) {
+			for (x=1; x<639; x++) {
+				for (y=1; y<479; y++) {
+					sum = orig[x-1][y-1] + orig[x][y-1] + orig[x+1][y-1] +
+					      orig[x-1][y]                  + orig[x+1][y] +
+					      orig[x-1][y+1] + orig[x][y+1] + orig[x+1][y+1] ;
+					orig_new[x][y] = ((orig[x][y] ? r.survive : r.birth) >> sum) & 1;
+				}
+			}
+			memcpy(orig, orig_new, sizeof(orig));
+			life_bits_step(&bits);
+			life_bits_step(&bits_gen);
+			life_byte_step(&lut);
+			for (x=1; x<639; x++) {
+				for (y=1; y<479; y++) {
+					v = orig[x][y];
+					assert(life_bits_get(&bits, x-LIFE_X0, y-LIFE_Y0) == v);
+					assert(life_bits_get(&bits_gen, x-LIFE_X0, y-LIFE_Y0) == v);
+					assert(life_byte_get(&lut, x-LIFE_X0, y-LIFE_Y0) == v);
+				}
+			}
+		}
+		life_rule_format(&r, name, sizeof(name));
+		printf("%-10s %-14s ok%s, population %ld\n", life_rule_preset_name(p), name,
+		       r.kernel != LIFE_RULE_GENERIC ? " (specialized)" : "",
+		       life_bits_population(&bits));
+		life_bits_free(&bits);
+		life_bits_free(&bits_gen);
+		life_byte_free(&lut);
+	}
+	return 0;
+}
+
+// a torus of each kind of width: inside one word, a multiple of 64,
+// and a partial last word, stepped by every engine but hash with Life
+// and with HighLife, against the original loop with its neighbours
+// taken modulo the size
+int self_check_wrap(int gens, int threads){
+	static const int size[3][2] = { {37, 5}, {128, 64}, {200, 150} };
+	life_bits_t bits, bits_full, bits_par;
+	life_byte_t vec[LIFE_KERNEL_COUNT];
+	life_rule_t r;
+	life_pool_t pool;
+	uint8_t *ref, *ref_new;
+	int s, p, k, g, x, y, v, w, h, err, sum, dx, dy;
+	char name[24];
+
+	assert(life_pool_init(&pool, threads) == 0);
+	for (s=0; s<3; s++) {
+		w = size[s][0];
+		h = size[s][1];
+		ref = malloc(w * h);
+		ref_new = malloc(w * h);
+		assert(ref && ref_new);
+		for (p=0; p<2; p++) {
+			life_rule_preset(&r, p);
+			err = life_bits_init(&bits, w, h);
+			err |= life_bits_init(&bits_full, w, h);
+			err |= life_bits_init(&bits_par, w, h);
+			for (k=0; k<LIFE_KERNEL_COUNT; k++) {
+				vec[k].cur = NULL;
+				if (life_byte_kernel_available(k))
+					err |= life_byte_init(&vec[k], w, h, k);
+			}
+			assert(err == 0);
+			bits_full.track = 0;
+			life_bits_set_wrap(&bits, 1);
+			life_bits_set_wrap(&bits_full, 1);
+			life_bits_set_wrap(&bits_par, 1);
+			life_bits_set_rule(&bits, &r);
+			life_bits_set_rule(&bits_full, &r);
+			life_bits_set_rule(&bits_par, &r);
+			for (k=0; k<LIFE_KERNEL_COUNT; k++) {
+				if (vec[k].cur == NULL) continue;
+				life_byte_set_wrap(&vec[k], 1);
+				life_byte_set_rule(&vec[k], &r);
+			}
+
+			srand(5760 + s);
+			for (y=0; y<h; y++) {
+				for (x=0; x<w; x++) {
+					v = ref[y*w+x] = (rand() & 3) == 0;
+					life_bits_set(&bits, x, y, v);
+					life_bits_set(&bits_full, x, y, v);
+					life_bits_set(&bits_par, x, y, v);
+					for (k=0; k<LIFE_KERNEL_COUNT; k++)
+						if (vec[k].cur) life_byte_set(&vec[k], x, y, v);
+				}
+			}
+			for (g=0; g<gens; g++) {
+				for (y=0; y<h; y++) {
+					for (x=0; x<w; x++) {
+						sum = 0;
+						for (dy=-1; dy<=1; dy++)
+							for (dx=-1; dx<=1; dx++)
+								if (dx || dy)
+									sum += ref[wrap_coord(y+dy, h)*w + wrap_coord(x+dx, w)];
+						ref_new[y*w+x] = ((ref[y*w+x] ? r.survive : r.birth) >> sum) & 1;
+					}
+				}
+				memcpy(ref, ref_new, w * h);
+				life_bits_step(&bits);
+				life_bits_step(&bits_full);
+				life_pool_run(&pool, step_bits_band, &bits_par, bits_par.tiles_y);
+				life_bits_swap(&bits_par);
+				for (k=0; k<LIFE_KERNEL_COUNT; k++)
+					if (vec[k].cur) life_byte_step(&vec[k]);
+				for (y=0; y<h; y++) {
+					for (x=0; x<w; x++) {
+						v = ref[y*w+x];
+						assert(life_bits_get(&bits, x, y) == v);
+						assert(life_bits_get(&bits_full, x, y) == v);
+						assert(life_bits_get(&bits_par, x, y) == v);
+						for (k=0; k<LIFE_KERNEL_COUNT; k++)
+							if (vec[k].cur) assert(life_byte_get(&vec[k], x, y) == v);
+					}
+				}
+			}
+			sprintf(name, "%dx%d", w, h);
+			printf("torus %-8s %-8s ok, population %ld\n", name,
+			       life_rule_preset_name(p), life_bits_population(&bits));
+			life_bits_free(&bits);
+			life_bits_free(&bits_full);
+			life_bits_free(&bits_par);
+			for (k=0; k<LIFE_KERNEL_COUNT; k++)
+				if (vec[k].cur) life_byte_free(&vec[k]);
+		}
+		free(ref);
+		free(ref_new);
+	}
+	life_pool_free(&pool);
+	return 0;
+}
+
+// the view of a random grid, dead-edged and toroidal, at several zooms
+// and offsets, against shading pixels cell by cell: all of them zoomed
+// in, a sample of rows and columns zoomed out
+int self_check_view(void){
+	static const int zooms[] = { 1, 2, 3, 7, -2, -3, -5, -26, -64 };
+	static const int org[][2] = { {0, 0}, {-37, -5}, {900, 650}, {-3000, 123} };
+	life_bits_t g;
+	vga_span_t s;
+	uint8_t *fb;
+	int t, z, o, x, y, sx, sy, n, live, c;
+
+	fb = calloc(1024 * 480, 1);
+	assert(fb && life_bits_init(&g, 1000, 700) == 0);
+	assert(vga_span_init(&s, fb, 1024, 640, 480, 4) == 0);
+	srand(5760);
+	for (y=0; y<700; y++)
+		for (x=0; x<1000; x++)
+			life_bits_set(&g, x, y, (rand() % 5) == 0);
+	for (t=0; t<2; t++) {
+		life_bits_set_wrap(&g, t);
+		for (z=0; z<(int)(sizeof(zooms)/sizeof(zooms[0])); z++) {
+			for (o=0; o<4; o++) {
+				life_view_draw(&g, &s, org[o][0], org[o][1], zooms[z]);
+				for (sy=0; sy<480; sy+=zooms[z] > 0 ? 1 : 11) {
+					for (sx=0; sx<640; sx+=zooms[z] > 0 ? 1 : 13) {
+						if (zooms[z] > 0) {
+							x = org[o][0] + sx / zooms[z];
+							y = org[o][1] + sy / zooms[z];
+							if (t) {
+								x = wrap_coord(x, 1000);
+								y = wrap_coord(y, 700);
+							}
+							c = life_bits_get(&g, x, y) ? 0xff : 0x00;
+						}
+						else {
+							n = -zooms[z];
+							live = 0;
+							for (y=0; y<n; y++) {
+								for (x=0; x<n; x++) {
+									if (t) live += life_bits_get(&g, wrap_coord(org[o][0] + sx*n + x, 1000),
+												     wrap_coord(org[o][1] + sy*n + y, 700));
+									else live += life_bits_get(&g, org[o][0] + sx*n + x,
+												   org[o][1] + sy*n + y);
+								}
+							}
+							c = life_view_shade(live, n * n);
+						}
+						assert(s.shadow[sy * 640 + sx] == c);
+					}
+				}
+			}
+		}
+	}
+	vga_span_flush(&s);
+	for (sy=0; sy<480; sy++) assert(memcmp(fb + sy * 1024, s.shadow + sy * 640, 640) == 0);
+	printf("view   ok, %d zooms x %d origins, dead and toroidal\n",
+	       (int)(sizeof(zooms)/sizeof(zooms[0])), 4);
+	vga_span_free(&s);
+	life_bits_free(&g);
+	free(fb);
+	return 0;
+}
+
+// a random soup left to settle inside dead edges: the bits engine's
+// hash kept up to date from the changed words equals the whole hash,
+// every generation, and the bits and byte engines find the same period
+// at the same generation. then a pentadecathlon next to a block on the
+// sparse plane is period 15, and its copy is matched a period later and
+// not before; chunks whose places differ only in high bits hash apart
+int self_check_cycle(int kernel){
+	life_bits_t bits;
+	life_byte_t byte;
+	life_sparse_t sparse, other;
+	life_cycle_t cb, cy, cs;
+	life_pattern_info_t info;
+	life_place_t at;
+	uint64_t h, rows[LIFE_CHUNK];
+	int g, x, y, v, err;
+
+	err = life_bits_init(&bits, 200, 150);
+	err |= life_byte_init(&byte, 200, 150, kernel);
+	err |= life_sparse_init(&sparse);
+	err |= life_cycle_init(&cb, 64) | life_cycle_init(&cy, 64) | life_cycle_init(&cs, 64);
+	assert(err == 0);
+	srand(5760);
+	for (y=0; y<150; y++) {
+		for (x=0; x<200; x++) {
+			v = (rand() & 3) == 0;
+			life_bits_set(&bits, x, y, v);
+			life_byte_set(&byte, x, y, v);
+		}
+	}
+	h = life_cycle_hash_bits(&bits);
+	assert(h == life_cycle_hash_byte(&byte));
+	life_cycle_add(&cb, h, 0);
+	life_cycle_add(&cy, h, 0);
+	for (g=1; g<=20000 && cb.period == 0; g++) {
+		life_bits_step_tiles(&bits, 0, bits.tiles_y);
+		h = life_cycle_bits_next(&bits, h);
+		life_bits_swap(&bits);
+		life_byte_step(&byte);
+		assert(h == life_cycle_hash_bits(&bits) && h == life_cycle_hash_byte(&byte));
+		assert(life_cycle_add(&cb, h, g) == life_cycle_add(&cy, life_cycle_hash_byte(&byte), g));
+	}
+	assert(cb.period != 0 && cb.period == cy.period);
+
+	// a pentadecathlon and a block, far from the origin
+	at.set = sparse_set;
+	at.ctx = &sparse;
+	at.x = -1000;
+	at.y = 3000;
+	at.orient = 0;
+	assert(life_pattern_parse("10o12$22b2o$22b2o!", &at, &info) == 0);
+	for (g=0; g<100 && cs.period == 0; g++) {
+		life_cycle_add(&cs, life_cycle_hash_sparse(&sparse), sparse.generation);
+		assert(life_sparse_step(&sparse) == 0);
+	}
+	assert(cs.period == 15);
+	// kept for -d jump: the same a period on, not half a period on
+	assert(life_sparse_init(&other) == 0 && life_sparse_copy(&other, &sparse) == 0);
+	assert(life_sparse_same(&sparse, &other) && other.generation == sparse.generation);
+	for (g=0; g<15; g++) {
+		assert(life_sparse_step(&sparse) == 0);
+		assert(life_sparse_same(&sparse, &other) == (g == 14));
+	}
+	// chunk (0, 0) with a word in row 1 against chunk (2^26, 0) with it in
+	// row 0: a row shifted in beside the chunk's place made these the same
+	life_sparse_clear(&sparse);
+	life_sparse_clear(&other);
+	memset(rows, 0, sizeof(rows));
+	rows[1] = 0x5a;
+	assert(life_sparse_put_chunk(&sparse, 0, 0, rows) == 0);
+	rows[1] = 0;
+	rows[0] = 0x5a;
+	assert(life_sparse_put_chunk(&other, 1 << 26, 0, rows) == 0);
+	assert(life_cycle_hash_sparse(&sparse) != life_cycle_hash_sparse(&other));
+	assert(!life_sparse_same(&sparse, &other));
+	printf("cycle  ok, soup settled into period %llu by generation %llu, pentadecathlon 15\n",
+	       (unsigned long long)cb.period, (unsigned long long)(cb.first - cb.period));
+	life_bits_free(&bits);
+	life_byte_free(&byte);
+	life_sparse_free(&sparse);
+	life_sparse_free(&other);
+	life_cycle_free(&cb);
+	life_cycle_free(&cy);
+	life_cycle_free(&cs);
+	return 0;
+}
+
+// a producer thread posts a numbered stream of commands through a small
+// queue as fast as it can, retrying when it is full; every one comes
+// out whole and in order. the two yield when they have to wait, for
+// a single CPU
+typedef struct { life_queue_t q; int n; } queue_check_t;
+
+static void *queue_check_writer(void *arg){
+	queue_check_t *c = arg;
+	life_cmd_t cmd;
+	int k;
+
+	memset(&cmd, 0, sizeof(cmd));
+	for (k=1; k<=c->n; k++) {
+		cmd.op = LIFE_CMD_SET;
+		cmd.x = k;
+		cmd.y = -k;
+		cmd.posted = k;
+		while (life_queue_post(&c->q, &cmd) != 0) sched_yield();
+	}
+	return NULL;
+}
+
+int self_check_queue(void){
+	queue_check_t c;
+	life_cmd_t cmd;
+	pthread_t tid;
+	int last = 0;
+
+	c.n = 1000000;
+	assert(life_queue_init(&c.q, 60) == 0 && c.q.mask == 63);
+	assert(life_queue_take(&c.q, &cmd) == 0);
+	assert(pthread_create(&tid, NULL, queue_check_writer, &c) == 0);
+	while (last < c.n) {
+		if (!life_queue_take(&c.q, &cmd)) {
+			sched_yield();
+			continue;
+		}
+		assert(cmd.op == LIFE_CMD_SET && cmd.x == last + 1 && cmd.y == -cmd.x &&
+		       cmd.posted == (uint64_t)cmd.x);
+		last = cmd.x;
+	}
+	pthread_join(tid, NULL);
+	assert(life_queue_take(&c.q, &cmd) == 0);
+	printf("queue  ok, %d commands in order, %ld posts found it full\n", c.n, c.q.dropped);
+	life_queue_free(&c.q);
+	return 0;
+}
+
+// a writer thread publishes frames filled with their own number while
+// this one takes them: every frame taken must be whole, and newer than
+// the one before
+typedef struct { life_triple_t t; int n; } triple_check_t;
+
+static void *triple_check_writer(void *arg){
+	triple_check_t *c = arg;
+	int k, x, *p;
+
+	for (k=1; k<=c->n; k++) {
+		p = life_triple_back(&c->t);
+		for (x=0; x<1024; x++) p[x] = k;
+		life_triple_publish(&c->t);
+	}
+	return NULL;
+}
+
+int self_check_triple(void){
+	triple_check_t c;
+	pthread_t tid;
+	int *p, k, fresh, last = 0, taken = 0;
+
+	c.n = 200000;
+	assert(life_triple_init(&c.t, 1024 * sizeof(int)) == 0);
+	assert(pthread_create(&tid, NULL, triple_check_writer, &c) == 0);
+	while (last < c.n) {
+		p = life_triple_front(&c.t, &fresh);
+		if (!fresh) continue;
+		for (k=1; k<1024; k++) assert(p[k] == p[0]);
+		assert(p[0] > last);
+		last = p[0];
+		taken++;
+	}
+	pthread_join(tid, NULL);
+	printf("triple ok, %d of %d frames taken whole and in order\n", taken, c.n);
+	life_triple_free(&c.t);
+	return 0;
+}
+
+// the box and the clear as they were: a byte store per pixel (volatile,
+// as the A9 compiler at -O2 left it; a newer one would vectorize the loop
+// over ordinary memory), and all 131072 words of the buffer one at a time
+static void fill_check_box_old(uint8_t *fb, int x1, int y1, int x2, int y2, uint8_t c){
+	int row, col;
+
+	for (row = y1; row <= y2; row++)
+		for (col = x1; col <= x2; ++col)
+			*(volatile char *)(fb + (row<<10) + col) = c;
+}
+
+static void fill_check_clear_old(uint8_t *fb){
+	volatile unsigned int *pixel = (unsigned int *)fb;
+	int count = 131072;
+
+	while (count > 0) {
+		*pixel++ = 0x0000;
+		--count;
+	}
+}
+
+// rectangles at every alignment, one- and two-byte pixels, against a
+// pixel at a time, with nothing outside them or past the 640 bytes of a
+// row touched; then a full clear and a full repaint timed both ways
+int self_check_fill(void){
+	uint8_t *fb, *ref;
+	int k, i, x, y, w, h, c, reps = 200;
+	uint64_t t0, t_byte, t_word, t_fill, t_box;
+
+	fb = malloc(1024 * 512 + 1);
+	ref = malloc(1024 * 512);
+	assert(fb && ref);
+	srand(6401);
+	for (k=0; k<1024*512; k++) fb[k] = ref[k] = rand();
+	for (k=0; k<4000; k++) {
+		x = rand() % 640;
+		y = rand() % 480;
+		w = rand() % (k & 1 ? 41 : 641 - x);
+		h = rand() % 9;
+		if (x + w > 640) w = 640 - x;
+		if (y + h > 480) h = 480 - y;
+		c = rand() & 0xff;
+		if (k % 3) {
+			vga_fill(fb, 1024, x, y, w, h, c);
+			if (w > 0 && h > 0) fill_check_box_old(ref, x, y, x+w-1, y+h-1, c);
+		}
+		else {
+			// 320 two-byte pixels a row, low byte first
+			x >>= 1;
+			w >>= 1;
+			vga_fill16(fb, 1024, x, y, w, h, c << 8 | (c ^ 0x5a));
+			for (; h>0; h--, y++) {
+				for (i=x; i<x+w; i++) {
+					ref[y*1024 + 2*i] = c ^ 0x5a;
+					ref[y*1024 + 2*i + 1] = c;
+				}
+			}
+		}
+		assert(memcmp(fb, ref, 1024 * 512) == 0);
+	}
+	// off the screen and inside out
+	vga_fill_box(fb, 1024, 640, 480, 700, 10, 900, 20, 1);
+	vga_fill_box(fb, 1024, 640, 480, 5, -50, -30, -1, 1);
+	assert(memcmp(fb, ref, 1024 * 512) == 0);
+	vga_fill_box(fb, 1024, 640, 480, 650, 490, 630, 470, 7);
+	fill_check_box_old(ref, 630, 470, 639, 479, 7);
+	assert(memcmp(fb, ref, 1024 * 512) == 0);
+	// a buffer at an odd address still gets its pixels low byte first
+	vga_fill16(fb + 1, 1024, 3, 2, 50, 2, 0x1234);
+	assert(fb[1 + 2048 + 6] == 0x34 && fb[1 + 2048 + 7] == 0x12 &&
+	       fb[1 + 3072 + 104] == 0x34 && fb[1 + 3072 + 105] == 0x12);
+
+	t0 = now_ns();
+	for (k=0; k<reps; k++) fill_check_box_old(fb, 0, 0, 639, 479, k);
+	t_byte = now_ns() - t0;
+	t0 = now_ns();
+	for (k=0; k<reps; k++) fill_check_clear_old(fb);
+	t_word = now_ns() - t0;
+	t0 = now_ns();
+	for (k=0; k<reps; k++) vga_fill(fb, 1024, 0, 0, 640, 480, 0);
+	t_fill = now_ns() - t0;
+	t0 = now_ns();
+	for (k=0; k<reps; k++) vga_fill_box(fb, 1024, 640, 480, 0, 0, 639, 479, k);
+	t_box = now_ns() - t0;
+	printf("fill   ok, full clear %.3f ms (%.3f a word at a time), repaint %.3f ms (%.3f a byte at a time)\n",
+	       t_fill / 1e6 / reps, t_word / 1e6 / reps, t_box / 1e6 / reps, t_byte / 1e6 / reps);
+	free(fb);
+	free(ref);
+	return 0;
+}
+
+// numbers formatted by hand against snprintf; the buffer always matches
+// the shadow, and a line written again stores only what moved; then a
+// status line a generation, the old way (sprintf, every byte stored) and
+// through the HUD
+int self_check_hud(void){
+	static vga_hud_t h;
+	vga_hud_line_t l;
+	uint8_t *fb;
+	volatile char *cb;
+	char want[128];
+	uint64_t v, t0, t_old, t_new;
+	double d, e;
+	long stores;
+	int k, i, w, p, n = 100000;
+
+	srand(8060);
+	for (k=0; k<100000; k++) {
+		v = (uint64_t)rand() << (rand() % 40);
+		w = rand() % 12;
+		p = rand() % 4;
+		d = (rand() - RAND_MAX / 2) / (double)(1 << (rand() % 20));
+		vga_hud_start(&l);
+		vga_hud_add_u(&l, v, w);
+		vga_hud_add(&l, "|");
+		vga_hud_add_fix(&l, d, w, p);
+		// no -0 by hand
+		for (e=1, i=0; i<p; i++) e *= 10;
+		if (d < 0 && d * e > -0.5) d = 0;
+		snprintf(want, sizeof(want), "%*llu|%*.*f", w, (unsigned long long)v, w, p, d);
+		// %f rounds halves to even, by hand they round away from 0:
+		// the same bar one in a few thousand
+		if (strcmp(l.text, want) != 0) {
+			snprintf(want, sizeof(want), "%*llu|%*.*f", w, (unsigned long long)v, w, p,
+				 d * (1 + 1e-12));
+			assert(strcmp(l.text, want) == 0);
+		}
+	}
+	vga_hud_start(&l);
+	vga_hud_add_fix(&l, -0.001, 0, 2);
+	assert(strcmp(l.text, "0.00") == 0);
+	for (k=0; k<10; k++) vga_hud_add(&l, "0123456789");
+	assert(l.len == VGA_HUD_COLS && strlen(l.text) == VGA_HUD_COLS);
+
+	fb = malloc(VGA_HUD_ROWS * VGA_HUD_PITCH);
+	assert(fb);
+	vga_hud_init(&h, fb);
+	assert(h.stores == VGA_HUD_ROWS * VGA_HUD_PITCH);
+	vga_hud_text(&h, 1, 4, "gen=12345 pop=678");
+	stores = h.stores;
+	vga_hud_text(&h, 1, 4, "gen=12346 pop=678");
+	assert(h.stores == stores + 1);
+	vga_hud_pad(&h, 1, 4, "gen=9", 20);
+	assert(memcmp(fb + 4 * 128, " gen=9                 ", 23) == 0);
+	vga_hud_text(&h, 75, 59, "cut off");
+	vga_hud_text(&h, -3, 3, "abcdef");
+	vga_hud_text(&h, 0, 60, "nowhere");
+	assert(memcmp(fb + 59 * 128 + 75, "cut o ", 6) == 0 && fb[59 * 128 + 80] == ' ');
+	assert(memcmp(fb + 3 * 128, "def ", 4) == 0);
+	assert(memcmp(fb, h.shadow, VGA_HUD_ROWS * VGA_HUD_PITCH) == 0);
+
+	cb = calloc(VGA_HUD_ROWS * VGA_HUD_PITCH, 1);
+	assert(cb);
+	t0 = now_ns();
+	for (k=0; k<n; k++) {
+		snprintf(want, sizeof(want), "T=%3.0fmS gen=%llu tiles=%ld/%d  ", 0.25,
+			 (unsigned long long)(1000000 + k), 140L + (k & 7), 150);
+		for (w=0; want[w]; w++) cb[4 * 128 + 1 + w] = want[w];
+	}
+	t_old = now_ns() - t0;
+	stores = h.stores;
+	t0 = now_ns();
+	for (k=0; k<n; k++) {
+		vga_hud_start(&l);
+		vga_hud_add(&l, "gen=");
+		vga_hud_add_u(&l, 1000000 + k, 0);
+		vga_hud_add(&l, " pop=");
+		vga_hud_add_u(&l, 4000 + (k & 15), 0);
+		vga_hud_add(&l, " step=");
+		vga_hud_add_fix(&l, 0.25, 0, 2);
+		vga_hud_add(&l, "mS tiles=");
+		vga_hud_add_u(&l, 140 + (k & 7), 0);
+		vga_hud_add(&l, "/150");
+		vga_hud_pad(&h, 1, 4, l.text, 64);
+	}
+	t_new = now_ns() - t0;
+	assert(memcmp(fb, h.shadow, VGA_HUD_ROWS * VGA_HUD_PITCH) == 0);
+	printf("hud    ok, status line %.0f ns and %d bytes stored the old way, %.0f ns and %.1f bytes\n",
+	       (double)t_old / n, w, (double)t_new / n, (double)(h.stores - stores) / n);
+	free((char *)cb);
+	free(fb);
+	return 0;
+}
+
+// the primitives pixel by pixel, as the old routines drew them but with
+// each pixel tested against the clip instead of clamped into it
+typedef struct { uint8_t *fb; int bpp, cx1, cy1, cx2, cy2; } raster_ref_t;
+
+static void raster_ref_put(raster_ref_t *q, long x, long y, uint16_t c){
+	if (x < q->cx1 || x > q->cx2 || y < q->cy1 || y > q->cy2) return;
+	if (q->bpp == 1) q->fb[y * 1024 + x] = c;
+	else memcpy(q->fb + y * 1024 + 2 * x, &c, 2);
+}
+
+static void raster_ref_box(raster_ref_t *q, int x1, int y1, int x2, int y2, uint16_t c){
+	int x, y, t;
+
+	if (x1 > x2) { t = x1; x1 = x2; x2 = t; }
+	if (y1 > y2) { t = y1; y1 = y2; y2 = t; }
+	for (y=y1; y<=y2; y++)
+		for (x=x1; x<=x2; x++)
+			raster_ref_put(q, x, y, c);
+}
+
+static void raster_ref_line(raster_ref_t *q, int x1, int y1, int x2, int y2, uint16_t c){
+	long dx = labs((long)x2 - x1), dy = labs((long)y2 - y1), e, j, t, x = x1, y = y1;
+	int s1 = x2 > x1 ? 1 : x2 < x1 ? -1 : 0, s2 = y2 > y1 ? 1 : y2 < y1 ? -1 : 0;
+	int xchange = dy > dx;
+
+	if (xchange) { t = dx; dx = dy; dy = t; }
+	e = 2 * dy - dx;
+	for (j=0; j<=dx; j++) {
+		raster_ref_put(q, x, y, c);
+		if (e >= 0) {
+			if (xchange) x += s1;
+			else y += s2;
+			e -= 2 * dx;
+		}
+		if (xchange) y += s2;
+		else x += s1;
+		e += 2 * dy;
+	}
+}
+
+static void raster_ref_disc(raster_ref_t *q, int x, int y, int r, uint16_t c){
+	int xc, yc;
+
+	for (yc=-r; yc<=r; yc++)
+		for (xc=-r; xc<=r; xc++)
+			if (xc*xc + yc*yc <= r*r + r) raster_ref_put(q, (long)x + xc, (long)y + yc, c);
+}
+
+// random boxes, lines and discs reaching well off the screen, under
+// random clip rectangles, in both pixel sizes, against the reference;
+// then command lists against the same commands drawn one by one
+int self_check_raster(void){
+	vga_raster_t r;
+	vga_raster_list_t l;
+	raster_ref_t q;
+	uint8_t *fb, *ref;
+	int k, bpp, op, w, h, x1, y1, x2, y2, c, band;
+	long drawn;
+
+	fb = calloc(1024 * 480, 1);
+	ref = calloc(1024 * 480, 1);
+	assert(fb && ref);
+	srand(5761);
+	for (bpp=1; bpp<=2; bpp++) {
+		w = bpp == 1 ? 640 : 320;
+		h = bpp == 1 ? 480 : 240;
+		assert(vga_raster_init(&r, fb, 1024, w, h, bpp) == 0);
+		q.fb = ref;
+		q.bpp = bpp;
+		for (k=0; k<20000; k++) {
+			if (k % 500 == 0) {
+				if (k % 1000 == 0) vga_raster_clip(&r, 0, 0, w-1, h-1);
+				else vga_raster_clip(&r, rand() % (w + 100) - 50, rand() % (h + 100) - 50,
+						     rand() % (w + 100) - 50, rand() % (h + 100) - 50);
+				q.cx1 = r.cx1; q.cy1 = r.cy1; q.cx2 = r.cx2; q.cy2 = r.cy2;
+			}
+			op = rand() % 3;
+			x1 = rand() % (2 * w) - w / 2;
+			y1 = rand() % (2 * h) - h / 2;
+			x2 = rand() % (2 * w) - w / 2;
+			y2 = rand() % (2 * h) - h / 2;
+			c = rand() & (bpp == 1 ? 0xff : 0xffff);
+			if (op == 0) {
+				vga_raster_box(&r, x1, y1, x2, y2, c);
+				raster_ref_box(&q, x1, y1, x2, y2, c);
+			}
+			else if (op == 1) {
+				vga_raster_line(&r, x1, y1, x2, y2, c);
+				raster_ref_line(&q, x1, y1, x2, y2, c);
+			}
+			else {
+				x2 = rand() % (k & 1 ? 8 : 120) - 1;
+				vga_raster_disc(&r, x1, y1, x2, c);
+				raster_ref_disc(&q, x1, y1, x2, c);
+			}
+			if (k % 20 == 0) assert(memcmp(fb, ref, 1024 * 480) == 0);
+		}
+		assert(memcmp(fb, ref, 1024 * 480) == 0);
+	}
+	// long lines, one pixel row or column of them on the screen
+	vga_raster_init(&r, fb, 1024, 640, 480, 1);
+	q.bpp = 1;
+	q.cx1 = q.cy1 = 0; q.cx2 = 639; q.cy2 = 479;
+	vga_raster_line(&r, -3000000, 7, 3000000, 301, 0x1c);
+	raster_ref_line(&q, -3000000, 7, 3000000, 301, 0x1c);
+	vga_raster_line(&r, 5, 2000000, 600, -1999999, 0xe0);
+	raster_ref_line(&q, 5, 2000000, 600, -1999999, 0xe0);
+	vga_raster_line(&r, 0, 0, 1 << 25, 10, 0x03);
+	assert(memcmp(fb, ref, 1024 * 480) == 0);
+
+	// overlapping commands queued, flushed whenever the list fills,
+	// under a clip that changes between them; in bands of 16 rows,
+	// then in the one band of the default
+	for (band=16, drawn=0; band>=0; band-=16) {
+		assert(vga_raster_list_init(&l, &r, 100, band) == 0);
+		for (k=0; k<5000; k++) {
+			if (k % 700 == 0) {
+				vga_raster_flush(&l);
+				vga_raster_clip(&r, rand() % 740 - 50, rand() % 580 - 50,
+						rand() % 740 - 50, rand() % 580 - 50);
+				if (k % 1400 == 0) vga_raster_clip(&r, 0, 0, 639, 479);
+				q.cx1 = r.cx1; q.cy1 = r.cy1; q.cx2 = r.cx2; q.cy2 = r.cy2;
+			}
+			op = rand() % 3;
+			x1 = rand() % 1280 - 320;
+			y1 = rand() % 960 - 240;
+			x2 = rand() % 1280 - 320;
+			y2 = rand() % 960 - 240;
+			c = rand() & 0xff;
+			if (op == 0) {
+				vga_raster_add_box(&l, x1, y1, (x1 + x2) / 4, (y1 + y2) / 4, c);
+				raster_ref_box(&q, x1, y1, (x1 + x2) / 4, (y1 + y2) / 4, c);
+			}
+			else if (op == 1) {
+				vga_raster_add_line(&l, x1, y1, x2, y2, c);
+				raster_ref_line(&q, x1, y1, x2, y2, c);
+			}
+			else {
+				vga_raster_add_disc(&l, x1, y1, x2 & 63, c);
+				raster_ref_disc(&q, x1, y1, x2 & 63, c);
+			}
+		}
+		vga_raster_flush(&l);
+		assert(memcmp(fb, ref, 1024 * 480) == 0);
+		drawn += l.drawn;
+		vga_raster_list_free(&l);
+	}
+	printf("raster ok, 40000 boxes, lines and discs clipped, %ld through command lists\n",
+	       drawn);
+	free(fb);
+	free(ref);
+	return 0;
+}
+
+// the cells of a and b, both width x height, are the same
+static int pattern_same(life_bits_t *a, life_bits_t *b, int width, int height){
+	int x, y;
+
+	for (y=0; y<height; y++)
+		for (x=0; x<width; x++)
+			if (life_bits_get(a, x, y) != life_bits_get(b, x, y)) return 0;
+	return 1;
+}
+
+// a soup written as RLE, with a rule, and as plaintext, then read back
+// cell for cell; a plaintext file with comments; then a pattern with no
+// symmetry placed in each of the eight orientations, every one against
+// where its cells have to land, and the three rotations against the
+// rotated shapes drawn out by hand
+int self_check_pattern(void){
+	static const char *rotated[3][2] = {
+		{ "OO\n.O\n.O\n", "rot90" },
+		{ "..O\nOOO\n", "rot180" },
+		{ "O.\nO.\nOO\n", "rot270" },
+	};
+	static const char rle_l[] = "x = 3, y = 2\n3o$o!\n";
+	static const int rot[3] = { LIFE_ROT90, LIFE_ROT180, LIFE_ROT270 };
+	life_bits_t soup, back, want;
+	life_pattern_info_t info;
+	life_place_t at;
+	life_rule_t r;
+	FILE *f;
+	char shape[8][4][4];
+	int k, o, x, y, px, py, w, h;
+
+	assert(life_bits_init(&soup, 100, 70) == 0 && life_bits_init(&back, 100, 70) == 0 &&
+	       life_bits_init(&want, 100, 70) == 0);
+	life_pattern_soup(bits_set, &soup, 97, 70, 5760);
+	life_rule_preset(&r, 1);
+	at.set = bits_set;
+	at.ctx = &back;
+	at.x = at.y = 0;
+	at.orient = 0;
+	for (k=0; k<2; k++) {
+		assert((f = tmpfile()) != NULL);
+		if (k == 0) assert(life_pattern_write_rle(f, bits_get, &soup, 0, 0, 97, 70, &r) == 0);
+		else assert(life_pattern_write_cells(f, bits_get, &soup, 0, 0, 97, 70) == 0);
+		rewind(f);
+		life_bits_clear(&back);
+		assert(life_pattern_read(f, &at, &info) == 0);
+		fclose(f);
+		assert(pattern_same(&soup, &back, 100, 70));
+		assert(info.cells == life_bits_population(&soup));
+		if (k == 0) {
+			assert(info.format == LIFE_FORMAT_RLE && info.width == 97 && info.height == 70);
+			assert(info.has_rule && info.rule.birth == r.birth && info.rule.survive == r.survive);
+		}
+		else assert(info.format == LIFE_FORMAT_CELLS && !info.has_rule);
+	}
+
+	// a glider, after a name and a comment
+	life_bits_clear(&back);
+	assert(life_pattern_parse("!Name: Glider\n!a comment\n.O.\n..O\nOOO\n", &at, &info) == 0);
+	assert(info.format == LIFE_FORMAT_CELLS && info.width == 3 && info.height == 3 && info.cells == 5);
+	assert(life_bits_population(&back) == 5 && life_bits_get(&back, 1, 0) && life_bits_get(&back, 2, 1) &&
+	       life_bits_get(&back, 0, 2) && life_bits_get(&back, 1, 2) && life_bits_get(&back, 2, 2));
+
+	// every orientation of a 4x3 shape with no symmetry: swap, then flip
+	// within the box
+	for (o=0; o<8; o++) {
+		life_bits_clear(&back);
+		life_bits_clear(&want);
+		at.ctx = &back;
+		at.x = 10;
+		at.y = 20;
+		at.orient = o;
+		assert(life_pattern_parse("x = 4, y = 3\n4o$o$bo!", &at, &info) == 0);
+		w = o & LIFE_SWAP_XY ? 3 : 4;
+		h = o & LIFE_SWAP_XY ? 4 : 3;
+		for (y=0; y<3; y++) {
+			for (x=0; x<4; x++) {
+				if (!(y == 0 || (y == 1 && x == 0) || (y == 2 && x == 1))) continue;
+				px = o & LIFE_SWAP_XY ? y : x;
+				py = o & LIFE_SWAP_XY ? x : y;
+				if (o & LIFE_FLIP_X) px = w - 1 - px;
+				if (o & LIFE_FLIP_Y) py = h - 1 - py;
+				life_bits_set(&want, 10 + px, 20 + py, 1);
+			}
+		}
+		assert(pattern_same(&want, &back, 100, 70) && life_bits_population(&back) == 6);
+		// and no two orientations alike
+		for (y=0; y<4; y++)
+			for (x=0; x<4; x++)
+				shape[o][y][x] = life_bits_get(&back, 10 + x, 20 + y);
+		for (k=0; k<o; k++) assert(memcmp(shape[k], shape[o], sizeof(shape[o])) != 0);
+	}
+	for (k=0; k<3; k++) {
+		life_bits_clear(&back);
+		life_bits_clear(&want);
+		at.ctx = &back;
+		at.orient = rot[k];
+		assert(life_pattern_parse(rle_l, &at, &info) == 0);
+		at.ctx = &want;
+		at.orient = 0;
+		assert(life_pattern_parse(rotated[k][0], &at, &info) == 0);
+		if (!pattern_same(&want, &back, 100, 70)) {
+			printf("pattern %s of 3o$o! is wrong\n", rotated[k][1]);
+			return 1;
+		}
+	}
+	printf("pattern ok, RLE and plaintext round trips of %ld cells, 8 orientations\n",
+	       life_bits_population(&soup));
+	life_bits_free(&soup);
+	life_bits_free(&back);
+	life_bits_free(&want);
+	return 0;
+}
+
+// the bytes of file from, cut to len and with byte flip xored by 0x10
+// (none if it is past the end), as file to
+static void snap_copy(const char *from, const char *to, long len, long flip){
+	FILE *f;
+	char *buf;
+	long n;
+
+	assert((f = fopen(from, "rb")) != NULL);
+	fseek(f, 0, SEEK_END);
+	n = ftell(f);
+	rewind(f);
+	assert((buf = malloc(n)) != NULL && fread(buf, 1, n, f) == (size_t)n);
+	fclose(f);
+	if (flip < n) buf[flip] ^= 0x10;
+	assert((f = fopen(to, "wb")) != NULL);
+	assert(fwrite(buf, 1, len < n ? len : n, f) == (size_t)(len < n ? len : n));
+	fclose(f);
+	free(buf);
+}
+
+// a torus soup under HighLife and a sparse plane across the origin, each
+// written, opened and loaded back whole; the same files cut short or
+// with one bit changed, in the header or the cells, are refused; and a
+// write that cannot make its .tmp file leaves the snapshot before it
+int self_check_snap(void){
+	life_bits_t bits, back;
+	life_sparse_t sparse, sback;
+	life_snap_t m;
+	life_rule_t r;
+	char dir[] = "/tmp/life_snap_XXXXXX", path[64], bad[64], tmp[64];
+	long size, cut, refused = 0;
+	int x, y, k;
+
+	assert(mkdtemp(dir) != NULL);
+	snprintf(path, sizeof(path), "%s/run.snap", dir);
+	snprintf(bad, sizeof(bad), "%s/bad.snap", dir);
+	snprintf(tmp, sizeof(tmp), "%s/run.snap.tmp", dir);
+
+	assert(life_bits_init(&bits, 200, 100) == 0 && life_bits_init(&back, 200, 100) == 0);
+	life_rule_preset(&r, 1);
+	life_bits_set_rule(&bits, &r);
+	life_pattern_soup(bits_set, &bits, 200, 100, 5760);
+	life_bits_set_wrap(&bits, 1);
+	assert(life_snap_write_bits(path, &bits, 1234) == 0 && access(tmp, F_OK) != 0);
+	assert(life_snap_open(&m, path) == 0);
+	assert(m.hdr->kind == LIFE_SNAP_ROWS && m.hdr->generation == 1234 && m.hdr->wrap == 1 &&
+	       m.hdr->birth == r.birth && m.hdr->survive == r.survive);
+	assert(life_snap_load_bits(&m, &back) == 0);
+	size = m.size;
+	life_snap_close(&m);
+	// the same cells, and on the same torus under the same rule after
+	for (k=0; k<2; k++) {
+		for (y=0; y<100; y++)
+			assert(memcmp(LIFE_BITS_ROW(&bits, bits.cur, y), LIFE_BITS_ROW(&back, back.cur, y),
+				      bits.words * sizeof(uint64_t)) == 0);
+		life_bits_step(&bits);
+		life_bits_step(&back);
+	}
+
+	// cut anywhere from inside the header to one word short, or one
+	// bit changed anywhere, the rule and generation count included
+	for (cut=0; cut<size; cut += cut < 80 ? 8 : 997) {
+		snap_copy(path, bad, cut, size);
+		assert(life_snap_open(&m, bad) != 0);
+		refused++;
+	}
+	snap_copy(path, bad, size - 8, size);
+	assert(life_snap_open(&m, bad) != 0);
+	for (k=0; k<size; k += k < 64 ? 1 : 331) {
+		snap_copy(path, bad, size, k);
+		assert(life_snap_open(&m, bad) != 0);
+		refused++;
+	}
+
+	// a new snapshot replaces the old whole; one that cannot be started
+	// leaves the old one as it was
+	assert(life_snap_write_bits(path, &bits, 1236) == 0 && access(tmp, F_OK) != 0);
+	assert(mkdir(tmp, 0700) == 0);
+	assert(life_snap_write_bits(path, &back, 9999) != 0);
+	assert(life_snap_open(&m, path) == 0 && m.hdr->generation == 1236);
+	life_snap_close(&m);
+	rmdir(tmp);
+
+	// the sparse plane, chunks on both sides of the origin
+	assert(life_sparse_init(&sparse) == 0 && life_sparse_init(&sback) == 0);
+	life_sparse_set_rule(&sparse, &r);
+	srand(5762);
+	for (y=-150; y<150; y++)
+		for (x=-150; x<150; x++)
+			life_sparse_set(&sparse, x, y, (rand() & 3) == 0);
+	for (k=0; k<10; k++) assert(life_sparse_step(&sparse) == 0);
+	assert(sparse.used > 4);
+	assert(life_snap_write_sparse(path, &sparse) == 0 && access(tmp, F_OK) != 0);
+	assert(life_snap_open(&m, path) == 0 && m.hdr->kind == LIFE_SNAP_CHUNKS);
+	assert(life_snap_load_sparse(&m, &sback) == 0);
+	size = m.size;
+	life_snap_close(&m);
+	assert(sback.generation == 10 && sback.rule.birth == r.birth && sback.rule.survive == r.survive);
+	assert(life_sparse_population(&sback) == life_sparse_population(&sparse));
+	for (y=-200; y<200; y++)
+		for (x=-200; x<200; x++)
+			assert(life_sparse_get(&sback, x, y) == life_sparse_get(&sparse, x, y));
+	snap_copy(path, bad, size - sizeof(life_snap_chunk_t), size);
+	assert(life_snap_open(&m, bad) != 0);
+	snap_copy(path, bad, size, size - 3);
+	assert(life_snap_open(&m, bad) != 0);
+
+	printf("snap   ok, rows and chunks back whole, %ld damaged copies refused\n", refused + 2);
+	unlink(path);
+	unlink(bad);
+	rmdir(dir);
+	life_bits_free(&bits);
+	life_bits_free(&back);
+	life_sparse_free(&sparse);
+	life_sparse_free(&sback);
+	return 0;
+}
@@ -0,0 +1,14 @@
+/* The self-check of life_video_2, run by its -c: every engine, kernel,
+ * queue and drawing routine it uses against a plain reference, with no
+ * hardware.  kernel is the byte kernel picked with -k and threads the
+ * number of stepping threads of -t (0: one per online CPU), checked
+ * alongside the rest.
+ */
+#ifndef LIFE_CHECK_H
+#define LIFE_CHECK_H
+
+// 0 when every part passes; a part that fails asserts, or returns 1
+// when it cannot get the memory or threads to run
+int life_check(int kernel, int threads);
+
+#endif
@@ -0,0 +1,151 @@
+///////////////////////////////////////
+/// Cycle detection: generation hashes
+/// and a ring of the last few
+///////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "life_cycle.h"
+
+int life_cycle_init(life_cycle_t *c, int size)
+{
+	memset(c, 0, sizeof(*c));
+	if (size < 1) return -1;
+	c->hash = calloc(size, sizeof(uint64_t));
+	c->gen = calloc(size, sizeof(uint64_t));
+	if (c->hash == NULL || c->gen == NULL) {
+		life_cycle_free(c);
+		return -1;
+	}
+	c->size = size;
+	return 0;
+}
+
+void life_cycle_free(life_cycle_t *c)
+{
+	free(c->hash);
+	free(c->gen);
+	memset(c, 0, sizeof(*c));
+}
+
+void life_cycle_reset(life_cycle_t *c)
+{
+	c->len = c->head = 0;
+	c->period = c->first = 0;
+}
+
+// newest first, so the shortest period is the one found
+uint64_t life_cycle_add(life_cycle_t *c, uint64_t hash, uint64_t gen)
+{
+	int k, i;
+
+	for (k=1; k<=c->len; k++) {
+		i = (c->head - k + c->size) % c->size;
+		if (c->hash[i] == hash && c->gen[i] < gen) {
+			c->period = gen - c->gen[i];
+			c->first = gen;
+			return c->period;
+		}
+	}
+	c->hash[c->head] = hash;
+	c->gen[c->head] = gen;
+	c->head = (c->head + 1) % c->size;
+	if (c->len < c->size) c->len++;
+	return 0;
+}
+
+/****************************************************************************************
+ * Whole hashes; a word's place is its index in the rows without the halo,
+ * the same for both grids, or a mix of its chunk, plus its row, for the
+ * sparse plane
+****************************************************************************************/
+uint64_t life_cycle_hash_bits(const life_bits_t *g)
+{
+	const uint64_t *p;
+	uint64_t h = 0;
+	int y, w;
+
+	for (y=0; y<g->height; y++) {
+		p = LIFE_BITS_ROW(g, g->cur, y);
+		for (w=0; w<g->words; w++)
+			h ^= life_cycle_word(p[w], (uint64_t)y * g->words + w);
+	}
+	return h;
+}
+
+// eight cells of 0 or 1 into bits 0..7: each byte's bit lands, by the
+// multiply, in its own bit of the top byte
+static inline uint64_t life_cycle_pack8(const uint8_t *cell)
+{
+	uint64_t v;
+
+	memcpy(&v, cell, 8);
+	return ((v & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56;
+}
+
+uint64_t life_cycle_hash_byte(const life_byte_t *g)
+{
+	const uint8_t *cell;
+	uint64_t h = 0, v;
+	int words = (g->width + 63) >> 6, y, w, x;
+
+	for (y=0; y<g->height; y++) {
+		cell = LIFE_BYTE_ROW(g, g->cur, y);
+		for (w=0; w<words; w++) {
+			v = 0;
+			for (x=w<<6; x+8<=(w<<6)+64 && x+8<=g->width; x+=8)
+				v |= life_cycle_pack8(cell + x) << (x & 63);
+			for (; x<(w<<6)+64 && x<g->width; x++)
+				v |= (uint64_t)(cell[x] != 0) << (x & 63);
+			h ^= life_cycle_word(v, (uint64_t)y * words + w);
+		}
+	}
+	return h;
+}
+
+uint64_t life_cycle_hash_sparse(const life_sparse_t *s)
+{
+	const life_chunk_t *c;
+	uint64_t h = 0, key;
+	uint32_t i;
+	int y;
+
+	for (i=1; i<s->top; i++) {
+		c = &s->chunk[i];
+		if (!c->used) continue;
+		// cx and cy fill the 64 bits, so the row cannot go in beside
+		// them: the pair is mixed first, one to one, and the row added
+		key = (uint64_t)(uint32_t)c->cx << 32 | (uint32_t)c->cy;
+		key = (key ^ (key >> 33)) * 0xFF51AFD7ED558CCDULL;
+		key ^= key >> 33;
+		for (y=0; y<LIFE_CHUNK; y++)
+			h ^= life_cycle_word(c->row[s->cur][y], key + y);
+	}
+	return h;
+}
+
+/****************************************************************************************
+ * The bits engine's next generation: a tile is one word wide, so the
+ * flagged tiles are exactly the words that may differ
+****************************************************************************************/
+uint64_t life_cycle_bits_next(const life_bits_t *g, uint64_t hash)
+{
+	const uint64_t *cur, *next;
+	uint64_t k;
+	int tx, ty, y, y1;
+
+	for (ty=0; ty<g->tiles_y; ty++) {
+		y1 = (ty+1) * LIFE_TILE_ROWS;
+		if (y1 > g->height) y1 = g->height;
+		for (tx=0; tx<g->tiles_x; tx++) {
+			if (!LIFE_BITS_TILE(g, g->dirty_next, tx, ty)) continue;
+			for (y=ty*LIFE_TILE_ROWS; y<y1; y++) {
+				cur = LIFE_BITS_ROW(g, g->cur, y);
+				next = LIFE_BITS_ROW(g, g->next, y);
+				if (cur[tx] == next[tx]) continue;
+				k = (uint64_t)y * g->words + tx;
+				hash ^= life_cycle_word(cur[tx], k) ^ life_cycle_word(next[tx], k);
+			}
+		}
+	}
+	return hash;
+}
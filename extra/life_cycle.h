@@ -0,0 +1,69 @@
+/* Cycle detection: has the universe been in this state before?
+ *
+ * Every generation is reduced to a 64-bit hash, and the hashes of the last
+ * few generations are kept in a ring.  A generation whose hash is already
+ * in the ring repeats the one it matches, and so does everything after it:
+ * the pattern has settled into a still life (period 1) or an oscillator.
+ *
+ * The hash is the xor, over every word of cells, of a mix of the word and
+ * its place in the universe; a dead word adds nothing.  So one generation's
+ * hash follows from the last by taking out the old value and putting in
+ * the new one of just the words that changed: life_cycle_bits_next() does
+ * that over the tiles the bits engine flagged, and costs nothing once the
+ * universe is quiet.  The byte and sparse engines are hashed whole, from
+ * their cells and from their live chunks.
+ *
+ * Two different generations share a hash with odds of about 2^-64 per
+ * pair: good enough to report a period, but before acting on one for
+ * good, jumping ahead, the cells themselves should be compared.
+ */
+#ifndef LIFE_CYCLE_H
+#define LIFE_CYCLE_H
+
+#include <stdint.h>
+#include "life_bits.h"
+#include "life_byte.h"
+#include "life_sparse.h"
+
+typedef struct life_cycle {
+	uint64_t *hash;         // ring of the last len generations' hashes
+	uint64_t *gen;          // and their generation numbers
+	int size;               // ring slots
+	int len;                // filled
+	int head;               // next slot to fill
+	uint64_t period;        // of the cycle found, 0 while none
+	uint64_t first;         // the generation it was found at
+} life_cycle_t;
+
+// word v at place k of the universe; 0 for a dead word
+static inline uint64_t life_cycle_word(uint64_t v, uint64_t k)
+{
+	uint64_t h;
+
+	if (v == 0) return 0;
+	h = v ^ (k * 0x9E3779B97F4A7C15ULL);
+	h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+	return h ^ (h >> 31);
+}
+
+// history of size generations, so periods up to size are found
+int  life_cycle_init(life_cycle_t *c, int size);
+void life_cycle_free(life_cycle_t *c);
+// forget every generation seen, when the rule or the cells are changed
+void life_cycle_reset(life_cycle_t *c);
+
+// hash of generation gen; returns the period when it repeats one in the
+// history (also left in c->period, and gen in c->first), else 0
+uint64_t life_cycle_add(life_cycle_t *c, uint64_t hash, uint64_t gen);
+
+// whole hashes of the current generation of each engine
+uint64_t life_cycle_hash_bits(const life_bits_t *g);
+uint64_t life_cycle_hash_byte(const life_byte_t *g);
+uint64_t life_cycle_hash_sparse(const life_sparse_t *s);
+
+// the hash of g->next, from hash, that of g->cur, after a step and
+// before life_bits_swap(): only the tiles flagged in dirty_next
+uint64_t life_cycle_bits_next(const life_bits_t *g, uint64_t hash);
+
+#endif
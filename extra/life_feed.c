@@ -0,0 +1,145 @@
+///////////////////////////////////////
+/// Generation feed: seqlocked ring of
+/// packed generations in SysV shared memory
+///////////////////////////////////////
+#include <string.h>
+#include <errno.h>
+#include <sys/shm.h>
+#include "life_feed.h"
+
+#define LIFE_FEED_ALIGN(n) (((n) + 63) & ~(uint64_t)63)
+
+static life_feed_slot_t *life_feed_slot(const life_feed_t *f, uint64_t index)
+{
+	return (life_feed_slot_t *)((char *)f->hdr + f->hdr->header_bytes +
+				    (index % f->hdr->slots) * f->hdr->slot_bytes);
+}
+
+/****************************************************************************************
+ * Make (or take over) the segment and lay out the ring
+ * shmget refuses a size bigger than an existing segment's, so one left by
+ * a smaller run, or the 100 bytes of the original program, is removed
+ * first; a bigger one is reused as it is
+****************************************************************************************/
+int life_feed_create(life_feed_t *f, key_t key, int width, int height, int slots)
+{
+	life_feed_header_t *h;
+	uint64_t slot_bytes, header_bytes, size;
+	int words = (width + 63) >> 6, old;
+
+	memset(f, 0, sizeof(*f));
+	f->id = -1;
+	if (width < 1 || height < 1 || slots < 1) return -1;
+	header_bytes = LIFE_FEED_ALIGN(sizeof(life_feed_header_t));
+	slot_bytes = LIFE_FEED_ALIGN(sizeof(life_feed_slot_t) + (uint64_t)words * height * sizeof(uint64_t));
+	size = header_bytes + slot_bytes * slots;
+
+	f->id = shmget(key, size, IPC_CREAT | 0666);
+	if (f->id < 0 && errno == EINVAL) {
+		if ((old = shmget(key, 0, 0666)) >= 0) shmctl(old, IPC_RMID, NULL);
+		f->id = shmget(key, size, IPC_CREAT | 0666);
+	}
+	if (f->id < 0) return -1;
+	h = shmat(f->id, NULL, 0);
+	if (h == (void *)-1) {
+		f->id = -1;
+		return -1;
+	}
+	f->hdr = h;
+	f->writer = 1;
+
+	// the magic goes in last, readers wait for a complete header
+	__atomic_store_n(&h->magic, 0, __ATOMIC_RELEASE);
+	memset(h, 0, size);
+	h->version = LIFE_FEED_VERSION;
+	h->width = width;
+	h->height = height;
+	h->words = words;
+	h->slots = slots;
+	h->slot_bytes = slot_bytes;
+	h->header_bytes = header_bytes;
+	__atomic_store_n(&h->magic, LIFE_FEED_MAGIC, __ATOMIC_RELEASE);
+	return 0;
+}
+
+int life_feed_attach(life_feed_t *f, key_t key)
+{
+	life_feed_header_t *h;
+
+	memset(f, 0, sizeof(*f));
+	f->id = shmget(key, 0, 0);
+	if (f->id < 0) return -1;
+	h = shmat(f->id, NULL, SHM_RDONLY);
+	if (h == (void *)-1) {
+		f->id = -1;
+		return -1;
+	}
+	f->hdr = h;
+	if (__atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) != LIFE_FEED_MAGIC ||
+	    h->version != LIFE_FEED_VERSION) {
+		life_feed_close(f);
+		return -1;
+	}
+	return 0;
+}
+
+void life_feed_close(life_feed_t *f)
+{
+	if (f->hdr) shmdt(f->hdr);
+	if (f->writer && f->id >= 0) shmctl(f->id, IPC_RMID, NULL);
+	memset(f, 0, sizeof(*f));
+	f->id = -1;
+}
+
+/****************************************************************************************
+ * Writer side of the seqlock
+ * odd sequence, then a fence so no store to the slot can be seen before
+ * it; the even sequence and the count are release stores after the cells
+****************************************************************************************/
+uint64_t *life_feed_begin(life_feed_t *f)
+{
+	life_feed_slot_t *s = life_feed_slot(f, f->hdr->published);
+
+	__atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	return s->cells;
+}
+
+void life_feed_end(life_feed_t *f, const life_feed_meta_t *meta)
+{
+	uint64_t index = f->hdr->published;
+	life_feed_slot_t *s = life_feed_slot(f, index);
+
+	s->meta = *meta;
+	s->meta.index = index;
+	__atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&f->hdr->published, index + 1, __ATOMIC_RELEASE);
+}
+
+uint64_t life_feed_published(const life_feed_t *f)
+{
+	return __atomic_load_n(&f->hdr->published, __ATOMIC_ACQUIRE);
+}
+
+/****************************************************************************************
+ * Reader side: copy, then check that the sequence did not move
+ * the slot's own index tells a lapped slot from the one asked for
+****************************************************************************************/
+int life_feed_read(const life_feed_t *f, uint64_t index, life_feed_meta_t *meta,
+		   uint64_t *cells)
+{
+	const life_feed_slot_t *s;
+	uint64_t s0, s1;
+
+	if (index >= life_feed_published(f)) return -1;
+	s = life_feed_slot(f, index);
+	s0 = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+	if (s0 & 1) return -1;
+	memcpy(meta, &s->meta, sizeof(*meta));
+	if (cells)
+		memcpy(cells, s->cells, (size_t)f->hdr->words * f->hdr->height * sizeof(uint64_t));
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	s1 = __atomic_load_n(&s->seq, __ATOMIC_RELAXED);
+	if (s0 != s1 || meta->index != index) return -1;
+	return 0;
+}
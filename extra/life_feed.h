@@ -0,0 +1,91 @@
+/* Generation feed over SysV shared memory.
+ *
+ * The simulator writes generations into a ring of slots in a shared
+ * memory segment; any number of other processes attach to the same key
+ * and read the newest ones in place, to record, stream or check a run.
+ * A generation's step_ms is the time its step took, not its drawing, and
+ * LIFE_FEED_EDITED in its flags says the cells were changed by hand
+ * since the one published before, so it is not that one's step.
+ * Readers never write to the segment, so they cannot hold the simulator
+ * up, and the simulator never waits for them.
+ *
+ * Each slot is a seqlock: its sequence number is odd while the writer
+ * fills it and goes up by two per generation.  A reader copies the slot
+ * and keeps the copy only if it saw the same even number before and
+ * after; a slot that was overwritten meanwhile is reported, not returned
+ * torn.  The header counts the generations published, slot i % slots
+ * holding publication i.
+ *
+ * Cells are packed like life_bits.h, 64 to a word with x = bit, but
+ * without the halo: row y is words words from row 0.
+ */
+#ifndef LIFE_FEED_H
+#define LIFE_FEED_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+
+#define LIFE_FEED_MAGIC   0x4c494645    // "LIFE"
+#define LIFE_FEED_VERSION 2
+
+// what lies past the edges of the cells in a slot
+#define LIFE_FEED_DEAD   0      // nothing, the universe has dead edges
+#define LIFE_FEED_TORUS  1      // the opposite edge
+#define LIFE_FEED_WINDOW 2      // more of an unbounded plane, not in the feed
+
+// meta.flags
+#define LIFE_FEED_EDITED 0x1    // edited since the last publication
+
+typedef struct life_feed_meta {
+	uint64_t index;         // publication number, 0 first
+	uint64_t generation;
+	int64_t population;
+	double step_ms;         // time to compute this generation
+	uint16_t birth, survive;        // rule that made it, life_rule.h masks
+	int32_t edge;           // LIFE_FEED_DEAD, _TORUS or _WINDOW
+	uint32_t flags;         // LIFE_FEED_EDITED
+} life_feed_meta_t;
+
+typedef struct life_feed_slot {
+	uint64_t seq;           // odd while being written
+	life_feed_meta_t meta;
+	uint64_t cells[];       // height rows of words words
+} life_feed_slot_t;
+
+typedef struct life_feed_header {
+	uint32_t magic, version;
+	int32_t width, height, words;
+	uint32_t slots;
+	uint64_t slot_bytes;    // slot i at header + header_bytes + i*slot_bytes
+	uint64_t header_bytes;
+	uint64_t published;     // publications so far
+} life_feed_header_t;
+
+typedef struct life_feed {
+	int id;                 // shmget id
+	life_feed_header_t *hdr;
+	int writer;
+} life_feed_t;
+
+// writer: a segment for slots generations of width x height cells; an
+// older segment under the key that is too small is removed first
+int  life_feed_create(life_feed_t *f, key_t key, int width, int height, int slots);
+// reader: the segment the simulator created
+int  life_feed_attach(life_feed_t *f, key_t key);
+// the writer also marks the segment to go once the last reader is gone
+void life_feed_close(life_feed_t *f);
+
+// writer: the rows of the next slot to fill, then publish them
+uint64_t *life_feed_begin(life_feed_t *f);
+void life_feed_end(life_feed_t *f, const life_feed_meta_t *meta);
+
+// reader: publications so far, the newest is one less
+uint64_t life_feed_published(const life_feed_t *f);
+// reader: copy publication index (meta, and the cells if cells is not
+// NULL); 0 on success, -1 if it is not published yet or was overwritten
+// before the copy finished
+int  life_feed_read(const life_feed_t *f, uint64_t index, life_feed_meta_t *meta,
+		    uint64_t *cells);
+
+#endif
@@ -0,0 +1,177 @@
+///////////////////////////////////////
+/// Reads the generation feed of a
+/// running life_video_2 and checks it
+/// compile with
+/// gcc life_feed_reader.c life_feed.c life_bits.c life_rule.c -o life_feed_reader -O2 -mfpu=neon
+/// usage: life_feed_reader [-k key] [-n pairs] [-i ms]
+///   -k the shared memory key (default 0xf0, as in life_video_2.c),
+///   -n stops after checking that many pairs of generations (default 1000),
+///   -i gives up once nothing new was published for that long (default 2000)
+///   every generation taken must be whole: its population must match its
+///   cells, and it must be newer than the one before. when two in a row are
+///   one generation apart, the first is stepped here with the rule it names
+///   and must give the second (away from the edges of a window onto an
+///   unbounded plane), unless the second was edited with the mouse in
+///   between. exits 1 on the first mismatch
+///////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "life_feed.h"
+#include "life_bits.h"
+#include "life_rule.h"
+
+double now_ms(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+long popcount_cells(const uint64_t *cells, long n)
+{
+	long k, pop = 0;
+	for (k=0; k<n; k++) pop += __builtin_popcountll(cells[k]);
+	return pop;
+}
+
+// step prev with the rule and edges of cur, the generation it became,
+// then compare;
+// a window is compared one cell in from its edges. returns the cells
+// that differ
+long check_step(life_bits_t *g, const life_feed_meta_t *meta, const uint64_t *prev,
+		const uint64_t *cur, int words)
+{
+	life_rule_t rule;
+	const uint64_t *row;
+	uint64_t diff, m;
+	long bad = 0;
+	int x, y, w, lo = 0, hi = g->height;
+
+	if (life_rule_make(&rule, meta->birth, meta->survive) != 0) return -1;
+	life_bits_set_rule(g, &rule);
+	for (y=0; y<g->height; y++)
+		memcpy(LIFE_BITS_ROW(g, g->cur, y), prev + (long)y * words, words * sizeof(uint64_t));
+	// refreshes the halo: the far edges, or nothing
+	life_bits_set_wrap(g, meta->edge == LIFE_FEED_TORUS);
+	life_bits_step(g);
+
+	if (meta->edge == LIFE_FEED_WINDOW) {
+		lo = 1;
+		hi = g->height - 1;
+	}
+	for (y=lo; y<hi; y++) {
+		row = LIFE_BITS_ROW(g, g->cur, y);
+		for (w=0; w<words; w++) {
+			diff = row[w] ^ cur[(long)y * words + w];
+			if (meta->edge == LIFE_FEED_WINDOW) {
+				// not the first and last columns
+				m = ~0ULL;
+				if (w == 0) m &= ~1ULL;
+				x = g->width - 1 - (w << 6);
+				if (x >= 0 && x < 64) m &= ~(1ULL << x);
+				diff &= m;
+			}
+			bad += __builtin_popcountll(diff);
+		}
+	}
+	return bad;
+}
+
+int main(int argc, char **argv)
+{
+	life_feed_t feed;
+	life_feed_meta_t meta, meta_prev;
+	life_bits_t g;
+	uint64_t *cells, *prev, published, seen = 0, last_gen = 0;
+	long n, pairs = 1000, checked = 0, taken = 0, missed = 0, edited = 0, bad;
+	int opt, idle_ms = 2000, have_last = 0;
+	key_t key = 0xf0;
+	double last_new;
+
+	while ((opt = getopt(argc, argv, "k:n:i:")) != -1) {
+		switch (opt) {
+		case 'k':
+			key = strtol(optarg, NULL, 0);
+			break;
+		case 'n':
+			pairs = atol(optarg);
+			break;
+		case 'i':
+			idle_ms = atoi(optarg);
+			break;
+		default:
+			printf( "usage: %s [-k key] [-n pairs] [-i ms]\n", argv[0] );
+			return(1);
+		}
+	}
+	if (life_feed_attach(&feed, key) != 0) {
+		printf( "ERROR: no generation feed at key 0x%x...\n", (unsigned)key );
+		return(1);
+	}
+	n = (long)feed.hdr->words * feed.hdr->height;
+	cells = malloc(n * sizeof(uint64_t));
+	prev = malloc(n * sizeof(uint64_t));
+	if (cells == NULL || prev == NULL || life_bits_init(&g, feed.hdr->width, feed.hdr->height) != 0) {
+		printf( "ERROR: could not allocate %dx%d cells...\n", feed.hdr->width, feed.hdr->height );
+		return(1);
+	}
+	g.track = 0;
+	printf("feed %dx%d, %u slots\n", feed.hdr->width, feed.hdr->height, feed.hdr->slots);
+
+	last_new = now_ms();
+	while (checked < pairs) {
+		published = life_feed_published(&feed);
+		if (published == seen) {
+			if (now_ms() - last_new > idle_ms) break;
+			usleep(200);
+			continue;
+		}
+		last_new = now_ms();
+		seen = published;
+		// the newest; overwritten under our feet is a miss, not an error
+		if (life_feed_read(&feed, published - 1, &meta, cells) != 0) {
+			missed++;
+			continue;
+		}
+		taken++;
+		if (popcount_cells(cells, n) != meta.population) {
+			printf( "ERROR: generation %llu has population %lld but %ld cells...\n",
+				(unsigned long long)meta.generation, (long long)meta.population,
+				popcount_cells(cells, n) );
+			return(1);
+		}
+		if (have_last && meta.generation <= last_gen) {
+			printf( "ERROR: generation %llu after %llu...\n",
+				(unsigned long long)meta.generation, (unsigned long long)last_gen );
+			return(1);
+		}
+		last_gen = meta.generation;
+		have_last = 1;
+
+		// and the one before, if it is still there, to step; not when
+		// the mouse changed the cells in between
+		if (meta.flags & LIFE_FEED_EDITED) edited++;
+		else if (published >= 2 && life_feed_read(&feed, published - 2, &meta_prev, prev) == 0 &&
+		    meta_prev.generation + 1 == meta.generation) {
+			bad = check_step(&g, &meta, prev, cells, feed.hdr->words);
+			if (bad != 0) {
+				printf( "ERROR: generation %llu differs from the step of %llu in %ld cells...\n",
+					(unsigned long long)meta.generation,
+					(unsigned long long)meta_prev.generation, bad );
+				return(1);
+			}
+			checked++;
+		}
+	}
+	printf("%ld generations taken whole, %ld overwritten before the copy finished, "
+	       "%ld steps checked, %ld edited, last generation %llu\n", taken, missed, checked,
+	       edited, (unsigned long long)last_gen);
+	life_bits_free(&g);
+	free(cells);
+	free(prev);
+	life_feed_close(&feed);
+	return(0);
+}
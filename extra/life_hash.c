@@ -0,0 +1,507 @@
+///////////////////////////////////////
+/// Hashlife engine
+/// canonical quadtree with memoized
+/// RESULT and a bounded node pool
+///////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "life_hash.h"
+
+#define LIFE_HASH_DEFAULT_CAP (1u << 22)   // ~160 MB of nodes
+#define LIFE_NODE_FREE 0xff                 // level of a released node
+
+/****************************************************************************************
+ * Node pool and hash-consing
+****************************************************************************************/
+static uint32_t life_hash_key(uint64_t a, uint64_t b)
+{
+	a ^= b * 0x9E3779B97F4A7C15ULL;
+	a ^= a >> 29;
+	a *= 0xBF58476D1CE4E5B9ULL;
+	a ^= a >> 32;
+	return (uint32_t)a;
+}
+
+static uint32_t life_node_key(const life_node_t *n)
+{
+	if (n->level == LIFE_HASH_LEAF) return life_hash_key(n->u.bits, LIFE_HASH_LEAF);
+	return life_hash_key(n->u.c[0] | (uint64_t)n->u.c[1] << 32,
+			     n->u.c[2] | (uint64_t)n->u.c[3] << 32);
+}
+
+static uint32_t life_node_alloc(life_hash_t *h)
+{
+	uint32_t i;
+
+	if (h->free_head) {
+		i = h->free_head;
+		h->free_head = h->node[i].next;
+	}
+	else if (h->top < h->cap) i = h->top++;
+	else return 0;
+	h->used++;
+	return i;
+}
+
+static void life_node_insert(life_hash_t *h, uint32_t i)
+{
+	uint32_t *b = &h->table[life_node_key(&h->node[i]) & h->mask];
+	h->node[i].next = *b;
+	*b = i;
+}
+
+static uint32_t life_hash_leaf(life_hash_t *h, uint64_t bits)
+{
+	uint32_t i;
+	life_node_t *n;
+
+	for (i = h->table[life_hash_key(bits, LIFE_HASH_LEAF) & h->mask]; i; i = n->next) {
+		n = &h->node[i];
+		if (n->level == LIFE_HASH_LEAF && n->u.bits == bits) return i;
+	}
+	if ((i = life_node_alloc(h)) == 0) return 0;
+	n = &h->node[i];
+	memset(n, 0, sizeof(*n));
+	n->level = LIFE_HASH_LEAF;
+	n->u.bits = bits;
+	n->pop = __builtin_popcountll(bits);
+	life_node_insert(h, i);
+	return i;
+}
+
+// a child index of 0 means an earlier allocation failed; pass it on
+static uint32_t life_hash_node(life_hash_t *h, uint32_t nw, uint32_t ne,
+			       uint32_t sw, uint32_t se)
+{
+	uint32_t i;
+	life_node_t *n;
+	uint8_t level;
+
+	if (!nw || !ne || !sw || !se) return 0;
+	level = h->node[nw].level + 1;
+	for (i = h->table[life_hash_key(nw | (uint64_t)ne << 32,
+					sw | (uint64_t)se << 32) & h->mask]; i; i = n->next) {
+		n = &h->node[i];
+		if (n->level == level && n->u.c[0] == nw && n->u.c[1] == ne &&
+		    n->u.c[2] == sw && n->u.c[3] == se) return i;
+	}
+	if ((i = life_node_alloc(h)) == 0) return 0;
+	n = &h->node[i];
+	memset(n, 0, sizeof(*n));
+	n->level = level;
+	n->u.c[0] = nw;
+	n->u.c[1] = ne;
+	n->u.c[2] = sw;
+	n->u.c[3] = se;
+	n->pop = h->node[nw].pop + h->node[ne].pop + h->node[sw].pop + h->node[se].pop;
+	life_node_insert(h, i);
+	return i;
+}
+
+static uint32_t life_hash_empty(life_hash_t *h, int level)
+{
+	uint32_t e;
+
+	if (h->empty[level]) return h->empty[level];
+	if (level == LIFE_HASH_LEAF) e = life_hash_leaf(h, 0);
+	else {
+		e = life_hash_empty(h, level-1);
+		e = life_hash_node(h, e, e, e, e);
+	}
+	return h->empty[level] = e;
+}
+
+/****************************************************************************************
+ * Init / free
+****************************************************************************************/
+int life_hash_init(life_hash_t *h, uint32_t max_nodes)
+{
+	uint32_t buckets = 1;
+
+	memset(h, 0, sizeof(*h));
+	if (max_nodes == 0) max_nodes = LIFE_HASH_DEFAULT_CAP;
+	if (max_nodes < 1024) max_nodes = 1024;
+	while (buckets < max_nodes) buckets <<= 1;
+
+	h->cap = max_nodes;
+	h->top = 1;
+	h->mask = buckets - 1;
+	life_rule_make(&h->rule, LIFE_RULE_LIFE_B, LIFE_RULE_LIFE_S);
+	h->node = malloc((size_t)max_nodes * sizeof(life_node_t));
+	h->table = calloc(buckets, sizeof(uint32_t));
+	if (h->node == NULL || h->table == NULL) {
+		life_hash_free(h);
+		return -1;
+	}
+	h->root = life_hash_empty(h, LIFE_HASH_LEAF+2);
+	return 0;
+}
+
+void life_hash_free(life_hash_t *h)
+{
+	free(h->node);
+	free(h->table);
+	memset(h, 0, sizeof(*h));
+}
+
+void life_hash_set_rule(life_hash_t *h, const life_rule_t *rule)
+{
+	uint32_t i;
+
+	h->rule = *rule;
+	for (i=1; i<h->top; i++) h->node[i].result = 0;
+}
+
+/****************************************************************************************
+ * Garbage collection: keep what the root (and the empty nodes) reach, plus
+ * memoized results that happen to point at kept nodes
+****************************************************************************************/
+static void life_hash_mark(life_hash_t *h, uint32_t i)
+{
+	life_node_t *n = &h->node[i];
+	int c;
+
+	if (n->mark) return;
+	n->mark = 1;
+	if (n->level > LIFE_HASH_LEAF)
+		for (c=0; c<4; c++) life_hash_mark(h, n->u.c[c]);
+}
+
+void life_hash_gc(life_hash_t *h)
+{
+	uint32_t i;
+	int l;
+	life_node_t *n;
+
+	life_hash_mark(h, h->root);
+	for (l=0; l<=LIFE_HASH_MAX_LEVEL; l++)
+		if (h->empty[l]) life_hash_mark(h, h->empty[l]);
+
+	// release everything unmarked
+	h->free_head = 0;
+	h->used = 0;
+	for (i=h->top-1; i>0; i--) {
+		n = &h->node[i];
+		if (n->level != LIFE_NODE_FREE && n->mark) {
+			h->used++;
+			continue;
+		}
+		n->level = LIFE_NODE_FREE;
+		n->next = h->free_head;
+		h->free_head = i;
+	}
+
+	// drop memos into freed nodes and rebuild the buckets
+	memset(h->table, 0, ((size_t)h->mask + 1) * sizeof(uint32_t));
+	for (i=1; i<h->top; i++) {
+		n = &h->node[i];
+		if (n->level == LIFE_NODE_FREE) continue;
+		n->mark = 0;
+		if (n->result && h->node[n->result].level == LIFE_NODE_FREE) n->result = 0;
+		life_node_insert(h, i);
+	}
+	h->gc_runs++;
+}
+
+/****************************************************************************************
+ * Base case: a level 4 node as 16 rows of 16 cells, stepped with the same
+ * rule logic as the bit-packed engine; the centre 8x8 is the result
+****************************************************************************************/
+static uint32_t life_hash_base(life_hash_t *h, uint32_t i, int gens)
+{
+	const life_node_t *n = &h->node[i];
+	uint64_t r[16], out[16], up, p, dn, bits = 0;
+	uint64_t nw, ne, sw, se;
+	int y, g;
+
+	nw = h->node[n->u.c[0]].u.bits;
+	ne = h->node[n->u.c[1]].u.bits;
+	sw = h->node[n->u.c[2]].u.bits;
+	se = h->node[n->u.c[3]].u.bits;
+	for (y=0; y<8; y++) {
+		r[y]   = ((nw >> 8*y) & 0xff) | ((ne >> 8*y) & 0xff) << 8;
+		r[y+8] = ((sw >> 8*y) & 0xff) | ((se >> 8*y) & 0xff) << 8;
+	}
+	// cells outside the 16x16 read as dead, which only spoils the
+	// outer ring by one cell per generation: 4 generations leave the
+	// centre 8x8 intact
+	for (g=0; g<gens; g++) {
+		for (y=0; y<16; y++) {
+			up = y > 0  ? r[y-1] : 0;
+			dn = y < 15 ? r[y+1] : 0;
+			p = r[y];
+			if (h->rule.kernel == LIFE_RULE_LIFE)
+				out[y] = life_bits_rule(up << 1, up, up >> 1,
+							p << 1, p, p >> 1,
+							dn << 1, dn, dn >> 1);
+			else
+				out[y] = life_bits_rule_bs(up << 1, up, up >> 1,
+							   p << 1, p, p >> 1,
+							   dn << 1, dn, dn >> 1,
+							   h->rule.birth, h->rule.survive);
+			out[y] &= 0xffff;
+		}
+		memcpy(r, out, sizeof(r));
+	}
+	for (y=0; y<8; y++) bits |= ((r[y+4] >> 4) & 0xff) << 8*y;
+	return life_hash_leaf(h, bits);
+}
+
+// the centre half of node i, no time advance
+static uint32_t life_hash_centre(life_hash_t *h, uint32_t i)
+{
+	const life_node_t *n = &h->node[i];
+
+	if (n->level == LIFE_HASH_LEAF+1) return life_hash_base(h, i, 0);
+	return life_hash_node(h, h->node[n->u.c[0]].u.c[3], h->node[n->u.c[1]].u.c[2],
+			      h->node[n->u.c[2]].u.c[1], h->node[n->u.c[3]].u.c[0]);
+}
+
+/****************************************************************************************
+ * RESULT: centre half of node i (level k) advanced 2^j generations, j <= k-2
+****************************************************************************************/
+static uint32_t life_hash_result(life_hash_t *h, uint32_t i, int j)
+{
+	life_node_t *n = &h->node[i];
+	uint32_t nw, ne, sw, se, s[9], q[4], r;
+	int k = n->level, c, jj;
+
+	if (n->pop == 0) return life_hash_empty(h, k-1);
+	if (n->result && n->rstep == j) return n->result;
+
+	if (k == LIFE_HASH_LEAF+1) r = life_hash_base(h, i, 1 << j);
+	else {
+		nw = n->u.c[0];
+		ne = n->u.c[1];
+		sw = n->u.c[2];
+		se = n->u.c[3];
+		// nine overlapping level k-1 squares
+		s[0] = nw;
+		s[1] = life_hash_node(h, h->node[nw].u.c[1], h->node[ne].u.c[0],
+				      h->node[nw].u.c[3], h->node[ne].u.c[2]);
+		s[2] = ne;
+		s[3] = life_hash_node(h, h->node[nw].u.c[2], h->node[nw].u.c[3],
+				      h->node[sw].u.c[0], h->node[sw].u.c[1]);
+		s[4] = life_hash_node(h, h->node[nw].u.c[3], h->node[ne].u.c[2],
+				      h->node[sw].u.c[1], h->node[se].u.c[0]);
+		s[5] = life_hash_node(h, h->node[ne].u.c[2], h->node[ne].u.c[3],
+				      h->node[se].u.c[0], h->node[se].u.c[1]);
+		s[6] = sw;
+		s[7] = life_hash_node(h, h->node[sw].u.c[1], h->node[se].u.c[0],
+				      h->node[sw].u.c[3], h->node[se].u.c[2]);
+		s[8] = se;
+
+		// first half of the time (or none, for a short step),
+		// then the second half on four recombined squares
+		for (c=0; c<9; c++) {
+			if (!s[c]) return 0;
+			s[c] = (j == k-2) ? life_hash_result(h, s[c], j-1)
+					  : life_hash_centre(h, s[c]);
+		}
+		q[0] = life_hash_node(h, s[0], s[1], s[3], s[4]);
+		q[1] = life_hash_node(h, s[1], s[2], s[4], s[5]);
+		q[2] = life_hash_node(h, s[3], s[4], s[6], s[7]);
+		q[3] = life_hash_node(h, s[4], s[5], s[7], s[8]);
+		jj = (j == k-2) ? j-1 : j;
+		for (c=0; c<4; c++) {
+			if (!q[c]) return 0;
+			q[c] = life_hash_result(h, q[c], jj);
+		}
+		r = life_hash_node(h, q[0], q[1], q[2], q[3]);
+	}
+	if (r) {
+		n = &h->node[i];
+		n->result = r;
+		n->rstep = j;
+	}
+	return r;
+}
+
+/****************************************************************************************
+ * Grow the root by one level around the same centre
+****************************************************************************************/
+static uint32_t life_hash_expand(life_hash_t *h, uint32_t i)
+{
+	const life_node_t *n = &h->node[i];
+	uint32_t e = life_hash_empty(h, n->level-1);
+
+	return life_hash_node(h,
+		life_hash_node(h, e, e, e, n->u.c[0]),
+		life_hash_node(h, e, e, n->u.c[1], e),
+		life_hash_node(h, e, n->u.c[2], e, e),
+		life_hash_node(h, n->u.c[3], e, e, e));
+}
+
+// everything alive sits in the centre half of the root
+static int life_hash_centred(const life_hash_t *h, uint32_t i)
+{
+	const life_node_t *n = &h->node[i];
+	const life_node_t *nw = &h->node[n->u.c[0]], *ne = &h->node[n->u.c[1]];
+	const life_node_t *sw = &h->node[n->u.c[2]], *se = &h->node[n->u.c[3]];
+	const life_node_t *m = h->node;
+
+	return nw->pop == m[nw->u.c[3]].pop && ne->pop == m[ne->u.c[2]].pop &&
+	       sw->pop == m[sw->u.c[1]].pop && se->pop == m[se->u.c[0]].pop;
+}
+
+/****************************************************************************************
+ * Advance by 2^k generations
+ * the root is padded until it is at least k+3 levels high with the pattern in
+ * its centre quarter, so nothing can reach the edge of the RESULT window
+****************************************************************************************/
+static int life_hash_try_step(life_hash_t *h, int k)
+{
+	uint32_t root = h->root, r;
+
+	while (h->node[root].level < k+2 || h->node[root].level < LIFE_HASH_LEAF+2 ||
+	       !life_hash_centred(h, root)) {
+		if ((root = life_hash_expand(h, root)) == 0) return -1;
+		h->root = root;
+	}
+	if ((root = life_hash_expand(h, root)) == 0) return -1;
+	h->root = root;
+	if ((r = life_hash_result(h, root, k)) == 0) return -1;
+	h->root = r;
+	h->generation += 1ULL << k;
+	return 0;
+}
+
+int life_hash_step_pow2(life_hash_t *h, int k)
+{
+	if (k < 0 || k > LIFE_HASH_MAX_LEVEL-3) return -1;
+	if (h->used > h->cap - h->cap/4) life_hash_gc(h);
+	if (life_hash_try_step(h, k) == 0) return 0;
+
+	// out of nodes: collect and retry, then fall back to two half steps
+	life_hash_gc(h);
+	if (life_hash_try_step(h, k) == 0) return 0;
+	if (k == 0) return -1;
+	life_hash_gc(h);
+	if (life_hash_step_pow2(h, k-1) != 0) return -1;
+	return life_hash_step_pow2(h, k-1);
+}
+
+int life_hash_advance(life_hash_t *h, uint64_t gens)
+{
+	int k;
+
+	for (k=0; gens; k++, gens >>= 1)
+		if ((gens & 1) && life_hash_step_pow2(h, k) != 0) return -1;
+	return 0;
+}
+
+uint64_t life_hash_population(const life_hash_t *h)
+{
+	return h->node[h->root].pop;
+}
+
+/****************************************************************************************
+ * Load from a bit grid
+****************************************************************************************/
+// 8 cells of row y starting at column x; outside the grid reads as dead
+static uint64_t life_bits_get8(const life_bits_t *g, long x, long y)
+{
+	const uint64_t *row;
+	int s;
+
+	if (y < 0 || y >= g->height || x <= -8 || x >= g->width) return 0;
+	row = LIFE_BITS_ROW(g, g->cur, y);
+	if (x < 0) return (row[0] << -x) & 0xff;
+	s = x & 63;
+	// row[words] is the zero halo word
+	return ((row[x >> 6] >> s) | (s > 56 ? row[(x >> 6) + 1] << (64 - s) : 0)) & 0xff;
+}
+
+static uint32_t life_hash_build(life_hash_t *h, const life_bits_t *g,
+				int level, long x, long y)
+{
+	uint64_t bits = 0;
+	long half;
+	int r;
+
+	// (x, y) is relative to the grid's cell (0, 0)
+	if (x >= g->width || y >= g->height ||
+	    x + (1L << level) <= 0 || y + (1L << level) <= 0)
+		return life_hash_empty(h, level);
+	if (level == LIFE_HASH_LEAF) {
+		for (r=0; r<8; r++) bits |= life_bits_get8(g, x, y+r) << 8*r;
+		return life_hash_leaf(h, bits);
+	}
+	half = 1L << (level-1);
+	return life_hash_node(h, life_hash_build(h, g, level-1, x, y),
+			      life_hash_build(h, g, level-1, x+half, y),
+			      life_hash_build(h, g, level-1, x, y+half),
+			      life_hash_build(h, g, level-1, x+half, y+half));
+}
+
+int life_hash_load_bits(life_hash_t *h, const life_bits_t *g, int x0, int y0)
+{
+	long extent;
+	int level = LIFE_HASH_LEAF+2;
+	uint32_t root;
+
+	// the root spans [-2^(level-1), 2^(level-1)) on both axes
+	extent = labs((long)x0) + g->width;
+	if (labs((long)y0) + g->height > extent) extent = labs((long)y0) + g->height;
+	while ((1L << (level-1)) < extent) level++;
+
+	h->root = life_hash_empty(h, level);
+	life_hash_gc(h);
+	root = life_hash_build(h, g, level, -(1L << (level-1)) - x0, -(1L << (level-1)) - y0);
+	if (root == 0) return -1;
+	h->root = root;
+	h->generation = 0;
+	return 0;
+}
+
+/****************************************************************************************
+ * Render into a bit grid
+****************************************************************************************/
+static void life_hash_draw(const life_hash_t *h, life_bits_t *g, uint32_t i,
+			   int64_t nx, int64_t ny)
+{
+	const life_node_t *n = &h->node[i];
+	int64_t size = (int64_t)1 << n->level, half;
+	uint64_t *row, b;
+	long gx, gy;
+	int r, s, w;
+
+	// (nx, ny) is relative to the grid's cell (0, 0)
+	if (n->pop == 0 || nx >= g->width || ny >= g->height ||
+	    nx + size <= 0 || ny + size <= 0)
+		return;
+	if (n->level == LIFE_HASH_LEAF) {
+		gx = (long)nx;
+		for (r=0; r<8; r++) {
+			gy = (long)ny + r;
+			b = (n->u.bits >> 8*r) & 0xff;
+			if (b == 0 || gy < 0 || gy >= g->height) continue;
+			row = LIFE_BITS_ROW(g, g->next, gy);
+			if (gx < 0) {
+				row[0] |= b >> -gx;
+				continue;
+			}
+			w = gx >> 6;
+			s = gx & 63;
+			row[w] |= b << s;
+			if (s > 56 && w+1 < g->words) row[w+1] |= b >> (64 - s);
+		}
+		return;
+	}
+	half = size >> 1;
+	life_hash_draw(h, g, n->u.c[0], nx, ny);
+	life_hash_draw(h, g, n->u.c[1], nx + half, ny);
+	life_hash_draw(h, g, n->u.c[2], nx, ny + half);
+	life_hash_draw(h, g, n->u.c[3], nx + half, ny + half);
+}
+
+void life_hash_render(const life_hash_t *h, life_bits_t *g, int x0, int y0)
+{
+	int64_t half = (int64_t)1 << (h->node[h->root].level - 1);
+	int y;
+
+	for (y=0; y<g->height; y++)
+		memset(LIFE_BITS_ROW(g, g->next, y), 0, g->words * sizeof(uint64_t));
+	life_hash_draw(h, g, h->root, -half - x0, -half - y0);
+	life_bits_mark_next(g);
+}
@@ -0,0 +1,74 @@
+/* Hashlife engine.
+ *
+ * The universe is an unbounded plane held as a canonical quadtree: a node
+ * at level k covers 2^k x 2^k cells, leaves are level 3 (8x8 cells in one
+ * uint64_t), and equal subtrees are stored once.  Each node memoizes its
+ * RESULT, the centre 2^(k-1) square advanced 2^j generations, so periodic
+ * patterns such as the glider guns can be pushed ahead by huge powers of two.
+ *
+ * Nodes come from a pool of fixed size.  When it runs low the engine marks
+ * everything reachable from the root, drops the rest together with any memo
+ * that pointed at it, and carries on, so memory never grows past the cap.
+ *
+ * Coordinates are the same as the caller's (screen coordinates in
+ * life_video_2.c); the root is always centred on the origin.
+ */
+#ifndef LIFE_HASH_H
+#define LIFE_HASH_H
+
+#include <stdint.h>
+#include "life_bits.h"
+
+typedef struct life_node {
+	union {
+		uint32_t c[4];  // nw, ne, sw, se children, level > 3
+		uint64_t bits;  // level 3: row r in bits 8r..8r+7, x = bit
+	} u;
+	uint64_t pop;           // live cells
+	uint32_t next;          // hash chain, or free list
+	uint32_t result;        // memoized RESULT, 0 if none
+	uint8_t level;
+	uint8_t rstep;          // log2 of the generations behind result
+	uint8_t mark;           // reachable, during garbage collection
+} life_node_t;
+
+#define LIFE_HASH_LEAF      3
+#define LIFE_HASH_MAX_LEVEL 62
+
+typedef struct life_hash {
+	life_node_t *node;      // node 0 is unused, index 0 means none
+	uint32_t cap;           // pool size
+	uint32_t used;          // live nodes
+	uint32_t top;           // first never-allocated index
+	uint32_t free_head;     // released nodes
+	uint32_t *table;        // hash buckets
+	uint32_t mask;
+	uint32_t empty[LIFE_HASH_MAX_LEVEL+1];
+	uint32_t root;
+	uint64_t generation;
+	long gc_runs;
+	life_rule_t rule;
+} life_hash_t;
+
+// max_nodes == 0 picks the default cap
+int  life_hash_init(life_hash_t *h, uint32_t max_nodes);
+void life_hash_free(life_hash_t *h);
+// switch rules; forgets every memoized result
+void life_hash_set_rule(life_hash_t *h, const life_rule_t *rule);
+
+// replace the universe with the cells of g, cell (0, 0) placed at (x0, y0)
+int  life_hash_load_bits(life_hash_t *h, const life_bits_t *g, int x0, int y0);
+
+// advance by 2^k generations, or by any count; 0 on success, -1 if the
+// node pool is too small even after collecting garbage
+int  life_hash_step_pow2(life_hash_t *h, int k);
+int  life_hash_advance(life_hash_t *h, uint64_t gens);
+
+// write the window (x0, y0)..(x0+w-1, y0+h-1) into g->next, flagging the
+// tiles that differ from g->cur in g->dirty_next, ready for life_bits_swap
+void life_hash_render(const life_hash_t *h, life_bits_t *g, int x0, int y0);
+
+uint64_t life_hash_population(const life_hash_t *h);
+void life_hash_gc(life_hash_t *h);
+
+#endif
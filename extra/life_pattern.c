@@ -0,0 +1,413 @@
+///////////////////////////////////////
+/// Seed patterns for the Life engines,
+/// and RLE / plaintext pattern files
+///////////////////////////////////////
+#include <stdint.h>
+#include <string.h>
+#include "life_pattern.h"
+
+const char life_pattern_gosper_gun[] =
+	"#N Gosper glider gun\n"
+	"x = 36, y = 9, rule = B3/S23\n"
+	"24bo$22bobo$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o$2o8bo3bob2o4b\n"
+	"obo$10bo5bo7bo$11bo3bo$12b2o!\n";
+
+const char life_pattern_pi[] =
+	"#N Pi-heptomino\n"
+	"x = 3, y = 3, rule = B3/S23\n"
+	"3o$obo$obo!\n";
+
+// reading state, fed a buffer at a time
+#define LIFE_P_LINE    0        // start of a line
+#define LIFE_P_COMMENT 1        // skipping to the end of the line
+#define LIFE_P_HEADER  2        // collecting the RLE header line
+#define LIFE_P_BODY    3        // cells
+#define LIFE_P_DONE    4        // after '!', or the header when measuring
+
+typedef struct life_parser {
+	const life_place_t *at;         // NULL: only measure
+	life_pattern_info_t *info;
+	int state;
+	int x, y;                       // next cell, pattern coordinates
+	long run;                       // RLE count being read, 0 for none
+	int bw, bh;                     // box the orientation works in
+	char header[256];
+	int header_len;
+} life_parser_t;
+
+/****************************************************************************************
+ * Place n live cells from (x, y) on
+****************************************************************************************/
+static void life_parser_cells(life_parser_t *p, long n)
+{
+	const life_place_t *at = p->at;
+	int x, y, k;
+
+	p->info->cells += n;
+	if (p->x + n > p->info->width) p->info->width = p->x + n;
+	if (p->y + 1 > p->info->height) p->info->height = p->y + 1;
+	if (at && at->orient == 0) {
+		for (k=0; k<n; k++) at->set(at->ctx, at->x + p->x + k, at->y + p->y, 1);
+		p->x += n;
+		return;
+	}
+	for (k=0; at && k<n; k++) {
+		x = p->x + k;
+		y = p->y;
+		if (at->orient & LIFE_SWAP_XY) {
+			x = p->y;
+			y = p->x + k;
+		}
+		if (at->orient & LIFE_FLIP_X) x = p->bw - 1 - x;
+		if (at->orient & LIFE_FLIP_Y) y = p->bh - 1 - y;
+		at->set(at->ctx, at->x + x, at->y + y, 1);
+	}
+	p->x += n;
+}
+
+// "x = 36, y = 9, rule = B3/S23", the rule optional and perhaps
+// followed by a ":T..." topology, which is not kept
+static int life_parser_header(life_parser_t *p)
+{
+	life_pattern_info_t *info = p->info;
+	char rule[64], *r;
+	int n;
+
+	p->header[p->header_len] = 0;
+	if (sscanf(p->header, " x = %d , y = %d", &info->width, &info->height) != 2 ||
+	    info->width < 0 || info->height < 0)
+		return -1;
+	if ((r = strstr(p->header, "rule")) != NULL) {
+		r += 4;
+		while (*r == ' ' || *r == '=') r++;
+		for (n=0; n<(int)sizeof(rule)-1 && r[n] && r[n] != ',' && r[n] != ':' &&
+		     r[n] != ' ' && r[n] != '\r'; n++)
+			rule[n] = r[n];
+		rule[n] = 0;
+		if (life_rule_parse(&info->rule, rule) != 0) return -1;
+		info->has_rule = 1;
+	}
+	return 0;
+}
+
+static void life_parser_begin(life_parser_t *p, const life_place_t *at, life_pattern_info_t *info)
+{
+	memset(p, 0, sizeof(*p));
+	memset(info, 0, sizeof(*info));
+	p->at = at;
+	p->info = info;
+	p->state = LIFE_P_LINE;
+	info->line = 1;
+}
+
+// the box the flips work in, swapped with the axes
+static void life_parser_box(life_parser_t *p, int width, int height)
+{
+	p->bw = p->at && (p->at->orient & LIFE_SWAP_XY) ? height : width;
+	p->bh = p->at && (p->at->orient & LIFE_SWAP_XY) ? width : height;
+}
+
+/****************************************************************************************
+ * Feed n bytes of pattern text
+ * the first character that is not blank tells the format: '#' or 'x' an
+ * RLE comment or header, '!' a plaintext comment, '.', 'O' or '*' a
+ * plaintext row, anything else the runs of a headerless RLE
+****************************************************************************************/
+static int life_parser_feed(life_parser_t *p, const char *buf, long n)
+{
+	life_pattern_info_t *info = p->info;
+	const char *end = buf + n;
+	long run;
+	char c;
+
+	while (buf < end && p->state != LIFE_P_DONE) {
+		c = *buf++;
+		if (c == '\n') info->line++;
+		switch (p->state) {
+		case LIFE_P_COMMENT:
+			if (c == '\n') p->state = LIFE_P_LINE;
+			break;
+
+		case LIFE_P_HEADER:
+			if (c != '\n') {
+				if (p->header_len < (int)sizeof(p->header)-1) p->header[p->header_len++] = c;
+				break;
+			}
+			if (life_parser_header(p) != 0) return -1;
+			life_parser_box(p, info->width, info->height);
+			// that is all a measure needs
+			p->state = p->at ? LIFE_P_BODY : LIFE_P_DONE;
+			break;
+
+		case LIFE_P_LINE:
+			// a blank line is a row of dead cells in plaintext
+			if (c == '\n' && info->format == LIFE_FORMAT_CELLS) p->y++;
+			if (c == ' ' || c == '\t' || c == '\r' || c == '\n') break;
+			if (info->format == 0) {
+				info->format = c == '!' || c == '.' || c == 'O' || c == '*' ?
+					       LIFE_FORMAT_CELLS : LIFE_FORMAT_RLE;
+			}
+			if (info->format == LIFE_FORMAT_CELLS) {
+				if (c == '!') {
+					p->state = LIFE_P_COMMENT;
+					break;
+				}
+				p->state = LIFE_P_BODY;
+				buf--;
+				break;
+			}
+			if (c == '#') {
+				p->state = LIFE_P_COMMENT;
+				break;
+			}
+			if (c == 'x' && p->header_len == 0 && p->y == 0 && p->x == 0) {
+				p->header[p->header_len++] = c;
+				p->state = LIFE_P_HEADER;
+				break;
+			}
+			p->state = LIFE_P_BODY;
+			buf--;
+			break;
+
+		case LIFE_P_BODY:
+			if (info->format == LIFE_FORMAT_CELLS) {
+				if (c == '.') p->x++;
+				else if (c == 'O' || c == '*') life_parser_cells(p, 1);
+				else if (c == '\n') {
+					p->x = 0;
+					p->y++;
+					p->state = LIFE_P_LINE;
+				}
+				else if (c != '\r' && c != ' ' && c != '\t') return -1;
+				break;
+			}
+			// the runs, the bulk of a big file, in a loop of their own
+			for (run=p->run; ; c=*buf++) {
+				if (c >= '0' && c <= '9') {
+					run = run * 10 + (c - '0');
+					if (run > 1L << 30) return -1;
+				}
+				else if (c == '\n') info->line++;
+				else if (c != ' ' && c != '\t' && c != '\r') {
+					if (run == 0) run = 1;
+					if (c == 'b' || c == '.') p->x += run;
+					else if (c == '$') {
+						p->x = 0;
+						p->y += run;
+					}
+					// o, or any live state of a multi-state rule
+					else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+						life_parser_cells(p, run);
+					else if (c == '!') {
+						p->state = LIFE_P_DONE;
+						break;
+					}
+					else return -1;
+					run = 0;
+				}
+				if (buf == end) break;
+			}
+			p->run = run;
+			break;
+		}
+	}
+	return 0;
+}
+
+static int life_parser_end(life_parser_t *p)
+{
+	// a header cut off by the end of the text
+	if (p->state == LIFE_P_HEADER && (life_parser_header(p) != 0 || p->at)) return -1;
+	if (p->info->format == 0) return -1;
+	return 0;
+}
+
+/****************************************************************************************
+ * Read and place a pattern, a buffer at a time
+****************************************************************************************/
+static int life_parser_flips(const life_place_t *at)
+{
+	return at && (at->orient & (LIFE_FLIP_X | LIFE_FLIP_Y));
+}
+
+int life_pattern_read(FILE *f, const life_place_t *at, life_pattern_info_t *info)
+{
+	life_parser_t p;
+	life_pattern_info_t box;
+	char buf[1 << 16];
+	long start = 0, n;
+
+	// the box first, then back to the start
+	if (life_parser_flips(at)) {
+		if ((start = ftell(f)) < 0 || life_pattern_read(f, NULL, &box) != 0 ||
+		    fseek(f, start, SEEK_SET) != 0)
+			return -1;
+	}
+	life_parser_begin(&p, at, info);
+	if (life_parser_flips(at)) life_parser_box(&p, box.width, box.height);
+	while (p.state != LIFE_P_DONE && (n = fread(buf, 1, sizeof(buf), f)) > 0) {
+		if (life_parser_feed(&p, buf, n) != 0) return -1;
+	}
+	if (ferror(f)) return -1;
+	return life_parser_end(&p);
+}
+
+int life_pattern_load(const char *path, const life_place_t *at, life_pattern_info_t *info)
+{
+	FILE *f = fopen(path, "rb");
+	int err;
+
+	if (f == NULL) {
+		memset(info, 0, sizeof(*info));
+		return -1;
+	}
+	err = life_pattern_read(f, at, info);
+	fclose(f);
+	return err;
+}
+
+int life_pattern_parse(const char *text, const life_place_t *at, life_pattern_info_t *info)
+{
+	life_parser_t p;
+	life_pattern_info_t box;
+
+	if (life_parser_flips(at) && life_pattern_parse(text, NULL, &box) != 0) return -1;
+	life_parser_begin(&p, at, info);
+	if (life_parser_flips(at)) life_parser_box(&p, box.width, box.height);
+	if (life_parser_feed(&p, text, strlen(text)) != 0) return -1;
+	return life_parser_end(&p);
+}
+
+/****************************************************************************************
+ * RLE writer: runs of each row, trailing dead cells left out, blank rows
+ * folded into the count of the '$', lines kept to 70 characters
+****************************************************************************************/
+typedef struct {
+	FILE *f;
+	int col;
+} life_rle_out_t;
+
+static void life_rle_token(life_rle_out_t *o, long n, char c)
+{
+	char tok[24];
+	int len;
+
+	if (n == 0) return;
+	len = n > 1 ? sprintf(tok, "%ld%c", n, c) : sprintf(tok, "%c", c);
+	if (o->col + len > 70) {
+		fputc('\n', o->f);
+		o->col = 0;
+	}
+	fputs(tok, o->f);
+	o->col += len;
+}
+
+int life_pattern_write_rle(FILE *f, life_get_fn get, void *ctx, int x, int y,
+			   int width, int height, const life_rule_t *rule)
+{
+	life_rle_out_t o = { f, 0 };
+	char name[40];
+	long dead, rows = 0;
+	int cx, cy, alive, run;
+
+	fprintf(f, "x = %d, y = %d", width, height);
+	if (rule) {
+		life_rule_format(rule, name, sizeof(name));
+		fprintf(f, ", rule = %s", name);
+	}
+	fputc('\n', f);
+	for (cy=0; cy<height; cy++) {
+		dead = 0;
+		for (cx=0; cx<width; cx+=run) {
+			alive = get(ctx, x + cx, y + cy) != 0;
+			for (run=1; cx+run<width && (get(ctx, x + cx + run, y + cy) != 0) == alive; run++);
+			if (!alive) {
+				dead += run;
+				continue;
+			}
+			// the first live cells of the row end the rows before it
+			life_rle_token(&o, rows, '$');
+			rows = 0;
+			life_rle_token(&o, dead, 'b');
+			dead = 0;
+			life_rle_token(&o, run, 'o');
+		}
+		rows++;
+	}
+	life_rle_token(&o, 1, '!');
+	fputc('\n', f);
+	return ferror(f) ? -1 : 0;
+}
+
+int life_pattern_write_cells(FILE *f, life_get_fn get, void *ctx, int x, int y,
+			     int width, int height)
+{
+	int cx, cy, last;
+
+	for (cy=0; cy<height; cy++) {
+		// up to the last live cell of the row, at least one cell so
+		// that leading blank rows are not taken for blank space
+		for (last=width-1; last>0 && !get(ctx, x + last, y + cy); last--);
+		for (cx=0; cx<=last; cx++) fputc(get(ctx, x + cx, y + cy) ? 'O' : '.', f);
+		fputc('\n', f);
+	}
+	return ferror(f) ? -1 : 0;
+}
+
+/****************************************************************************************
+ * Gosper glider gun
+****************************************************************************************/
+// x, y is the base postion, the gun's cells one in from it (from
+// the top, when flipped upside down)
+// x_orient and y_orient must be 1 or -1
+// the -1 flips the orientation
+void life_pattern_glider_gun(life_set_fn set, void *ctx, int x, int y,
+			     int x_orient, int y_orient)
+{
+	life_pattern_info_t info;
+	life_place_t at;
+
+	at.set = set;
+	at.ctx = ctx;
+	at.x = x + 1;
+	at.y = y_orient == -1 ? y : y + 1;
+	at.orient = (x_orient == -1 ? LIFE_FLIP_X : 0) | (y_orient == -1 ? LIFE_FLIP_Y : 0);
+	life_pattern_parse(life_pattern_gosper_gun, &at, &info);
+}
+
+void life_pattern_four_guns(life_set_fn set, void *ctx, int width, int height)
+{
+	// the guns sit at (149, 99) .. (399, 399) of the 638x478 universe
+	int x0 = (long)149 * width / 638, x1 = (long)399 * width / 638;
+	int y0 = (long)99 * height / 478, y1 = (long)399 * height / 478;
+
+	life_pattern_glider_gun(set, ctx, x0, y0, 1, 1);
+	life_pattern_glider_gun(set, ctx, x1, y0, -1, 1);
+	life_pattern_glider_gun(set, ctx, x0, y1, 1, -1);
+	life_pattern_glider_gun(set, ctx, x1, y1, -1, -1);
+}
+
+/****************************************************************************************
+ * Random soup, xorshift so that the big grids seed quickly
+****************************************************************************************/
+void life_pattern_soup(life_set_fn set, void *ctx, int width, int height,
+		       unsigned int seed)
+{
+	uint64_t r = 0x9E3779B97F4A7C15ULL ^ seed, bits = 0;
+	int x, y, n = 0;
+
+	for (y=0; y<height; y++) {
+		for (x=0; x<width; x++) {
+			if (n == 0) {
+				r ^= r << 13;
+				r ^= r >> 7;
+				r ^= r << 17;
+				bits = r;
+				n = 64;
+			}
+			set(ctx, x, y, bits & 1);
+			bits >>= 1;
+			n--;
+		}
+	}
+}
@@ -0,0 +1,89 @@
+/* Seed patterns shared by the Life programs.
+ *
+ * Patterns are drawn through a cell setter, so the same code seeds any
+ * engine: pass life_bits_set / life_byte_set style functions (or a wrapper
+ * that maps screen coordinates) with their grid as ctx.
+ *
+ * Pattern files are read in the two common text formats: run-length
+ * encoded (.rle, "x = 36, y = 9, rule = B3/S23" then runs such as
+ * "24bo$22bobo$...!") and plaintext (.cells, one row per line of '.' and
+ * 'O', comment lines starting with '!').  The format is told from the
+ * text itself.  Reading streams through a fixed buffer and hands every
+ * live cell straight to the setter, so nothing is allocated per cell and
+ * the size of the pattern only costs time.  Writing takes a cell getter
+ * and produces either format.
+ *
+ * A pattern is placed with its box's top left at (x, y), in any of the
+ * eight orientations: optionally swapped along the diagonal, then
+ * mirrored left-right and/or top-bottom within its box.
+ */
+#ifndef LIFE_PATTERN_H
+#define LIFE_PATTERN_H
+
+#include <stdio.h>
+#include "life_rule.h"
+
+typedef void (*life_set_fn)(void *ctx, int x, int y, int alive);
+typedef int  (*life_get_fn)(void *ctx, int x, int y);
+
+// orientations: swap first, then the flips; rotations are clockwise
+// with y going down the screen
+#define LIFE_FLIP_X  1
+#define LIFE_FLIP_Y  2
+#define LIFE_SWAP_XY 4
+#define LIFE_ROT90   (LIFE_SWAP_XY | LIFE_FLIP_X)
+#define LIFE_ROT180  (LIFE_FLIP_X | LIFE_FLIP_Y)
+#define LIFE_ROT270  (LIFE_SWAP_XY | LIFE_FLIP_Y)
+
+typedef struct life_place {
+	life_set_fn set;
+	void *ctx;
+	int x, y;               // top left of the placed box
+	int orient;             // LIFE_FLIP_X | LIFE_FLIP_Y | LIFE_SWAP_XY
+} life_place_t;
+
+#define LIFE_FORMAT_RLE   1
+#define LIFE_FORMAT_CELLS 2
+
+typedef struct life_pattern_info {
+	int format;             // LIFE_FORMAT_*
+	int width, height;      // box, before orientation
+	int has_rule;           // the RLE header named a rule
+	life_rule_t rule;
+	long cells;             // live cells
+	int line;               // where reading stopped on an error
+} life_pattern_info_t;
+
+// read a pattern and place it; with at NULL only info is filled in
+// (from the RLE header alone when there is one). a mirrored placement
+// needs the box first, so a file without an RLE header is read twice and
+// must be seekable. 0 on success, -1 on a read or syntax error
+int  life_pattern_read(FILE *f, const life_place_t *at, life_pattern_info_t *info);
+int  life_pattern_load(const char *path, const life_place_t *at, life_pattern_info_t *info);
+int  life_pattern_parse(const char *text, const life_place_t *at, life_pattern_info_t *info);
+
+// write the width x height cells at (x, y); the rule goes in the RLE
+// header when given. 0 on success, -1 on a write error
+int  life_pattern_write_rle(FILE *f, life_get_fn get, void *ctx, int x, int y,
+			    int width, int height, const life_rule_t *rule);
+int  life_pattern_write_cells(FILE *f, life_get_fn get, void *ctx, int x, int y,
+			      int width, int height);
+
+// Gosper glider gun in the 38x10 box at (x, y); x_orient and y_orient are
+// 1 or -1, -1 mirrors the gun along that axis
+void life_pattern_glider_gun(life_set_fn set, void *ctx, int x, int y,
+			     int x_orient, int y_orient);
+
+// the four guns of life_video_2.c, spread over a width x height universe
+// in the places they take on the 638x478 one
+void life_pattern_four_guns(life_set_fn set, void *ctx, int width, int height);
+
+// every cell of width x height alive with probability 1/2, from seed
+void life_pattern_soup(life_set_fn set, void *ctx, int width, int height,
+		       unsigned int seed);
+
+// the patterns built in, as RLE
+extern const char life_pattern_gosper_gun[];
+extern const char life_pattern_pi[];
+
+#endif
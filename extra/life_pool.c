@@ -0,0 +1,135 @@
+///////////////////////////////////////
+/// Band-parallel worker pool
+/// link with -pthread
+///////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "life_pool.h"
+
+typedef struct {
+	life_pool_t *pool;
+	int band;
+} life_worker_t;
+
+static void life_pool_band(life_pool_t *p, int band)
+{
+	int lo = (int)((long)p->n * band / p->threads);
+	int hi = (int)((long)p->n * (band+1) / p->threads);
+	if (lo < hi) p->fn(p->arg, lo, hi);
+}
+
+static void *life_pool_worker(void *arg)
+{
+	life_worker_t *w = arg;
+	life_pool_t *p = w->pool;
+	int band = w->band, open;
+
+	free(w);
+	// wait until every worker is up, or init gave up and wants them gone
+	pthread_mutex_lock(&p->gate_lock);
+	while (!p->gate_open && !p->quit) pthread_cond_wait(&p->gate, &p->gate_lock);
+	open = p->gate_open;
+	pthread_mutex_unlock(&p->gate_lock);
+	if (!open) return NULL;
+	while (1) {
+		pthread_barrier_wait(&p->start);
+		if (p->quit) break;
+		life_pool_band(p, band);
+		pthread_barrier_wait(&p->done);
+	}
+	return NULL;
+}
+
+int life_pool_online_cpus(void)
+{
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int)n : 1;
+}
+
+/****************************************************************************************
+ * Start threads-1 workers; the caller is the last one
+****************************************************************************************/
+int life_pool_init(life_pool_t *p, int threads)
+{
+	int t;
+	life_worker_t *w;
+
+	memset(p, 0, sizeof(*p));
+	if (threads <= 0) threads = life_pool_online_cpus();
+	p->threads = threads;
+	if (threads == 1) return 0;
+
+	p->tid = calloc(threads, sizeof(pthread_t));
+	if (p->tid == NULL) goto fail;
+	pthread_barrier_init(&p->start, NULL, threads);
+	pthread_barrier_init(&p->done, NULL, threads);
+	pthread_mutex_init(&p->gate_lock, NULL);
+	pthread_cond_init(&p->gate, NULL);
+	for (t=1; t<threads; t++) {
+		w = malloc(sizeof(*w));
+		if (w == NULL) goto stop;
+		w->pool = p;
+		w->band = t;
+		if (pthread_create(&p->tid[t], NULL, life_pool_worker, w) != 0) {
+			free(w);
+			goto stop;
+		}
+	}
+	pthread_mutex_lock(&p->gate_lock);
+	p->gate_open = 1;
+	pthread_cond_broadcast(&p->gate);
+	pthread_mutex_unlock(&p->gate_lock);
+	return 0;
+
+stop:
+	// the barriers count every thread, so the workers already started
+	// are let go at the gate, before they reach them
+	pthread_mutex_lock(&p->gate_lock);
+	p->quit = 1;
+	pthread_cond_broadcast(&p->gate);
+	pthread_mutex_unlock(&p->gate_lock);
+	while (--t >= 1) pthread_join(p->tid[t], NULL);
+	pthread_cond_destroy(&p->gate);
+	pthread_mutex_destroy(&p->gate_lock);
+	pthread_barrier_destroy(&p->start);
+	pthread_barrier_destroy(&p->done);
+fail:
+	free(p->tid);
+	memset(p, 0, sizeof(*p));
+	return -1;
+}
+
+void life_pool_free(life_pool_t *p)
+{
+	int t;
+
+	if (p->threads > 1) {
+		p->quit = 1;
+		pthread_barrier_wait(&p->start);
+		for (t=1; t<p->threads; t++) pthread_join(p->tid[t], NULL);
+		pthread_barrier_destroy(&p->start);
+		pthread_barrier_destroy(&p->done);
+		pthread_cond_destroy(&p->gate);
+		pthread_mutex_destroy(&p->gate_lock);
+	}
+	free(p->tid);
+	memset(p, 0, sizeof(*p));
+}
+
+/****************************************************************************************
+ * Run fn over [0, n) split in bands, one per thread
+****************************************************************************************/
+void life_pool_run(life_pool_t *p, life_band_fn fn, void *arg, int n)
+{
+	if (p->threads <= 1) {
+		fn(arg, 0, n);
+		return;
+	}
+	p->fn = fn;
+	p->arg = arg;
+	p->n = n;
+	pthread_barrier_wait(&p->start);
+	life_pool_band(p, 0);
+	pthread_barrier_wait(&p->done);
+}
@@ -0,0 +1,38 @@
+/* Band-parallel worker pool.
+ *
+ * A fixed set of threads is started once.  Each life_pool_run() splits the
+ * range [0, n) into one contiguous band per thread, runs fn on every band
+ * (the calling thread takes band 0) and returns when all bands are done.
+ * Workers park on a barrier between runs, so nothing is spawned per frame.
+ * Bands never overlap, so as long as fn only writes inside its band the
+ * result does not depend on the thread count.
+ */
+#ifndef LIFE_POOL_H
+#define LIFE_POOL_H
+
+#include <pthread.h>
+
+typedef void (*life_band_fn)(void *arg, int lo, int hi);
+
+typedef struct life_pool {
+	int threads;            // including the calling thread
+	pthread_t *tid;
+	pthread_barrier_t start, done;
+	life_band_fn fn;        // work for the current run
+	void *arg;
+	int n;
+	int quit;
+	pthread_mutex_t gate_lock;      // holds the workers until all are up
+	pthread_cond_t gate;
+	int gate_open;
+} life_pool_t;
+
+// threads <= 0 means one per online CPU. -1 if the threads could not all
+// be started; the pool is then left empty, and a pool of 1 always works
+int  life_pool_init(life_pool_t *p, int threads);
+void life_pool_free(life_pool_t *p);
+void life_pool_run(life_pool_t *p, life_band_fn fn, void *arg, int n);
+
+int  life_pool_online_cpus(void);
+
+#endif
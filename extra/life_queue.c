@@ -0,0 +1,52 @@
+///////////////////////////////////////
+/// Lock-free command queue, one
+/// producer and one consumer
+///////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "life_queue.h"
+
+int life_queue_init(life_queue_t *q, int size)
+{
+	uint32_t n = 1;
+
+	memset(q, 0, sizeof(*q));
+	while (n < (uint32_t)size) n <<= 1;
+	if ((q->cmd = calloc(n, sizeof(life_cmd_t))) == NULL) return -1;
+	q->mask = n - 1;
+	return 0;
+}
+
+void life_queue_free(life_queue_t *q)
+{
+	free(q->cmd);
+	memset(q, 0, sizeof(*q));
+}
+
+/****************************************************************************************
+ * The head and tail count up for ever and wrap round uint32_t; head - tail
+ * is the number of commands in the queue either way
+****************************************************************************************/
+int life_queue_post(life_queue_t *q, const life_cmd_t *c)
+{
+	uint32_t head = q->head;
+
+	// acquire, so the consumer is done with the slot it handed back
+	if (head - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) > q->mask) {
+		q->dropped++;
+		return -1;
+	}
+	q->cmd[head & q->mask] = *c;
+	__atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+int life_queue_take(life_queue_t *q, life_cmd_t *c)
+{
+	uint32_t tail = q->tail;
+
+	if (__atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == tail) return 0;
+	*c = q->cmd[tail & q->mask];
+	__atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+	return 1;
+}
@@ -0,0 +1,50 @@
+/* Lock-free command queue, one producer and one consumer.
+ *
+ * Edits to a running universe (a cell set or flipped, a pattern stamped,
+ * everything cleared) are posted by the input thread and taken by the
+ * stepping thread between two generations, so a generation is never
+ * stepped half edited and neither thread ever waits for the other.
+ *
+ * The queue is a ring of size commands, size a power of two, with a head
+ * only the producer moves and a tail only the consumer moves, each on its
+ * own cache line.  Posting writes the slot, then publishes the new head
+ * with a release store; taking reads the head with an acquire load, then
+ * the slot, then hands the slot back with a release store of the tail.
+ * A full queue turns the post away rather than wait.
+ */
+#ifndef LIFE_QUEUE_H
+#define LIFE_QUEUE_H
+
+#include <stdint.h>
+
+#define LIFE_CMD_SET    1       // cell (x, y) to arg
+#define LIFE_CMD_FLIP   2       // cell (x, y) dead to alive and back
+#define LIFE_CMD_STAMP  3       // pattern rle with its top left at (x, y)
+#define LIFE_CMD_CLEAR  4       // every cell dead
+
+typedef struct life_cmd {
+	int op;                 // LIFE_CMD_*
+	int x, y;               // universe cell
+	int arg;
+	const char *rle;        // STAMP: a pattern that outlives the queue
+	uint64_t posted;        // CLOCK_MONOTONIC ns, for the latency
+} life_cmd_t;
+
+typedef struct life_queue {
+	life_cmd_t *cmd;
+	uint32_t mask;          // size - 1
+	uint32_t head __attribute__((aligned(64)));     // next slot to post to
+	uint32_t tail __attribute__((aligned(64)));     // next slot to take
+	long dropped __attribute__((aligned(64)));      // posts turned away
+} life_queue_t;
+
+// size is rounded up to a power of two
+int  life_queue_init(life_queue_t *q, int size);
+void life_queue_free(life_queue_t *q);
+
+// producer: 0, or -1 when the queue is full
+int  life_queue_post(life_queue_t *q, const life_cmd_t *c);
+// consumer: 1 with the oldest command in *c, 0 when there is none
+int  life_queue_take(life_queue_t *q, life_cmd_t *c);
+
+#endif
@@ -0,0 +1,113 @@
+///////////////////////////////////////
+/// Life-like rule strings and presets
+///////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "life_rule.h"
+
+static const struct {
+	const char *name;
+	const char *rule;
+} presets[] = {
+	{ "life",       "B3/S23" },
+	{ "highlife",   "B36/S23" },
+	{ "seeds",      "B2/S" },
+	{ "daynight",   "B3678/S34678" },
+	{ "lwod",       "B3/S012345678" },   // life without death
+	{ "replicator", "B1357/S1357" },
+	{ "2x2",        "B36/S125" },
+	{ "maze",       "B3/S12345" },
+	{ "diamoeba",   "B35678/S5678" },
+	{ "morley",     "B368/S245" },
+	{ "34life",     "B34/S34" },
+};
+#define PRESETS ((int)(sizeof(presets) / sizeof(presets[0])))
+
+int life_rule_make(life_rule_t *r, unsigned birth, unsigned survive)
+{
+	if ((birth & 1) || birth > 0x1ff || survive > 0x1ff) return -1;
+	r->birth = birth;
+	r->survive = survive;
+	if (birth == LIFE_RULE_LIFE_B && survive == LIFE_RULE_LIFE_S)
+		r->kernel = LIFE_RULE_LIFE;
+	else if (birth == LIFE_RULE_HIGHLIFE_B && survive == LIFE_RULE_HIGHLIFE_S)
+		r->kernel = LIFE_RULE_HIGHLIFE;
+	else if (birth == LIFE_RULE_SEEDS_B && survive == LIFE_RULE_SEEDS_S)
+		r->kernel = LIFE_RULE_SEEDS;
+	else if (birth == LIFE_RULE_DAYNIGHT_B && survive == LIFE_RULE_DAYNIGHT_S)
+		r->kernel = LIFE_RULE_DAYNIGHT;
+	else
+		r->kernel = LIFE_RULE_GENERIC;
+	return 0;
+}
+
+/****************************************************************************************
+ * Rule strings: B and S may come in either order, in either case, with or
+ * without a '/' between them; digits without any letter are survive/birth
+****************************************************************************************/
+int life_rule_parse(life_rule_t *r, const char *s)
+{
+	unsigned mask[2] = { 0, 0 };    // birth, survive
+	int k, set = -1, letters = 0, slashes = 0;
+	const char *c;
+
+	for (k=0; k<PRESETS; k++)
+		if (strcasecmp(s, presets[k].name) == 0) return life_rule_parse(r, presets[k].rule);
+
+	for (c=s; *c; c++) {
+		if (*c == 'B' || *c == 'b') set = 0, letters++;
+		else if (*c == 'S' || *c == 's') set = 1, letters++;
+		else if (*c == '/') slashes++;
+		else if (!isdigit((unsigned char)*c) || *c == '9') return -1;
+	}
+	if (letters == 0) {
+		// survive/birth
+		if (slashes != 1) return -1;
+		set = 1;
+	}
+	else if (letters > 2 || slashes > 1 || set < 0 || !(*s == 'B' || *s == 'b' || *s == 'S' || *s == 's'))
+		return -1;
+
+	for (c=s; *c; c++) {
+		if (*c == 'B' || *c == 'b') set = 0;
+		else if (*c == 'S' || *c == 's') set = 1;
+		else if (*c == '/') { if (letters == 0) set = 0; }
+		else mask[set] |= 1u << (*c - '0');
+	}
+	return life_rule_make(r, mask[0], mask[1]);
+}
+
+void life_rule_format(const life_rule_t *r, char *buf, int size)
+{
+	char b[10], s[10];
+	int n, i, j;
+
+	for (n=0, i=0, j=0; n<9; n++) {
+		if ((r->birth >> n) & 1) b[i++] = '0' + n;
+		if ((r->survive >> n) & 1) s[j++] = '0' + n;
+	}
+	b[i] = s[j] = 0;
+	snprintf(buf, size, "B%s/S%s", b, s);
+}
+
+/****************************************************************************************
+ * Presets
+****************************************************************************************/
+int life_rule_presets(void)
+{
+	return PRESETS;
+}
+
+int life_rule_preset(life_rule_t *r, int index)
+{
+	if (index < 0 || index >= PRESETS) return -1;
+	return life_rule_parse(r, presets[index].rule);
+}
+
+const char *life_rule_preset_name(int index)
+{
+	if (index < 0 || index >= PRESETS) return "?";
+	return presets[index].name;
+}
@@ -0,0 +1,59 @@
+/* Life-like rules.
+ *
+ * A rule is two sets of neighbour counts, written B3/S23: a dead cell with a
+ * count in B is born, a live cell with a count in S survives, every other
+ * cell is dead next generation.  Each set is kept as a 9-bit mask, bit n for
+ * n live neighbours.
+ *
+ * The engines step a few common rules with kernels specialized for their
+ * constant masks and everything else with a generic table-driven kernel;
+ * rule.kernel says which.  Rules with B0 are refused: they would bring the
+ * dead halo around every grid to life.
+ */
+#ifndef LIFE_RULE_H
+#define LIFE_RULE_H
+
+#include <stdint.h>
+
+// rules with their own kernels, LIFE_RULE_GENERIC for any other
+enum {
+	LIFE_RULE_GENERIC = 0,
+	LIFE_RULE_LIFE,
+	LIFE_RULE_HIGHLIFE,
+	LIFE_RULE_SEEDS,
+	LIFE_RULE_DAYNIGHT,
+	LIFE_RULE_KERNELS
+};
+
+// birth / survive masks of the specialized rules
+#define LIFE_RULE_LIFE_B     0x008   // B3
+#define LIFE_RULE_LIFE_S     0x00c   // S23
+#define LIFE_RULE_HIGHLIFE_B 0x048   // B36
+#define LIFE_RULE_HIGHLIFE_S 0x00c   // S23
+#define LIFE_RULE_SEEDS_B    0x004   // B2
+#define LIFE_RULE_SEEDS_S    0x000   // S
+#define LIFE_RULE_DAYNIGHT_B 0x1c8   // B3678
+#define LIFE_RULE_DAYNIGHT_S 0x1d8   // S34678
+
+typedef struct life_rule {
+	uint16_t birth;         // bit n: born with n live neighbours
+	uint16_t survive;       // bit n: survives with n live neighbours
+	int kernel;             // LIFE_RULE_*
+} life_rule_t;
+
+// any masks; -1 for B0 or bits past 8
+int  life_rule_make(life_rule_t *r, unsigned birth, unsigned survive);
+
+// "B36/S23", "b36s23", the older survive/birth form "23/36", or a preset
+// name such as "highlife"; 0 on success, -1 if the string is not a rule
+int  life_rule_parse(life_rule_t *r, const char *s);
+
+// "B36/S23" form, size >= 22 always fits
+void life_rule_format(const life_rule_t *r, char *buf, int size);
+
+// the numbered presets, also picked with the DE1 switches: 0 is Life
+int  life_rule_presets(void);
+int  life_rule_preset(life_rule_t *r, int index);
+const char *life_rule_preset_name(int index);
+
+#endif
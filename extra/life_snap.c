@@ -0,0 +1,268 @@
+///////////////////////////////////////
+/// Binary snapshots: written atomically,
+/// read back through mmap
+///////////////////////////////////////
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "life_snap.h"
+
+// the words of the header before its checksum
+#define LIFE_SNAP_HEADER_WORDS (offsetof(life_snap_header_t, checksum) / sizeof(uint64_t))
+
+// one multiply per word, a running hash of the payload, then the header
+static uint64_t life_snap_sum(uint64_t h, const uint64_t *p, long n)
+{
+	long k;
+
+	for (k=0; k<n; k++) {
+		h = (h ^ p[k]) * 0x9E3779B97F4A7C15ULL;
+		h ^= h >> 31;
+	}
+	return h;
+}
+
+static void life_snap_header(life_snap_header_t *h, int kind, const life_rule_t *rule,
+			     uint64_t generation)
+{
+	memset(h, 0, sizeof(*h));
+	h->magic = LIFE_SNAP_MAGIC;
+	h->version = LIFE_SNAP_VERSION;
+	h->kind = kind;
+	h->birth = rule->birth;
+	h->survive = rule->survive;
+	h->generation = generation;
+}
+
+/****************************************************************************************
+ * Atomic replacement: path.tmp is written, synced and renamed over path,
+ * then the directory is synced so the rename itself is on the disk
+****************************************************************************************/
+static FILE *life_snap_create(const char *path, char *tmp, size_t size)
+{
+	int fd;
+	FILE *f;
+
+	snprintf(tmp, size, "%s.tmp", path);
+	if ((fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) return NULL;
+	if ((f = fdopen(fd, "wb")) == NULL) {
+		close(fd);
+		unlink(tmp);
+		return NULL;
+	}
+	setvbuf(f, NULL, _IOFBF, 1 << 20);
+	return f;
+}
+
+static int life_snap_commit(FILE *f, const char *path, const char *tmp,
+			    life_snap_header_t *h)
+{
+	char dir[4096], *slash;
+	int fd, err;
+
+	// the header goes in last, with the checksum, which takes in the
+	// header's own words after the payload's
+	h->checksum = life_snap_sum(h->checksum, (const uint64_t *)h, LIFE_SNAP_HEADER_WORDS);
+	err = fseek(f, 0, SEEK_SET) != 0 || fwrite(h, sizeof(*h), 1, f) != 1;
+	err |= fflush(f) != 0 || fsync(fileno(f)) != 0;
+	err |= fclose(f) != 0;
+	if (err || rename(tmp, path) != 0) {
+		unlink(tmp);
+		return -1;
+	}
+	snprintf(dir, sizeof(dir), "%s", path);
+	slash = strrchr(dir, '/');
+	if (slash == dir) slash[1] = 0;
+	else if (slash) *slash = 0;
+	else strcpy(dir, ".");
+	if ((fd = open(dir, O_RDONLY)) >= 0) {
+		fsync(fd);
+		close(fd);
+	}
+	return 0;
+}
+
+int life_snap_write_rows(const char *path, const uint64_t *rows, long stride, int width,
+			 int height, int wrap, const life_rule_t *rule, uint64_t generation)
+{
+	life_snap_header_t h;
+	char tmp[4096];
+	FILE *f;
+	int y, err = 0;
+
+	life_snap_header(&h, LIFE_SNAP_ROWS, rule, generation);
+	h.width = width;
+	h.height = height;
+	h.words = (width + 63) >> 6;
+	h.wrap = wrap;
+	h.count = height;
+	h.payload = (uint64_t)height * h.words * sizeof(uint64_t);
+	if ((f = life_snap_create(path, tmp, sizeof(tmp))) == NULL) return -1;
+	err |= fwrite(&h, sizeof(h), 1, f) != 1;
+	for (y=0; y<height && !err; y++) {
+		err |= fwrite(rows + y * stride, sizeof(uint64_t), h.words, f) != (size_t)h.words;
+		h.checksum = life_snap_sum(h.checksum, rows + y * stride, h.words);
+	}
+	if (err) {
+		fclose(f);
+		unlink(tmp);
+		return -1;
+	}
+	return life_snap_commit(f, path, tmp, &h);
+}
+
+int life_snap_write_bits(const char *path, const life_bits_t *g, uint64_t generation)
+{
+	return life_snap_write_rows(path, g->cur, g->stride, g->width, g->height, g->wrap,
+				    &g->rule, generation);
+}
+
+int life_snap_write_sparse(const char *path, const life_sparse_t *s)
+{
+	life_snap_header_t h;
+	life_snap_chunk_t c;
+	char tmp[4096];
+	FILE *f;
+	uint32_t i;
+	int err = 0;
+
+	life_snap_header(&h, LIFE_SNAP_CHUNKS, &s->rule, s->generation);
+	if ((f = life_snap_create(path, tmp, sizeof(tmp))) == NULL) return -1;
+	err |= fwrite(&h, sizeof(h), 1, f) != 1;
+	memset(&c, 0, sizeof(c));
+	for (i=1; i<s->top && !err; i++) {
+		if (!s->chunk[i].used) continue;
+		c.cx = s->chunk[i].cx;
+		c.cy = s->chunk[i].cy;
+		memcpy(c.row, s->chunk[i].row[s->cur], sizeof(c.row));
+		err |= fwrite(&c, sizeof(c), 1, f) != 1;
+		h.checksum = life_snap_sum(h.checksum, (const uint64_t *)&c, sizeof(c) / sizeof(uint64_t));
+		h.count++;
+	}
+	h.payload = h.count * sizeof(c);
+	if (err) {
+		fclose(f);
+		unlink(tmp);
+		return -1;
+	}
+	return life_snap_commit(f, path, tmp, &h);
+}
+
+/****************************************************************************************
+ * Map a snapshot and check it: the header, that the sizes add up to the
+ * file, and the checksum over the cells and the header
+****************************************************************************************/
+int life_snap_open(life_snap_t *m, const char *path)
+{
+	const life_snap_header_t *h;
+	struct stat st;
+	void *p;
+	int fd;
+
+	memset(m, 0, sizeof(*m));
+	if ((fd = open(path, O_RDONLY)) < 0) return -1;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(life_snap_header_t)) {
+		close(fd);
+		return -1;
+	}
+	p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED) return -1;
+	madvise(p, st.st_size, MADV_SEQUENTIAL);
+	m->hdr = h = p;
+	m->data = (const uint64_t *)(h + 1);
+	m->size = st.st_size;
+
+	if (h->magic != LIFE_SNAP_MAGIC || h->version != LIFE_SNAP_VERSION ||
+	    h->payload != m->size - sizeof(*h))
+		goto bad;
+	if (h->kind == LIFE_SNAP_ROWS) {
+		if (h->width < 1 || h->height < 1 || h->words != (h->width + 63) >> 6 ||
+		    h->count != (uint64_t)h->height ||
+		    h->payload != (uint64_t)h->height * h->words * sizeof(uint64_t))
+			goto bad;
+	}
+	else if (h->kind != LIFE_SNAP_CHUNKS || h->payload != h->count * sizeof(life_snap_chunk_t))
+		goto bad;
+	if (life_snap_sum(life_snap_sum(0, m->data, h->payload / sizeof(uint64_t)),
+			  (const uint64_t *)h, LIFE_SNAP_HEADER_WORDS) != h->checksum)
+		goto bad;
+	return 0;
+
+bad:
+	life_snap_close(m);
+	return -1;
+}
+
+void life_snap_close(life_snap_t *m)
+{
+	if (m->hdr) munmap((void *)m->hdr, m->size);
+	memset(m, 0, sizeof(*m));
+}
+
+void life_snap_rule(const life_snap_t *m, life_rule_t *rule)
+{
+	if (life_rule_make(rule, m->hdr->birth, m->hdr->survive) != 0)
+		life_rule_make(rule, LIFE_RULE_LIFE_B, LIFE_RULE_LIFE_S);
+}
+
+const uint64_t *life_snap_row(const life_snap_t *m, int y)
+{
+	return m->data + (long)y * m->hdr->words;
+}
+
+/****************************************************************************************
+ * Into the engines
+****************************************************************************************/
+int life_snap_load_bits(const life_snap_t *m, life_bits_t *g)
+{
+	life_rule_t rule;
+	int y;
+
+	if (m->hdr->kind != LIFE_SNAP_ROWS || m->hdr->width != g->width ||
+	    m->hdr->height != g->height)
+		return -1;
+	for (y=0; y<g->height; y++)
+		memcpy(LIFE_BITS_ROW(g, g->cur, y), life_snap_row(m, y), g->words * sizeof(uint64_t));
+	// the halo from the new cells, and every tile stepped next time
+	life_bits_set_wrap(g, m->hdr->wrap);
+	life_snap_rule(m, &rule);
+	life_bits_set_rule(g, &rule);
+	return 0;
+}
+
+int life_snap_load_sparse(const life_snap_t *m, life_sparse_t *s)
+{
+	const life_snap_chunk_t *c = (const life_snap_chunk_t *)m->data;
+	life_rule_t rule;
+	uint64_t k, rows[LIFE_CHUNK], any;
+	int cy, w, y;
+
+	life_sparse_clear(s);
+	if (m->hdr->kind == LIFE_SNAP_CHUNKS) {
+		for (k=0; k<m->hdr->count; k++)
+			if (life_sparse_put_chunk(s, c[k].cx, c[k].cy, c[k].row) != 0) return -1;
+	}
+	else {
+		// word w of 64 rows is chunk (w, cy)
+		for (cy=0; cy<<6 < m->hdr->height; cy++) {
+			for (w=0; w<m->hdr->words; w++) {
+				for (y=0, any=0; y<LIFE_CHUNK; y++) {
+					rows[y] = (cy << 6) + y < m->hdr->height ?
+						  life_snap_row(m, (cy << 6) + y)[w] : 0;
+					any |= rows[y];
+				}
+				if (any && life_sparse_put_chunk(s, w, cy, rows) != 0) return -1;
+			}
+		}
+	}
+	life_snap_rule(m, &rule);
+	life_sparse_set_rule(s, &rule);
+	s->generation = m->hdr->generation;
+	return 0;
+}
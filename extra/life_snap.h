@@ -0,0 +1,81 @@
+/* Binary snapshots of a universe, to stop a run and carry on later.
+ *
+ * A snapshot is a 64-byte header followed by the cells, stored the way
+ * the engines keep them, so that loading is a look at the header and a
+ * checksum pass over an mmap of the file, then straight copies:
+ *
+ *   LIFE_SNAP_ROWS    height rows of words uint64_t, 64 cells to a word
+ *                     with x = bit, as in life_bits.h without the halo
+ *   LIFE_SNAP_CHUNKS  count records of the sparse engine's 64x64 chunks,
+ *                     life_snap_chunk_t, for an unbounded universe
+ *
+ * The header holds the size, rule, border and generation count, and a
+ * checksum of everything after it and of the header itself, so a changed
+ * rule or generation count is caught as well as a changed cell.  Words are in host byte order; a
+ * snapshot from a machine of the other order fails the magic check.
+ *
+ * Writing goes to path.tmp, is flushed to the disk and then renamed over
+ * path, so a crash at any point leaves either the old snapshot or the
+ * new one, whole.
+ */
+#ifndef LIFE_SNAP_H
+#define LIFE_SNAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "life_bits.h"
+#include "life_sparse.h"
+#include "life_rule.h"
+
+#define LIFE_SNAP_MAGIC   0x504e534c    // "LSNP"
+#define LIFE_SNAP_VERSION 2     // 1 left the header out of the checksum
+
+#define LIFE_SNAP_ROWS    1
+#define LIFE_SNAP_CHUNKS  2
+
+typedef struct life_snap_header {
+	uint32_t magic, version;
+	uint32_t kind;          // LIFE_SNAP_*
+	int32_t width, height;  // rows: the universe, in cells
+	int32_t words;          // rows: words per row
+	uint16_t birth, survive;        // the rule, life_rule.h masks
+	int32_t wrap;           // rows: 1 on a torus
+	uint64_t generation;
+	uint64_t count;         // rows: height; chunks: records
+	uint64_t payload;       // bytes after the header
+	uint64_t checksum;      // of those bytes, then the header before it
+} life_snap_header_t;
+
+typedef struct life_snap_chunk {
+	int32_t cx, cy;         // chunk coordinates, see life_sparse.h
+	uint64_t row[LIFE_CHUNK];
+} life_snap_chunk_t;
+
+// an open, checked snapshot, mapped read-only
+typedef struct life_snap {
+	const life_snap_header_t *hdr;
+	const uint64_t *data;   // the payload
+	size_t size;            // of the mapping
+} life_snap_t;
+
+// width x height cells, row y at rows + y * stride words
+int  life_snap_write_rows(const char *path, const uint64_t *rows, long stride, int width,
+			  int height, int wrap, const life_rule_t *rule, uint64_t generation);
+int  life_snap_write_bits(const char *path, const life_bits_t *g, uint64_t generation);
+int  life_snap_write_sparse(const char *path, const life_sparse_t *s);
+
+// 0 on success; -1 if it cannot be read or is not a whole snapshot
+int  life_snap_open(life_snap_t *m, const char *path);
+void life_snap_close(life_snap_t *m);
+void life_snap_rule(const life_snap_t *m, life_rule_t *rule);
+
+// row y of a rows snapshot, in the mapping
+const uint64_t *life_snap_row(const life_snap_t *m, int y);
+
+// into an engine, rule and border included: a rows snapshot into a grid
+// of its size, either kind into the sparse engine (rows with cell (0, 0)
+// at the plane's origin). -1 if it does not fit
+int  life_snap_load_bits(const life_snap_t *m, life_bits_t *g);
+int  life_snap_load_sparse(const life_snap_t *m, life_sparse_t *s);
+
+#endif
@@ -0,0 +1,456 @@
+///////////////////////////////////////
+/// Sparse Game of Life engine
+/// 64x64 chunks in a hash map, only
+/// where something is alive, from a
+/// pool with a free list
+///////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "life_sparse.h"
+
+#define LIFE_SPARSE_MIN_CAP 256
+
+static const uint64_t life_sparse_zero[LIFE_CHUNK];
+
+/****************************************************************************************
+ * Chunk pool and hash map
+****************************************************************************************/
+static uint32_t life_sparse_key(int32_t cx, int32_t cy)
+{
+	uint64_t a = (uint32_t)cx | (uint64_t)(uint32_t)cy << 32;
+
+	a ^= a >> 33;
+	a *= 0xFF51AFD7ED558CCDULL;
+	a ^= a >> 33;
+	return (uint32_t)a;
+}
+
+static uint32_t life_sparse_find(const life_sparse_t *s, int32_t cx, int32_t cy)
+{
+	uint32_t i;
+
+	for (i = s->table[life_sparse_key(cx, cy) & s->mask]; i; i = s->chunk[i].next)
+		if (s->chunk[i].cx == cx && s->chunk[i].cy == cy) return i;
+	return 0;
+}
+
+// the chains of every chunk in use, into cap fresh buckets b
+static void life_sparse_rehash(life_sparse_t *s, uint32_t *b, uint32_t cap)
+{
+	uint32_t i, *head;
+
+	free(s->table);
+	s->table = b;
+	s->mask = cap - 1;
+	s->cap = cap;
+	for (i=1; i<s->top; i++) {
+		if (!s->chunk[i].used) continue;
+		head = &s->table[life_sparse_key(s->chunk[i].cx, s->chunk[i].cy) & s->mask];
+		s->chunk[i].next = *head;
+		*head = i;
+	}
+}
+
+// double the pool and the buckets; chunk pointers taken before this move
+static int life_sparse_grow(life_sparse_t *s)
+{
+	uint32_t cap = s->cap * 2, *b;
+	life_chunk_t *c;
+
+	if (cap < s->cap) return -1;
+	c = realloc(s->chunk, (size_t)cap * sizeof(life_chunk_t));
+	if (c == NULL) return -1;
+	s->chunk = c;
+	b = calloc(cap, sizeof(uint32_t));
+	if (b == NULL) return -1;
+	life_sparse_rehash(s, b, cap);
+	return 0;
+}
+
+// once fewer than a quarter of the chunks are in use, halve the pool and
+// the buckets until they are not: the chunks in use move down to the front
+// and the free list goes. Growth doubles, so halving down to twice what is
+// used leaves room before the next growth
+static void life_sparse_shrink(life_sparse_t *s)
+{
+	uint32_t cap = s->cap, i, n = 1, *b;
+	life_chunk_t *c;
+
+	while (cap > LIFE_SPARSE_MIN_CAP && s->used < cap / 4) cap /= 2;
+	if (cap == s->cap) return;
+	b = calloc(cap, sizeof(uint32_t));
+	if (b == NULL) return;
+	for (i=1; i<s->top; i++) {
+		if (!s->chunk[i].used) continue;
+		if (i != n) s->chunk[n] = s->chunk[i];
+		n++;
+	}
+	s->top = n;
+	s->free_head = 0;
+	// a failed shrink keeps the larger block, of which cap are used
+	c = realloc(s->chunk, (size_t)cap * sizeof(life_chunk_t));
+	if (c != NULL) s->chunk = c;
+	life_sparse_rehash(s, b, cap);
+}
+
+// a new empty chunk in the map, 0 if the pool cannot grow
+static uint32_t life_sparse_insert(life_sparse_t *s, int32_t cx, int32_t cy)
+{
+	uint32_t i, *b;
+	life_chunk_t *c;
+
+	if (s->free_head) {
+		i = s->free_head;
+		s->free_head = s->chunk[i].next;
+	}
+	else {
+		if (s->top == s->cap && life_sparse_grow(s) != 0) return 0;
+		i = s->top++;
+	}
+	c = &s->chunk[i];
+	memset(c->row, 0, sizeof(c->row));
+	c->cx = cx;
+	c->cy = cy;
+	c->used = 1;
+	b = &s->table[life_sparse_key(cx, cy) & s->mask];
+	c->next = *b;
+	*b = i;
+	s->used++;
+	return i;
+}
+
+static void life_sparse_remove(life_sparse_t *s, uint32_t i)
+{
+	uint32_t *b = &s->table[life_sparse_key(s->chunk[i].cx, s->chunk[i].cy) & s->mask];
+
+	while (*b != i) b = &s->chunk[*b].next;
+	*b = s->chunk[i].next;
+	s->chunk[i].used = 0;
+	s->chunk[i].next = s->free_head;
+	s->free_head = i;
+	s->used--;
+}
+
+static uint32_t life_sparse_need(life_sparse_t *s, int32_t cx, int32_t cy)
+{
+	uint32_t i = life_sparse_find(s, cx, cy);
+	return i ? i : life_sparse_insert(s, cx, cy);
+}
+
+/****************************************************************************************
+ * Allocate an empty universe
+****************************************************************************************/
+int life_sparse_init(life_sparse_t *s)
+{
+	memset(s, 0, sizeof(*s));
+	s->cap = LIFE_SPARSE_MIN_CAP;
+	s->chunk = malloc((size_t)s->cap * sizeof(life_chunk_t));
+	s->table = calloc(s->cap, sizeof(uint32_t));
+	if (s->chunk == NULL || s->table == NULL) {
+		life_sparse_free(s);
+		return -1;
+	}
+	s->mask = s->cap - 1;
+	s->top = 1;
+	life_rule_make(&s->rule, LIFE_RULE_LIFE_B, LIFE_RULE_LIFE_S);
+	return 0;
+}
+
+void life_sparse_free(life_sparse_t *s)
+{
+	free(s->chunk);
+	free(s->table);
+	memset(s, 0, sizeof(*s));
+}
+
+void life_sparse_clear(life_sparse_t *s)
+{
+	uint32_t i;
+
+	for (i=1; i<s->top; i++)
+		if (s->chunk[i].used) life_sparse_remove(s, i);
+	life_sparse_shrink(s);
+	s->generation = 0;
+}
+
+void life_sparse_set_rule(life_sparse_t *s, const life_rule_t *rule)
+{
+	s->rule = *rule;
+}
+
+/****************************************************************************************
+ * Cell access; x >> 6 and x & 63 split negative coordinates too
+****************************************************************************************/
+// or the 64 cells bits, starting at (x, y), into the plane
+static int life_sparse_or(life_sparse_t *s, int x, int y, uint64_t bits)
+{
+	int off = x & 63;
+	uint32_t i;
+
+	if (bits << off) {
+		if ((i = life_sparse_need(s, x >> 6, y >> 6)) == 0) return -1;
+		s->chunk[i].row[s->cur][y & 63] |= bits << off;
+	}
+	if (off && (bits >> (64 - off))) {
+		if ((i = life_sparse_need(s, (x >> 6) + 1, y >> 6)) == 0) return -1;
+		s->chunk[i].row[s->cur][y & 63] |= bits >> (64 - off);
+	}
+	return 0;
+}
+
+int life_sparse_set(life_sparse_t *s, int x, int y, int alive)
+{
+	uint32_t i;
+
+	if (alive) return life_sparse_or(s, x, y, 1);
+	// an emptied chunk goes with the next step
+	if ((i = life_sparse_find(s, x >> 6, y >> 6)) != 0)
+		s->chunk[i].row[s->cur][y & 63] &= ~(1ULL << (x & 63));
+	return 0;
+}
+
+int life_sparse_put_chunk(life_sparse_t *s, int cx, int cy, const uint64_t *rows)
+{
+	uint32_t i;
+	int y;
+
+	if ((i = life_sparse_need(s, cx, cy)) == 0) return -1;
+	for (y=0; y<LIFE_CHUNK; y++) s->chunk[i].row[s->cur][y] |= rows[y];
+	return 0;
+}
+
+int life_sparse_get(const life_sparse_t *s, int x, int y)
+{
+	uint32_t i = life_sparse_find(s, x >> 6, y >> 6);
+	return i ? (s->chunk[i].row[s->cur][y & 63] >> (x & 63)) & 1 : 0;
+}
+
+int life_sparse_load_bits(life_sparse_t *s, const life_bits_t *g, int x0, int y0)
+{
+	const uint64_t *p;
+	int y, w;
+
+	life_sparse_clear(s);
+	for (y=0; y<g->height; y++) {
+		p = LIFE_BITS_ROW(g, g->cur, y);
+		for (w=0; w<g->words; w++)
+			if (p[w] && life_sparse_or(s, x0 + (w << 6), y0 + y, p[w]) != 0)
+				return -1;
+	}
+	return 0;
+}
+
+/****************************************************************************************
+ * Step one chunk from its 3x3 block of chunks
+ * B3/S23 has its own copy, every other rule takes the generic kernel
+****************************************************************************************/
+#define LIFE_INLINE static inline __attribute__((always_inline))
+
+LIFE_INLINE void life_sparse_chunk(life_sparse_t *s, uint32_t i, int kernel)
+{
+	const uint64_t *nb[3][3];
+	uint64_t l[3], m[3], r[3], *out;
+	int cur = s->cur, dx, dy, y, k, yy, b;
+	uint32_t j;
+
+	for (dy=0; dy<3; dy++) {
+		for (dx=0; dx<3; dx++) {
+			j = (dx == 1 && dy == 1) ? i :
+			    life_sparse_find(s, s->chunk[i].cx + dx - 1, s->chunk[i].cy + dy - 1);
+			nb[dy][dx] = j ? s->chunk[j].row[cur] : life_sparse_zero;
+		}
+	}
+	out = s->chunk[i].row[cur ^ 1];
+
+	for (y=0; y<LIFE_CHUNK; y++) {
+		// rows y-1, y, y+1 of the left, middle and right chunks
+		for (k=0; k<3; k++) {
+			yy = y + k - 1;
+			b = 1;
+			if (yy < 0) {
+				yy = LIFE_CHUNK - 1;
+				b = 0;
+			}
+			else if (yy == LIFE_CHUNK) {
+				yy = 0;
+				b = 2;
+			}
+			l[k] = nb[b][0][yy];
+			m[k] = nb[b][1][yy];
+			r[k] = nb[b][2][yy];
+		}
+		// neighbours to the left are one bit lower, to the right one bit higher
+		if (kernel == LIFE_RULE_LIFE)
+			out[y] = life_bits_rule((m[0] << 1) | (l[0] >> 63), m[0], (m[0] >> 1) | (r[0] << 63),
+						(m[1] << 1) | (l[1] >> 63), m[1], (m[1] >> 1) | (r[1] << 63),
+						(m[2] << 1) | (l[2] >> 63), m[2], (m[2] >> 1) | (r[2] << 63));
+		else
+			out[y] = life_bits_rule_bs((m[0] << 1) | (l[0] >> 63), m[0], (m[0] >> 1) | (r[0] << 63),
+						   (m[1] << 1) | (l[1] >> 63), m[1], (m[1] >> 1) | (r[1] << 63),
+						   (m[2] << 1) | (l[2] >> 63), m[2], (m[2] >> 1) | (r[2] << 63),
+						   s->rule.birth, s->rule.survive);
+	}
+}
+
+/****************************************************************************************
+ * One generation
+****************************************************************************************/
+int life_sparse_step(life_sparse_t *s)
+{
+	uint32_t i, top;
+	uint64_t first, last, left, right, any;
+	int32_t cx, cy;
+	int y, cur = s->cur;
+	const uint64_t *p;
+
+	// an empty chunk beside every live edge and corner, where births
+	// can happen next; new chunks are empty and need no room themselves
+	top = s->top;
+	for (i=1; i<top; i++) {
+		if (!s->chunk[i].used) continue;
+		p = s->chunk[i].row[cur];
+		any = left = right = 0;
+		for (y=0; y<LIFE_CHUNK; y++) {
+			any |= p[y];
+			left |= p[y] & 1;
+			right |= p[y] >> 63;
+		}
+		if (any == 0) continue;
+		first = p[0];
+		last = p[LIFE_CHUNK-1];
+		// the pool can move under p from here on
+		cx = s->chunk[i].cx;
+		cy = s->chunk[i].cy;
+		if ((first && !life_sparse_need(s, cx, cy-1)) ||
+		    (last && !life_sparse_need(s, cx, cy+1)) ||
+		    (left && !life_sparse_need(s, cx-1, cy)) ||
+		    (right && !life_sparse_need(s, cx+1, cy)) ||
+		    ((first & 1) && !life_sparse_need(s, cx-1, cy-1)) ||
+		    ((first >> 63) && !life_sparse_need(s, cx+1, cy-1)) ||
+		    ((last & 1) && !life_sparse_need(s, cx-1, cy+1)) ||
+		    ((last >> 63) && !life_sparse_need(s, cx+1, cy+1)))
+			return -1;
+	}
+
+	s->stepped = 0;
+	for (i=1; i<s->top; i++) {
+		if (!s->chunk[i].used) continue;
+		if (s->rule.kernel == LIFE_RULE_LIFE) life_sparse_chunk(s, i, LIFE_RULE_LIFE);
+		else life_sparse_chunk(s, i, LIFE_RULE_GENERIC);
+		s->stepped++;
+	}
+	s->cur ^= 1;
+	s->generation++;
+
+	// chunks that died out go back to the pool
+	for (i=1; i<s->top; i++) {
+		if (!s->chunk[i].used) continue;
+		p = s->chunk[i].row[s->cur];
+		any = 0;
+		for (y=0; y<LIFE_CHUNK; y++) any |= p[y];
+		if (any == 0) life_sparse_remove(s, i);
+	}
+	life_sparse_shrink(s);
+	return 0;
+}
+
+/****************************************************************************************
+ * Render into a bit grid
+****************************************************************************************/
+void life_sparse_render(const life_sparse_t *s, life_bits_t *g, int x0, int y0)
+{
+	const life_chunk_t *c;
+	uint64_t *row, b;
+	long gx, gy;
+	uint32_t i;
+	int y, w, sh;
+
+	for (y=0; y<g->height; y++)
+		memset(LIFE_BITS_ROW(g, g->next, y), 0, g->words * sizeof(uint64_t));
+	for (i=1; i<s->top; i++) {
+		c = &s->chunk[i];
+		if (!c->used) continue;
+		// the chunk relative to the grid's cell (0, 0)
+		gx = (long)c->cx * LIFE_CHUNK - x0;
+		gy = (long)c->cy * LIFE_CHUNK - y0;
+		if (gx >= g->width || gy >= g->height || gx + LIFE_CHUNK <= 0 || gy + LIFE_CHUNK <= 0)
+			continue;
+		for (y=0; y<LIFE_CHUNK; y++) {
+			b = c->row[s->cur][y];
+			if (b == 0 || gy + y < 0 || gy + y >= g->height) continue;
+			row = LIFE_BITS_ROW(g, g->next, gy + y);
+			if (gx < 0) {
+				row[0] |= b >> -gx;
+				continue;
+			}
+			w = gx >> 6;
+			sh = gx & 63;
+			row[w] |= b << sh;
+			if (sh && w+1 < g->words) row[w+1] |= b >> (64 - sh);
+		}
+	}
+	life_bits_mark_next(g);
+}
+
+long life_sparse_population(const life_sparse_t *s)
+{
+	long n = 0;
+	uint32_t i;
+	int y;
+
+	for (i=1; i<s->top; i++) {
+		if (!s->chunk[i].used) continue;
+		for (y=0; y<LIFE_CHUNK; y++) n += __builtin_popcountll(s->chunk[i].row[s->cur][y]);
+	}
+	return n;
+}
+
+/****************************************************************************************
+ * Copy and compare, chunk by chunk; an empty chunk is no chunk
+****************************************************************************************/
+static int life_sparse_empty(const uint64_t *rows)
+{
+	uint64_t any = 0;
+	int y;
+
+	for (y=0; y<LIFE_CHUNK; y++) any |= rows[y];
+	return any == 0;
+}
+
+int life_sparse_copy(life_sparse_t *dst, const life_sparse_t *src)
+{
+	uint32_t i;
+
+	life_sparse_clear(dst);
+	for (i=1; i<src->top; i++) {
+		if (!src->chunk[i].used || life_sparse_empty(src->chunk[i].row[src->cur])) continue;
+		if (life_sparse_put_chunk(dst, src->chunk[i].cx, src->chunk[i].cy,
+					  src->chunk[i].row[src->cur]) != 0)
+			return -1;
+	}
+	dst->rule = src->rule;
+	dst->generation = src->generation;
+	return 0;
+}
+
+// every live chunk of a is in b with the same rows
+static int life_sparse_within(const life_sparse_t *a, const life_sparse_t *b)
+{
+	const uint64_t *rows;
+	uint32_t i, j;
+
+	for (i=1; i<a->top; i++) {
+		if (!a->chunk[i].used) continue;
+		rows = a->chunk[i].row[a->cur];
+		j = life_sparse_find(b, a->chunk[i].cx, a->chunk[i].cy);
+		if (j == 0 ? !life_sparse_empty(rows) :
+		    memcmp(rows, b->chunk[j].row[b->cur], sizeof(uint64_t) * LIFE_CHUNK) != 0)
+			return 0;
+	}
+	return 1;
+}
+
+int life_sparse_same(const life_sparse_t *a, const life_sparse_t *b)
+{
+	return life_sparse_within(a, b) && life_sparse_within(b, a);
+}
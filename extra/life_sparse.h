@@ -0,0 +1,79 @@
+/* Sparse Game of Life engine.
+ *
+ * The universe is an unbounded plane cut into 64x64-cell chunks, and only
+ * the chunks with something alive in them are stored.  A chunk keeps both
+ * generations of its cells, one uint64_t per row in the bit order of
+ * life_bits.h, and sits in a hash map keyed by its chunk coordinates:
+ * chunk (cx, cy) holds the cells x = 64*cx .. 64*cx+63, y = 64*cy ..
+ * 64*cy+63.
+ *
+ * A step first adds an empty chunk next to every live edge or corner that
+ * could give birth across it, then steps every chunk, then frees the chunks
+ * that came out empty.  So the work and the memory go with the live chunks
+ * and their neighbours, not with the area the pattern spans.  Chunks come
+ * from a pool that grows when it runs out; freed ones go on a free list and
+ * are handed out again first.  When the live chunks drop below a quarter of
+ * the pool, the pool and the hash buckets are halved, so the memory falls
+ * back after a burst instead of staying at its peak.
+ */
+#ifndef LIFE_SPARSE_H
+#define LIFE_SPARSE_H
+
+#include <stdint.h>
+#include "life_bits.h"
+#include "life_rule.h"
+
+#define LIFE_CHUNK 64
+
+typedef struct life_chunk {
+	uint64_t row[2][LIFE_CHUNK];    // both generations, x = bit
+	int32_t cx, cy;
+	uint32_t next;                  // hash chain, or free list
+	uint8_t used;                   // 0 while on the free list
+} life_chunk_t;
+
+typedef struct life_sparse {
+	life_chunk_t *chunk;    // chunk 0 is unused, index 0 means none
+	uint32_t cap;           // pool size
+	uint32_t top;           // first never-allocated index
+	uint32_t used;          // chunks in the map
+	uint32_t free_head;     // released chunks
+	uint32_t *table;        // hash buckets, at least as many as chunks
+	uint32_t mask;
+	int cur;                // row[cur] is the current generation
+	uint64_t generation;
+	long stepped;           // chunks stepped by the last step
+	life_rule_t rule;
+} life_sparse_t;
+
+int  life_sparse_init(life_sparse_t *s);
+void life_sparse_free(life_sparse_t *s);
+void life_sparse_clear(life_sparse_t *s);
+void life_sparse_set_rule(life_sparse_t *s, const life_rule_t *rule);
+
+// single cells; set fails (-1) only when no chunk can be allocated
+int  life_sparse_set(life_sparse_t *s, int x, int y, int alive);
+int  life_sparse_get(const life_sparse_t *s, int x, int y);
+
+// or the 64 rows of a whole chunk into chunk (cx, cy); -1 as for set
+int  life_sparse_put_chunk(life_sparse_t *s, int cx, int cy, const uint64_t *rows);
+
+// replace the universe with the cells of g, cell (0, 0) placed at (x0, y0)
+int  life_sparse_load_bits(life_sparse_t *s, const life_bits_t *g, int x0, int y0);
+
+// one generation; 0 on success, -1 if the pool could not grow
+int  life_sparse_step(life_sparse_t *s);
+
+// write the window (x0, y0)..(x0+w-1, y0+h-1) into g->next, flagging the
+// tiles that differ from g->cur in g->dirty_next, ready for life_bits_swap
+void life_sparse_render(const life_sparse_t *s, life_bits_t *g, int x0, int y0);
+
+long life_sparse_population(const life_sparse_t *s);
+
+// dst becomes a copy of src's current generation, rule and generation
+// count; -1 if dst's pool could not grow
+int  life_sparse_copy(life_sparse_t *dst, const life_sparse_t *src);
+// the same live cells
+int  life_sparse_same(const life_sparse_t *a, const life_sparse_t *b);
+
+#endif
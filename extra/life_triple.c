@@ -0,0 +1,73 @@
+///////////////////////////////////////
+/// Lock-free triple buffer, one writer
+/// and one reader
+///////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "life_triple.h"
+
+int life_triple_init(life_triple_t *t, size_t size)
+{
+	int k;
+
+	memset(t, 0, sizeof(*t));
+	t->size = size;
+	for (k=0; k<3; k++) {
+		t->buf[k] = calloc(1, size);
+		if (t->buf[k] == NULL) {
+			life_triple_free(t);
+			return -1;
+		}
+	}
+	t->front = 0;
+	t->middle = 1;
+	t->back = 2;
+	return 0;
+}
+
+void life_triple_free(life_triple_t *t)
+{
+	int k;
+
+	for (k=0; k<3; k++) free(t->buf[k]);
+	memset(t, 0, sizeof(*t));
+}
+
+void *life_triple_back(life_triple_t *t)
+{
+	return t->buf[t->back];
+}
+
+/****************************************************************************************
+ * Swap the filled back buffer into the middle
+ * release, so the contents are visible before the index; acquire, so
+ * the reader is done with the buffer that comes back
+****************************************************************************************/
+void life_triple_publish(life_triple_t *t)
+{
+	int old = __atomic_exchange_n(&t->middle, t->back | LIFE_TRIPLE_FRESH, __ATOMIC_ACQ_REL);
+	t->back = old & 3;
+}
+
+int life_triple_pending(life_triple_t *t)
+{
+	return (__atomic_load_n(&t->middle, __ATOMIC_ACQUIRE) & LIFE_TRIPLE_FRESH) != 0;
+}
+
+/****************************************************************************************
+ * Swap a freshly published middle buffer out to the front
+ * only the writer sets the fresh flag, so once it is seen the exchange is
+ * sure to bring back a published buffer
+****************************************************************************************/
+void *life_triple_front(life_triple_t *t, int *fresh)
+{
+	int old;
+
+	*fresh = 0;
+	if (__atomic_load_n(&t->middle, __ATOMIC_ACQUIRE) & LIFE_TRIPLE_FRESH) {
+		old = __atomic_exchange_n(&t->middle, t->front, __ATOMIC_ACQ_REL);
+		t->front = old & 3;
+		*fresh = 1;
+	}
+	return t->buf[t->front];
+}
@@ -0,0 +1,43 @@
+/* Lock-free triple buffer.
+ *
+ * One writer hands whole snapshots to one reader through three buffers of
+ * the same size.  The writer fills its back buffer and publishes it, which
+ * swaps it with the middle one; the reader takes the middle one whenever it
+ * is newer than its own front buffer, swapping those two.  Each swap is one
+ * atomic exchange of the middle index, so neither side ever waits for the
+ * other, and the reader only ever sees buffers the writer has finished.
+ *
+ * The reader gets the newest published snapshot and skips any it was too
+ * slow to see; a writer that wants to save the copy can check
+ * life_triple_pending() and not publish again until the last one was taken.
+ */
+#ifndef LIFE_TRIPLE_H
+#define LIFE_TRIPLE_H
+
+#include <stddef.h>
+
+#define LIFE_TRIPLE_FRESH 4     // in middle: published, not yet taken
+
+typedef struct life_triple {
+	void *buf[3];
+	size_t size;
+	int back;               // the writer's buffer
+	int middle;             // the one in between, swapped atomically
+	int front;              // the reader's buffer
+} life_triple_t;
+
+// three zeroed buffers of size bytes
+int  life_triple_init(life_triple_t *t, size_t size);
+void life_triple_free(life_triple_t *t);
+
+// writer: the buffer to fill, then hand it over
+void *life_triple_back(life_triple_t *t);
+void  life_triple_publish(life_triple_t *t);
+// writer: 1 while the last published buffer has not been taken
+int   life_triple_pending(life_triple_t *t);
+
+// reader: the newest published buffer; *fresh is 1 when it was
+// published since the last call (the buffer is zeroed before any)
+void *life_triple_front(life_triple_t *t, int *fresh);
+
+#endif
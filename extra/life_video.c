@@ -3,7 +3,7 @@
 /// This code will segfault the original
 /// DE1 computer
 /// compile with
-/// gcc life_video_2.c -o life -O2
+/// gcc life_video.c life_byte.c life_rule.c vga_fill.c vga_hud.c vga_raster.c -I.. -o life -O2
 /// -- no optimization yields ??? execution time
 /// -- opt -O1 yields ??? mS execution time
 /// -- opt -O2 yields ??? mS execution time
@@ -19,19 +19,18 @@
 #include <sys/mman.h>
 #include <sys/time.h> 
 #include "address_map_arm_brl4.h"
+#include "life_byte.h"
+#include "vga_hud.h"
+#include "vga_raster.h"
 
 /* function prototypes */
-void VGA_text (int, int, char *);
-void VGA_text_clear();
-void VGA_box (int, int, int, int, short);
-void VGA_line(int, int, int, int, short) ;
-void VGA_disc (int, int, int, short);
 
 // the light weight buss base
 void *h2p_lw_virtual_base;
 
 // pixel buffer
 volatile unsigned int * vga_pixel_ptr = NULL ;
+vga_raster_t raster;
 void *vga_pixel_virtual_base;
 
 // character buffer
@@ -57,13 +56,15 @@ char shared_str[64];
 } while(0)
 	
 
-// game of life array
-// bottom bit is current state
-// next bit is next state
-char life[640][480] ;
-char life_new[640][480] ;
+// game of life array, one char per cell, row-major.
+// the universe is the screen minus its outer ring:
+// the ring that used to stay dead is the grid's halo
+#define LIFE_X0 1
+#define LIFE_Y0 1
+#define LIFE_W  638
+#define LIFE_H  478
+life_byte_t life ;
 int i, j, count, total_count;
-int sum ;
 
 // measure time
 struct timeval t1, t2;
@@ -127,21 +128,27 @@ int main(void)
     
     // Get the address that maps to the FPGA pixel buffer
 	vga_pixel_ptr =(unsigned int *)(vga_pixel_virtual_base);
+	vga_raster_init(&raster, vga_pixel_ptr, 1024, 640, 480, 1);
 
 	// ===========================================
 
+	if (life_byte_init(&life, LIFE_W, LIFE_H, LIFE_KERNEL_AUTO) != 0) {
+		printf( "ERROR: could not allocate the life grid...\n" );
+		return(1);
+	}
+
 	/* create a message to be displayed on the VGA 
           and LCD displays */
 	char text_top_row[40] = "DE1-SoC ARM/FPGA\0";
 	char text_bottom_row[40] = "Cornell ece5760\0";
 	char num_string[20], time_string[20] ;
 
-	//VGA_text (34, 1, text_top_row);
-	//VGA_text (34, 2, text_bottom_row);
+	//vga_hud_write(vga_char_ptr, 34, 1, text_top_row);
+	//vga_hud_write(vga_char_ptr, 34, 2, text_bottom_row);
 	// clear the screen
-	VGA_box (0, 0, 639, 479, 0x00);
+	vga_raster_box(&raster, 0, 0, 639, 479, 0x00);
 	// clear the text
-	VGA_text_clear();
+	vga_hud_blank(vga_char_ptr);
 	
 	// start timer
     //gettimeofday(&t1, NULL);
@@ -150,13 +157,13 @@ int main(void)
 	total_count = 0 ;
 	
 	// init a small pattern
-	// life[320][240] = 1;
-	// life[319][240] = 1;
-	// life[321][240] = 1;
-	// life[319][241] = 1;
-	// life[319][242] = 1;
-	// life[321][241] = 1;
-	// life[321][242] = 1;
+	// life_byte_set(&life, 320-LIFE_X0, 240-LIFE_Y0, 1);
+	// life_byte_set(&life, 319-LIFE_X0, 240-LIFE_Y0, 1);
+	// life_byte_set(&life, 321-LIFE_X0, 240-LIFE_Y0, 1);
+	// life_byte_set(&life, 319-LIFE_X0, 241-LIFE_Y0, 1);
+	// life_byte_set(&life, 319-LIFE_X0, 242-LIFE_Y0, 1);
+	// life_byte_set(&life, 321-LIFE_X0, 241-LIFE_Y0, 1);
+	// life_byte_set(&life, 321-LIFE_X0, 242-LIFE_Y0, 1);
 	
 	
 	gettimeofday(&t1,NULL);
@@ -167,43 +174,37 @@ int main(void)
 	// init the main state array
 	for (i=50; i<589; i++) {
 		for (j=50; j<459; j++) {
-			life[i][j] = (rand() & 0xb11) == 1 ;
-			if (i==320) life[i][j] = 1;
-			if (j==240) life[i][j] = 1;
+			life_byte_set(&life, i-LIFE_X0, j-LIFE_Y0,
+				      (rand() & 0xb11) == 1 || i==320 || j==240);
+		}
+	}
+	// draw the seeded generation once; from here on only changes are drawn
+	for (j=0; j<LIFE_H; j++) {
+		char *row = (char *)LIFE_BYTE_ROW(&life, life.cur, j);
+		for (i=0; i<LIFE_W; i++) {
+			if (row[i]) VGA_PIXEL(LIFE_X0+i, LIFE_Y0+j, 0xff);
 		}
 	}
 	
 	while(1) 
 	{
 		 gettimeofday(&t1, NULL);
-		//leave the edges at zero for all time 
-		for (i=1; i<639; i++) {
-			for (j=1; j<479; j++) {
-				sum = life[i-1][j-1] + life[i][j-1] + life[i+1][j-1] +
-				      life[i-1][j]                  + life[i+1][j] +
-					  life[i-1][j+1] + life[i][j+1] + life[i+1][j+1] ;
-				if (sum == 3) {
-					VGA_PIXEL(i,j,0xff);
-					life_new[i][j] = 1;
-				}
-				else if (sum == 2) {
-					life_new[i][j] = life[i][j] ;
-				}
-				else {
-					life_new[i][j] = 0;
-					VGA_PIXEL(i,j,0x00);
-				}
+		// step every row, then write out the changed cells
+		// row by row, the same order as the pixel buffer
+		life_byte_step_rows(&life, 0, LIFE_H);
+		for (j=0; j<LIFE_H; j++) {
+			char *old = (char *)LIFE_BYTE_ROW(&life, life.cur, j);
+			char *new = (char *)LIFE_BYTE_ROW(&life, life.next, j);
+			for (i=0; i<LIFE_W; i++) {
+				if (old[i] != new[i])
+					VGA_PIXEL(LIFE_X0+i, LIFE_Y0+j, 0xff*new[i]);
 			}
 		}
 		
 		// update the main state array
-		for (i=1; i<639; i++) {
-			for (j=1; j<479; j++) {
-				life[i][j] = life_new[i][j] ;
-			}
-		}
-		//VGA_text (10, 1, text_top_row);
-	    //VGA_text (10, 2, text_bottom_row);
+		life_byte_swap(&life);
+		//vga_hud_write(vga_char_ptr, 10, 1, text_top_row);
+	    //vga_hud_write(vga_char_ptr, 10, 2, text_bottom_row);
 		
 		// stop timer
 		 gettimeofday(&t2, NULL);
@@ -211,195 +212,8 @@ int main(void)
 		 elapsedTime += (t2.tv_usec - t1.tv_usec) / 1000.0;   // us to ms
 		// sprintf(num_string, "# = %d     ", total_count);
 		 sprintf(time_string, "T = %3.0f mSec  ", elapsedTime);
-		// VGA_text (10, 3, num_string);
-		 VGA_text (10, 4, time_string);
+		// vga_hud_write(vga_char_ptr, 10, 3, num_string);
+		 vga_hud_write(vga_char_ptr, 10, 4, time_string);
 		
 	} // end while(1)
 } // end main
-
-/****************************************************************************************
- * Subroutine to send a string of text to the VGA monitor 
-****************************************************************************************/
-void VGA_text(int x, int y, char * text_ptr)
-{
-  	volatile char * character_buffer = (char *) vga_char_ptr ;	// VGA character buffer
-	int offset;
-	/* assume that the text string fits on one line */
-	offset = (y << 7) + x;
-	while ( *(text_ptr) )
-	{
-		// write to the character buffer
-		*(character_buffer + offset) = *(text_ptr);	
-		++text_ptr;
-		++offset;
-	}
-}
-
-/****************************************************************************************
- * Subroutine to clear text to the VGA monitor 
-****************************************************************************************/
-void VGA_text_clear()
-{
-  	volatile char * character_buffer = (char *) vga_char_ptr ;	// VGA character buffer
-	int offset, x, y;
-	for (x=0; x<70; x++){
-		for (y=0; y<40; y++){
-	/* assume that the text string fits on one line */
-			offset = (y << 7) + x;
-			// write to the character buffer
-			*(character_buffer + offset) = ' ';		
-		}
-	}
-}
-
-/****************************************************************************************
- * Draw a filled rectangle on the VGA monitor 
-****************************************************************************************/
-#define SWAP(X,Y) do{int temp=X; X=Y; Y=temp;}while(0) 
-
-void VGA_box(int x1, int y1, int x2, int y2, short pixel_color)
-{
-	char  *pixel_ptr ; 
-	int row, col;
-
-	/* check and fix box coordinates to be valid */
-	if (x1>639) x1 = 639;
-	if (y1>479) y1 = 479;
-	if (x2>639) x2 = 639;
-	if (y2>479) y2 = 479;
-	if (x1<0) x1 = 0;
-	if (y1<0) y1 = 0;
-	if (x2<0) x2 = 0;
-	if (y2<0) y2 = 0;
-	if (x1>x2) SWAP(x1,x2);
-	if (y1>y2) SWAP(y1,y2);
-	for (row = y1; row <= y2; row++)
-		for (col = x1; col <= x2; ++col)
-		{
-			//640x480
-			pixel_ptr = (char *)vga_pixel_ptr + (row<<10)    + col ;
-			// set pixel color
-			*(char *)pixel_ptr = pixel_color;		
-		}
-}
-
-/****************************************************************************************
- * Draw a filled circle on the VGA monitor 
-****************************************************************************************/
-
-void VGA_disc(int x, int y, int r, short pixel_color)
-{
-	char  *pixel_ptr ; 
-	int row, col, rsqr, xc, yc;
-	
-	rsqr = r*r;
-	
-	for (yc = -r; yc <= r; yc++)
-		for (xc = -r; xc <= r; xc++)
-		{
-			col = xc;
-			row = yc;
-			// add the r to make the edge smoother
-			if(col*col+row*row <= rsqr+r){
-				col += x; // add the center point
-				row += y; // add the center point
-				//check for valid 640x480
-				if (col>639) col = 639;
-				if (row>479) row = 479;
-				if (col<0) col = 0;
-				if (row<0) row = 0;
-				pixel_ptr = (char *)vga_pixel_ptr + (row<<10) + col ;
-				// set pixel color
-				*(char *)pixel_ptr = pixel_color;
-			}
-					
-		}
-}
-
-// =============================================
-// === Draw a line
-// =============================================
-//plot a line 
-//at x1,y1 to x2,y2 with color 
-//Code is from David Rodgers,
-//"Procedural Elements of Computer Graphics",1985
-void VGA_line(int x1, int y1, int x2, int y2, short c) {
-	int e;
-	signed int dx,dy,j, temp;
-	signed int s1,s2, xchange;
-     signed int x,y;
-	char *pixel_ptr ;
-	
-	/* check and fix line coordinates to be valid */
-	if (x1>639) x1 = 639;
-	if (y1>479) y1 = 479;
-	if (x2>639) x2 = 639;
-	if (y2>479) y2 = 479;
-	if (x1<0) x1 = 0;
-	if (y1<0) y1 = 0;
-	if (x2<0) x2 = 0;
-	if (y2<0) y2 = 0;
-        
-	x = x1;
-	y = y1;
-	
-	//take absolute value
-	if (x2 < x1) {
-		dx = x1 - x2;
-		s1 = -1;
-	}
-
-	else if (x2 == x1) {
-		dx = 0;
-		s1 = 0;
-	}
-
-	else {
-		dx = x2 - x1;
-		s1 = 1;
-	}
-
-	if (y2 < y1) {
-		dy = y1 - y2;
-		s2 = -1;
-	}
-
-	else if (y2 == y1) {
-		dy = 0;
-		s2 = 0;
-	}
-
-	else {
-		dy = y2 - y1;
-		s2 = 1;
-	}
-
-	xchange = 0;   
-
-	if (dy>dx) {
-		temp = dx;
-		dx = dy;
-		dy = temp;
-		xchange = 1;
-	} 
-
-	e = ((int)dy<<1) - dx;  
-	 
-	for (j=0; j<=dx; j++) {
-		//video_pt(x,y,c); //640x480
-		pixel_ptr = (char *)vga_pixel_ptr + (y<<10)+ x; 
-		// set pixel color
-		*(char *)pixel_ptr = c;	
-		 
-		if (e>=0) {
-			if (xchange==1) x = x + s1;
-			else y = y + s2;
-			e = e - ((int)dx<<1);
-		}
-
-		if (xchange==1) y = y + s2;
-		else x = x + s1;
-
-		e = e + ((int)dy<<1);
-	}
-}
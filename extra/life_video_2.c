@@ -3,7 +3,80 @@
 /// This code will segfault the original
 /// DE1 computer
 /// compile with
-/// gcc life_video_2.c -o life -O2
+/// gcc life_video_2.c life_bits.c life_byte.c life_pool.c life_hash.c life_sparse.c life_rule.c life_pattern.c life_view.c life_triple.c life_feed.c life_snap.c life_cycle.c life_queue.c life_check.c vga_span.c vga_fill.c vga_hud.c vga_raster.c ../vga_dev.c ../mouse_dev.c -I.. -o life -O2 -mfpu=neon -pthread
+/// usage: life [-e bits|byte|hash|sparse] [-k auto|scalar|sse2|avx2|neon] [-t threads] [-f] [-c]
+///             [-s log2_gens] [-j gens] [-m nodes] [-r rule] [-w 4|8] [-n gens]
+///             [-u WxH] [-b dead|torus] [-v x,y] [-z zoom] [-p hz] [-g slots[,hz]]
+///             [-l pattern] [-o x,y[,orient]] [-W file] [-S snapshot] [-C gens] [-H]
+///             [-d stop|idle|jump[,history]] [-i mouse]
+///   -e picks the engine (hash and sparse are unbounded, and draw
+///      the universe's window onto their plane), -k the byte engine kernel,
+///   -t the number of stepping threads (default: one per online CPU),
+///   -f steps every tile of the bits engine, not just the active ones,
+///   -c runs the self-check and exits,
+///   -s advances the hash engine 2^log2_gens generations per frame,
+///   -j first jumps the hash engine ahead by gens generations,
+///   -m caps the hash engine at that many quadtree nodes,
+///   -r sets a Life-like rule, "B36/S23" or a preset name,
+///   -w sets the width of the pixel buffer stores in bytes (default 4),
+///   -n stops after that many generations (default: run forever); the
+///      hash engine's last -s step is cut short to land on it,
+///   -u sets the size of the universe in cells (default 638x478,
+///      the screen inside its border), up to the memory there is,
+///   -b dead holds everything outside the universe dead, torus joins
+///      its opposite edges (bits and byte engines only),
+///   -v puts universe cell x,y at the top left of the screen (default -1,-1),
+///   -z shows every cell as zoom x zoom pixels, -z -N every NxN block of
+///      cells as one pixel, shaded grey by how many are alive (the byte
+///      engine shows every Nth cell instead when -p 0)
+///   -p steps as fast as it can and draws the newest generation hz
+///      times a second from a render thread (default 60); -p 0 steps
+///      and draws in turn, every generation drawn
+///   -g keeps the last generations in a ring of slots in shared memory
+///      for other processes (off unless given), every one of them, or
+///      with hz only two in a row, so a reader can check the step between
+///      them, up to hz times a second and the last one on the way out;
+///      see life_feed.h and life_feed_reader.c
+///   -l seeds the universe with an RLE or plaintext (.cells) pattern file
+///      instead of the four glider guns, and takes its rule unless -r
+///      gives one,
+///   -o puts the pattern's top left at universe cell x,y (default: the
+///      pattern centred), turned by orient 0..7: 1 mirrors left-right,
+///      2 top-bottom, 4 swaps x and y first (see life_pattern.h),
+///   -W writes the last generation to file on the way out, as plaintext
+///      if the name ends in .cells and as RLE otherwise,
+///   -S carries on from a binary snapshot (see life_snap.h) when the file
+///      is there, with its size, border, rule and generation count and
+///      instead of the pattern, and writes one there on the way out,
+///   -C also writes the -S snapshot every gens generations (not with
+///      the hash engine, whose quadtree is not saved),
+///   -H runs headless: no board or DE1_SIM, nothing drawn; the engine
+///      steps flat out
+///      for the -n generations (or until SIGINT or SIGTERM, which still
+///      write -W and -S), and a summary goes to stdout at the end. without
+///      -r the rule is Life, or the pattern's or snapshot's,
+///   -d watches for the universe repeating an earlier generation, one
+///      of the last history (default 64), and prints the period when it
+///      does; then stop ends the run as -n would, idle stops stepping
+///      and waits for SIGINT or SIGTERM (the keys still pan), and jump
+///      steps one period more, and once the cells are the same again
+///      skips whole periods towards the -n'th generation and steps the
+///      rest (without -n it goes on stepping). not with the hash engine,
+///   -i edits the running universe with the mouse at that device
+///      (/dev/input/mice, or a FIFO of packets, see ../mouse_dev.h): the
+///      left button flips the cell under the red cursor and paints cells
+///      alive while held, the right one stamps a glider gun, the middle
+///      one the pi heptomino, right while left is held clears everything.
+///      the edits go in between two generations; the time from the
+///      mouse to the screen is shown, and summed up at the end. not with
+///      the hash engine, nor headless
+/// KEY0..KEY3 pan the view right, left, down and up while held
+/// without -r the rule is the preset numbered by SW[3:0] (0 is Life),
+/// and flipping the switches changes it while running
+/// with DE1_SIM set it runs without the board, see ../vga_dev.h:
+///   DE1_SIM=/tmp/de1 DE1_SW=1 ./life -n 1000
+/// and with -H without any screen at all, e.g. a day's run in stages:
+///   ./life -H -e sparse -l gun.rle -n 100000000 -S run.snap -C 1000000
 /// -- no optimization yields ??? execution time
 /// -- opt -O1 yields ??? mS execution time
 /// -- opt -O2 yields ??? mS execution time
@@ -19,18 +92,85 @@
 #include <sys/shm.h> 
 #include <sys/mman.h>
 #include <sys/time.h> 
+#include <sys/stat.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <assert.h>
 #include "address_map_arm_brl4.h"
+#include "vga_dev.h"
+#include "life_bits.h"
+#include "life_byte.h"
+#include "life_pool.h"
+#include "life_hash.h"
+#include "life_sparse.h"
+#include "life_rule.h"
+#include "life_pattern.h"
+#include "life_view.h"
+#include "life_triple.h"
+#include "life_feed.h"
+#include "life_snap.h"
+#include "life_cycle.h"
+#include "life_queue.h"
+#include "mouse_dev.h"
+#include "vga_span.h"
+#include "vga_fill.h"
+#include "vga_hud.h"
+#include "vga_raster.h"
+#include "life_check.h"
 
 /* function prototypes */
-void VGA_text (int, int, char *);
-void VGA_text_clear();
-void VGA_box (int, int, int, int, short);
-void VGA_line(int, int, int, int, short) ;
-void VGA_disc (int, int, int, short);
-void glider_gun(int, int, int, int);
+void cell_set(void *, int, int, int);
+void bits_set(void *, int, int, int);
+void sparse_set(void *, int, int, int);
+void life_set(int, int, int);
+int life_get(int, int);
+int cell_get(void *, int, int);
+int seed_pattern(void);
+int save_pattern(void);
+int resume_snapshot(void);
+int save_snapshot(void);
+int wrap_coord(int, int);
+int view_range(int, int, int, int *, int *);
+int view_single(void);
+void draw_view(void);
+void view_publish(void);
+void draw_cell(int, int, int);
+void draw_changes_bits(void);
+void draw_changes_byte(void);
+void set_rule(const life_rule_t *);
+void step_bits_band(void *, int, int);
+void step_byte_band(void *, int, int);
+long pack_generation(uint64_t *, int);
+uint64_t generation(void);
+void publish_frame(double);
+void *render_main(void *);
+void stop_run(int);
+void print_summary(double);
+uint64_t population(void);
+void hud_status(vga_hud_line_t *, double, uint64_t);
+uint64_t cycle_hash(void);
+void cycle_forget(void);
+void cycle_found(void);
+void cycle_confirm(void);
+uint64_t now_ns(void);
+void *input_main(void *);
+void post_edit(int, int, int, int, const char *);
+int apply_edits(void);
+void edit_set(void *, int, int, int);
+int edit_get(int, int);
+void edit_clear(void);
+void edit_shown(uint64_t);
+void cursor_hide(void);
+void cursor_show(void);
 
 // the light weight buss base
 void *h2p_lw_virtual_base;
+// switches
+volatile unsigned int * sw_ptr = NULL ;
+// push buttons
+volatile unsigned int * key_ptr = NULL ;
 
 // pixel buffer
 volatile unsigned int * vga_pixel_ptr = NULL ;
@@ -40,16 +180,33 @@ void *vga_pixel_virtual_base;
 volatile unsigned int * vga_char_ptr = NULL ;
 void *vga_char_virtual_base;
 
-// /dev/mem file id
-int fd;
+// /dev/mem, or the simulated backend
+vga_dev_t dev;
 
-// shared memory 
+// shared memory: generations, packed, for other processes to read,
+// see life_feed.h. packing the universe costs about as much as a step:
+// with feed_hz it is done that many times a second, for a pair of
+// generations in a row, not for every one
 key_t mem_key=0xf0;
-int shared_mem_id; 
-int *shared_ptr;
-int shared_time;
-int shared_note;
-char shared_str[64];
+life_feed_t feed;
+int feed_slots = 0, feed_hz = 0;
+uint64_t feed_at = 0 ;
+int feed_pair = 0 ;
+// the mouse changed the cells since the last generation fed
+int feed_edited = 0 ;
+
+// changed cells go through a shadow screen and reach the
+// pixel buffer as aligned 32-bit words, see vga_span.h
+vga_span_t span;
+int span_word = 4;
+// the text goes through a shadow of the character buffer, and the
+// status lines are rewritten at most HUD_HZ times a second
+#define HUD_HZ 30
+vga_hud_t hud;
+uint64_t hud_at = 0 ;
+// boxes, lines and discs, see vga_raster.h
+vga_raster_t raster;
+long long frames = -1;
 
 // pixel macro
 #define VGA_PIXEL(x,y,color) do{\
@@ -59,92 +216,414 @@ char shared_str[64];
 } while(0)
 	
 
-// game of life array
-// bottom bit is current state
-// next bit is next state
-char life[640][480] ; //char life[640][480] ;
-char life_new[640][480] ;
-int i, j, count, total_count;
-int sum ;
-
-// measure time
-struct timeval t1, t2;
-double elapsedTime;
+// game of life state: 64 cells per word,
+// or the original one char per cell,
+// or an unbounded hashlife quadtree drawn through the bits grid,
+// or unbounded 64x64 chunks, also drawn through the bits grid
+#define ENGINE_BITS   0
+#define ENGINE_BYTE   1
+#define ENGINE_HASH   2
+#define ENGINE_SPARSE 3
+int engine = ENGINE_BITS ;
+int kernel = LIFE_KERNEL_AUTO ;
+life_bits_t life ;
+life_byte_t life_b ;
+life_hash_t life_h ;
+life_sparse_t life_s ;
+int hash_step = 0 ;
+unsigned long long hash_jump = 0 ;
+unsigned int hash_nodes = 0 ;
+
+// B/S rule, from -r or the switches
+life_rule_t rule ;
+unsigned int sw_rule ;
+char rule_string[40] ;
+
+// the universe can be any size, with dead edges or joined into a
+// torus. by default it is the screen minus its outer ring: the ring
+// that used to be held dead for all time is the engines' dead halo
+#define LIFE_X0 1
+#define LIFE_Y0 1
+#define LIFE_W  638
+#define LIFE_H  478
+int uni_w = LIFE_W, uni_h = LIFE_H ;
+int wrap = 0 ;
+
+// the pattern to start from, or the four glider guns, and
+// where to write the last generation
+char *pattern_path = NULL, *save_path = NULL;
+life_pattern_info_t pattern_info;
+int pattern_x, pattern_y, pattern_orient = 0, pattern_placed = 0;
+
+// -S: a snapshot to carry on from and to write, every snapshot_every
+// generations too; gen0 is the generation it was taken at
+char *snapshot_path = NULL;
+long snapshot_every = 0;
+life_snap_t resume;
+uint64_t gen0 = 0;
+
+// the screen is a window onto the universe: cell (view_x, view_y) at
+// the top left, zoom x zoom pixels per cell, or every -zoom'th cell.
+// the thread that draws owns view_x and view_y and pans them; the origin
+// of what is on the screen goes to view_shown, x high and y low, for the
+// input thread to read both halves at once
+int view_x = -LIFE_X0, view_y = -LIFE_Y0, zoom = 1 ;
+uint64_t view_shown = 0 ;
+
+// simulation and display: the main thread steps, a render thread takes
+// the newest finished generation through a triple buffer pace times a
+// second and draws what changed; with pace 0 they take turns instead
+typedef struct {
+	uint64_t gen;           // generations stepped
+	uint64_t edited;        // posted time of the oldest edit new in it, or 0
+	char status[VGA_HUD_COLS + 1];  // status line of that generation
+	uint64_t cells[];       // rows in life_bits_t layout, snap.stride apart
+} frame_t;
+int pace = 60 ;
+life_triple_t triple ;
+life_bits_t snap ;              // the layout of frame_t cells, for drawing
+pthread_t render_tid ;
+int sim_done = 0 ;
+
+// -H: no screen, no board; stop_flag is raised by SIGINT and SIGTERM
+int headless = 0 ;
+volatile sig_atomic_t stop_flag = 0 ;
+
+// -d: what to do once the universe repeats itself; cycle_h is the hash
+// of the current generation, cycle_skip the generations jumped over
+#define CYCLE_OFF  0
+#define CYCLE_STOP 1
+#define CYCLE_IDLE 2
+#define CYCLE_JUMP 3
+int cycle_action = CYCLE_OFF, cycle_history = 64 ;
+life_cycle_t cycle ;
+uint64_t cycle_h = 0 ;
+long cycle_skip = 0 ;
+int cycle_done = 0 ;
+// -d jump: the cells of the generation whose hash matched, kept until
+// one period later, cycle_check, when they have to be back before any
+// generation is skipped; packed twice over, then and now, or a plane
+uint64_t *cycle_cells = NULL ;
+life_sparse_t cycle_s ;
+uint64_t cycle_check = 0 ;
+
+// -i: the input thread turns mouse packets into edits on the queue, the
+// stepping thread applies them between generations, and whichever thread
+// draws times them from the oldest post in a batch to the frame that
+// shows it. cursor is (sy << 16) | sx on the screen, -1 before any move
+char *mouse_path = NULL ;
+mouse_dev_t mouse ;
+life_queue_t edits ;
+pthread_t input_tid ;
+int input_stop = 0 ;
+int cursor = -1 ;
+int cursor_shown = 0, cursor_at, cursor_under ;
+uint64_t edit_oldest = 0 ;
+long edit_batches = 0 ;
+double edit_last_ms = 0, edit_max_ms = 0, edit_sum_ms = 0 ;
+
+// stepping threads, split in bands of rows
+int threads = 0 ;
+life_pool_t pool ;
+int full_scan = 0 ;
+int i, j, total_count;
+long long count;
+
+// measure time: the step, then drawing it
+uint64_t loop_t0, loop_t1, loop_t2;
+double elapsedTime, step_ms, draw_ms;
 	
-int main(void)
+int main(int argc, char **argv)
 {
 	//int x1, y1, x2, y2;
+	int opt, check = 0, rule_given = 0, resumed = 0, redraw = 0, pan, keys, window;
+	int last;
+	long long gens = 1;
+	life_feed_meta_t meta;
+	vga_hud_line_t line;
+	struct timespec run_t0, run_t1;
+	struct sigaction sa;
+
+	// === command line ========================
+	while ((opt = getopt(argc, argv, "e:k:t:fcs:j:m:r:w:n:u:b:v:z:p:g:l:o:W:S:C:Hd:i:")) != -1) {
+		switch (opt) {
+		case 'e':
+			if (strcmp(optarg, "bits") == 0) engine = ENGINE_BITS;
+			else if (strcmp(optarg, "byte") == 0) engine = ENGINE_BYTE;
+			else if (strcmp(optarg, "hash") == 0) engine = ENGINE_HASH;
+			else if (strcmp(optarg, "sparse") == 0) engine = ENGINE_SPARSE;
+			else {
+				printf( "ERROR: unknown engine \"%s\"...\n", optarg );
+				return(1);
+			}
+			break;
+		case 'k':
+			kernel = life_byte_kernel_lookup(optarg);
+			if (kernel < LIFE_KERNEL_AUTO || !(kernel == LIFE_KERNEL_AUTO ||
+					life_byte_kernel_available(kernel))) {
+				printf( "ERROR: kernel \"%s\" not available...\n", optarg );
+				return(1);
+			}
+			break;
+		case 't':
+			threads = atoi(optarg);
+			break;
+		case 'f':
+			full_scan = 1;
+			break;
+		case 'c':
+			check = 1;
+			break;
+		case 's':
+			hash_step = atoi(optarg);
+			if (hash_step < 0 || hash_step > LIFE_HASH_MAX_LEVEL - 3) {
+				printf( "ERROR: -s takes 0..%d...\n", LIFE_HASH_MAX_LEVEL - 3 );
+				return(1);
+			}
+			break;
+		case 'j':
+			hash_jump = strtoull(optarg, NULL, 0);
+			break;
+		case 'm':
+			hash_nodes = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			if (life_rule_parse(&rule, optarg) != 0) {
+				printf( "ERROR: bad rule \"%s\"...\n", optarg );
+				return(1);
+			}
+			rule_given = 1;
+			break;
+		case 'w':
+			span_word = atoi(optarg);
+			break;
+		case 'n':
+			frames = atoll(optarg);
+			break;
+		case 'u':
+			if (sscanf(optarg, "%dx%d", &uni_w, &uni_h) != 2 || uni_w < 1 || uni_h < 1) {
+				printf( "ERROR: bad universe size \"%s\"...\n", optarg );
+				return(1);
+			}
+			break;
+		case 'b':
+			if (strcmp(optarg, "dead") == 0) wrap = 0;
+			else if (strcmp(optarg, "torus") == 0) wrap = 1;
+			else {
+				printf( "ERROR: unknown border \"%s\"...\n", optarg );
+				return(1);
+			}
+			break;
+		case 'v':
+			if (sscanf(optarg, "%d,%d", &view_x, &view_y) != 2) {
+				printf( "ERROR: bad view origin \"%s\"...\n", optarg );
+				return(1);
+			}
+			break;
+		case 'z':
+			zoom = atoi(optarg);
+			if (zoom == 0 || zoom == -1) zoom = 1;
+			break;
+		case 'p':
+			pace = atoi(optarg);
+			if (pace < 0) pace = 0;
+			break;
+		case 'g':
+			if (sscanf(optarg, "%d,%d", &feed_slots, &feed_hz) < 1 || feed_hz < 0) {
+				printf( "ERROR: bad feed \"%s\"...\n", optarg );
+				return(1);
+			}
+			break;
+		case 'l':
+			pattern_path = optarg;
+			break;
+		case 'o':
+			if (sscanf(optarg, "%d,%d,%d", &pattern_x, &pattern_y, &pattern_orient) < 2 ||
+			    pattern_orient < 0 || pattern_orient > 7) {
+				printf( "ERROR: bad pattern placement \"%s\"...\n", optarg );
+				return(1);
+			}
+			pattern_placed = 1;
+			break;
+		case 'W':
+			save_path = optarg;
+			break;
+		case 'S':
+			snapshot_path = optarg;
+			break;
+		case 'C':
+			snapshot_every = atol(optarg);
+			break;
+		case 'H':
+			headless = 1;
+			break;
+		case 'd':
+			if (strncmp(optarg, "stop", 4) == 0) cycle_action = CYCLE_STOP;
+			else if (strncmp(optarg, "idle", 4) == 0) cycle_action = CYCLE_IDLE;
+			else if (strncmp(optarg, "jump", 4) == 0) cycle_action = CYCLE_JUMP;
+			if (cycle_action == CYCLE_OFF || (optarg[4] != 0 && (optarg[4] != ',' ||
+			    (cycle_history = atoi(optarg + 5)) < 1))) {
+				printf( "ERROR: bad cycle action \"%s\"...\n", optarg );
+				return(1);
+			}
+			break;
+		case 'i':
+			mouse_path = optarg;
+			break;
+		default:
+			printf( "usage: %s [-e bits|byte|hash|sparse] [-k kernel] [-t threads] [-f] [-c] [-s log2_gens] [-j gens] [-m nodes] [-r rule] [-w 4|8] [-n gens] [-u WxH] [-b dead|torus] [-v x,y] [-z zoom] [-p hz] [-g slots[,hz]] [-l pattern] [-o x,y[,orient]] [-W file] [-S snapshot] [-C gens] [-H] [-d stop|idle|jump[,history]] [-i mouse]\n", argv[0] );
+			return(1);
+		}
+	}
+	if (check) return life_check(kernel, threads);
+	// the pattern's box and rule, from its header when it has one
+	if (pattern_path && life_pattern_load(pattern_path, NULL, &pattern_info) != 0) {
+		printf( "ERROR: could not read pattern \"%s\", line %d...\n", pattern_path,
+			pattern_info.line );
+		return(1);
+	}
+	if (snapshot_path && engine == ENGINE_HASH) {
+		printf( "ERROR: the hash engine cannot be snapshotted...\n" );
+		return(1);
+	}
+	// a snapshot that is there is carried on from: it sets the size and
+	// border of a grid (the sparse engine keeps its window)
+	if (snapshot_path && access(snapshot_path, F_OK) == 0) {
+		if (life_snap_open(&resume, snapshot_path) != 0) {
+			printf( "ERROR: \"%s\" is not a whole snapshot...\n", snapshot_path );
+			return(1);
+		}
+		if (resume.hdr->kind == LIFE_SNAP_CHUNKS && engine != ENGINE_SPARSE) {
+			printf( "ERROR: \"%s\" holds sparse chunks, -e sparse reads it...\n", snapshot_path );
+			return(1);
+		}
+		if (resume.hdr->kind == LIFE_SNAP_ROWS && engine != ENGINE_SPARSE) {
+			uni_w = resume.hdr->width;
+			uni_h = resume.hdr->height;
+			wrap = resume.hdr->wrap;
+		}
+		else if (resume.hdr->wrap) {
+			printf( "ERROR: \"%s\" is a torus, the sparse engine has no edges...\n", snapshot_path );
+			return(1);
+		}
+		gen0 = resume.hdr->generation;
+	}
+	if (wrap && (engine == ENGINE_HASH || engine == ENGINE_SPARSE)) {
+		printf( "ERROR: the hash and sparse engines have no edges to join...\n" );
+		return(1);
+	}
+	if (cycle_action != CYCLE_OFF && engine == ENGINE_HASH) {
+		printf( "ERROR: the hash engine cannot watch for cycles...\n" );
+		return(1);
+	}
+	if (mouse_path && (engine == ENGINE_HASH || headless)) {
+		printf( "ERROR: the mouse edits neither the hash engine nor a headless run...\n" );
+		return(1);
+	}
+	if (mouse_path && (life_queue_init(&edits, 1024) != 0 ||
+			   mouse_dev_open(&mouse, mouse_path, 0) != 0)) {
+		printf( "ERROR: could not set up the mouse...\n" );
+		return(1);
+	}
+	if (cycle_action != CYCLE_OFF && life_cycle_init(&cycle, cycle_history) != 0) {
+		printf( "ERROR: could not allocate the cycle history...\n" );
+		return(1);
+	}
+	if (cycle_action == CYCLE_JUMP &&
+	    (engine == ENGINE_SPARSE ? life_sparse_init(&cycle_s) != 0 :
+	     (cycle_cells = malloc(2 * sizeof(uint64_t) * ((uni_w + 63) >> 6) * uni_h)) == NULL)) {
+		printf( "ERROR: could not allocate the cycle history...\n" );
+		return(1);
+	}
+	// headless, the main thread only steps, and a signal ends the
+	// run the way -n does; so it does the wait of -d idle
+	if (headless) {
+		pace = 0;
+	}
+	if (headless || cycle_action == CYCLE_IDLE) {
+		memset(&sa, 0, sizeof(sa));
+		sa.sa_handler = stop_run;
+		sigaction(SIGINT, &sa, NULL);
+		sigaction(SIGTERM, &sa, NULL);
+	}
+	// the hash and sparse engines' window onto the bits grid is only
+	// needed to be seen, or fed to other processes
+	window = !headless || feed_slots > 0;
 
 	// Declare volatile pointers to I/O registers (volatile 	// means that IO load and store instructions will be used 	// to access these pointer locations, 
 	// instead of regular memory loads and stores) 
 
 	// === shared memory =======================
 	// with video process
-	shared_mem_id = shmget(mem_key, 100, IPC_CREAT | 0666);
- 	//shared_mem_id = shmget(mem_key, 100, 0666);
-	shared_ptr = shmat(shared_mem_id, NULL, 0);
+	if (feed_slots > 0 && life_feed_create(&feed, mem_key, uni_w, uni_h, feed_slots) != 0) {
+		printf( "ERROR: could not create the shared memory feed (fewer -g slots may fit)...\n" );
+		return(1);
+	}
 
   	
-	// === need to mmap: =======================
-	// FPGA_CHAR_BASE
-	// FPGA_ONCHIP_BASE      
-	// HW_REGS_BASE        
-  
 	// === get FPGA addresses ==================
-    // Open /dev/mem
-	if( ( fd = open( "/dev/mem", ( O_RDWR | O_SYNC ) ) ) == -1 ) 	{
-		printf( "ERROR: could not open \"/dev/mem\"...\n" );
-		return( 1 );
-	}
-    
-    // get virtual addr that maps to physical
-	h2p_lw_virtual_base = mmap( NULL, HW_REGS_SPAN, ( PROT_READ | PROT_WRITE ), MAP_SHARED, fd, HW_REGS_BASE );	
-	if( h2p_lw_virtual_base == MAP_FAILED ) {
-		printf( "ERROR: mmap1() failed...\n" );
-		close( fd );
-		return(1);
+	// /dev/mem, or plain memory when DE1_SIM is set (see vga_dev.h);
+	// neither when headless
+	if (!headless) {
+		if (vga_dev_open(&dev, NULL) != 0) return(1);
+		h2p_lw_virtual_base = dev.regs_base;
+		sw_ptr = (unsigned int *)(h2p_lw_virtual_base + SW_BASE);
+		key_ptr = (unsigned int *)(h2p_lw_virtual_base + KEY_BASE);
+		vga_char_virtual_base = dev.char_base;
+		vga_char_ptr =(unsigned int *)(vga_char_virtual_base);
+		vga_pixel_virtual_base = dev.pixel_base;
+		vga_pixel_ptr =(unsigned int *)(vga_pixel_virtual_base);
+		vga_raster_init(&raster, vga_pixel_ptr, 1024, 640, 480, 1);
+		if (vga_span_init(&span, vga_pixel_ptr, 1024, 640, 480, span_word) != 0) {
+			printf( "ERROR: could not set up the shadow screen...\n" );
+			return(1);
+		}
 	}
-    
 
-	// === get VGA char addr =====================
-	// get virtual addr that maps to physical
-	vga_char_virtual_base = mmap( NULL, FPGA_CHAR_SPAN, ( 	PROT_READ | PROT_WRITE ), MAP_SHARED, fd, FPGA_CHAR_BASE );	
-	if( vga_char_virtual_base == MAP_FAILED ) {
-		printf( "ERROR: mmap2() failed...\n" );
-		close( fd );
+	// ===========================================
+
+	if ((engine != ENGINE_BYTE && life_bits_init(&life, uni_w, uni_h) != 0) ||
+	    (engine == ENGINE_BYTE && life_byte_init(&life_b, uni_w, uni_h, kernel) != 0)) {
+		printf( "ERROR: could not allocate the life grid...\n" );
 		return(1);
 	}
-    
-    // Get the address that maps to the FPGA LED control 
-	vga_char_ptr =(unsigned int *)(vga_char_virtual_base);
-
-	// === get VGA pixel addr ====================
-	// get virtual addr that maps to physical
-	vga_pixel_virtual_base = mmap( NULL, FPGA_ONCHIP_SPAN, ( 	PROT_READ | PROT_WRITE ), MAP_SHARED, fd, 			FPGA_ONCHIP_BASE);	
-	if( vga_pixel_virtual_base == MAP_FAILED ) {
-		printf( "ERROR: mmap3() failed...\n" );
-		close( fd );
+	life.track = !full_scan;
+	if (engine == ENGINE_BYTE) life_byte_set_wrap(&life_b, wrap);
+	else life_bits_set_wrap(&life, wrap);
+	if (engine == ENGINE_HASH && life_hash_init(&life_h, hash_nodes) != 0) {
+		printf( "ERROR: could not allocate the hashlife nodes...\n" );
 		return(1);
 	}
-    
-    // Get the address that maps to the FPGA pixel buffer
-	vga_pixel_ptr =(unsigned int *)(vga_pixel_virtual_base);
-
-	// ===========================================
+	if (engine == ENGINE_SPARSE && life_sparse_init(&life_s) != 0) {
+		printf( "ERROR: could not allocate the chunk pool...\n" );
+		return(1);
+	}
+	if (life_pool_init(&pool, threads) != 0) {
+		printf( "could not start the stepping threads, stepping on one\n" );
+		life_pool_init(&pool, 1);
+	}
+	sw_rule = headless ? 0 : *sw_ptr & 0xf;
+	if (!rule_given && resume.hdr) life_snap_rule(&resume, &rule);
+	else if (!rule_given && pattern_path && pattern_info.has_rule) rule = pattern_info.rule;
+	else if (!rule_given && life_rule_preset(&rule, sw_rule) != 0)
+		life_rule_preset(&rule, 0);
+	set_rule(&rule);
 
 	/* create a message to be displayed on the VGA 
           and LCD displays */
 	char text_top_row[40] = "DE1-SoC ARM/FPGA\0";
 	char text_bottom_row[40] = "Cornell ece5760\0";
-	char num_string[20], time_string[40] ;
 
 	
-	// clear the screen
-	VGA_box (0, 0, 639, 479, 0x00);
-	// clear the text
-	VGA_text_clear();
-	VGA_text (1, 1, text_top_row);
-	VGA_text (1, 2, text_bottom_row);
+	if (!headless) {
+		// clear the screen
+		vga_raster_box(&raster, 0, 0, 639, 479, 0x00);
+		// clear the text
+		vga_hud_init(&hud, vga_char_ptr);
+		vga_hud_text(&hud, 1, 1, text_top_row);
+		vga_hud_text(&hud, 1, 2, text_bottom_row);
+		vga_hud_text(&hud, 1, 5, rule_string);
+	}
 	
 	// start timer
     //gettimeofday(&t1, NULL);
@@ -153,20 +632,43 @@ int main(void)
 	total_count = 0 ;
 	
 	// init a small pattern "PI"
-	// life[320][240] = 1;
-	// life[319][240] = 1;
-	// life[321][240] = 1;
-	// life[319][241] = 1;
-	// life[319][242] = 1;
-	// life[321][241] = 1;
-	// life[321][242] = 1;
+	// life_set(320, 240, 1);
+	// life_set(319, 240, 1);
+	// life_set(321, 240, 1);
+	// life_set(319, 241, 1);
+	// life_set(319, 242, 1);
+	// life_set(321, 241, 1);
+	// life_set(321, 242, 1);
 	
-	// initialize a "gun". 
-	glider_gun(150,100, 1, 1);
-	//glider_gun(100,100, 1, 1); // no symmetry
-	glider_gun(400,100, -1, 1);
-	glider_gun(150,400, 1, -1);
-	glider_gun(400,400, -1, -1);
+	// initialize four "guns", at (150,100) .. (400,400) on the
+	// default screen and in the same places of a bigger universe,
+	// or the pattern from -l, or the snapshot from -S
+	if (resume.hdr) {
+		resumed = 1;
+		if (resume_snapshot() != 0) return(1);
+	}
+	else if (pattern_path) {
+		if (seed_pattern() != 0) return(1);
+	}
+	else life_pattern_four_guns(cell_set, NULL, uni_w, uni_h);
+	//life_pattern_glider_gun(cell_set, NULL, 99, 99, 1, 1); // no symmetry
+	
+	// the hash engine takes over the pattern from the bits grid,
+	// optionally jumps far ahead, and hands the view back
+	if (engine == ENGINE_HASH) {
+		if (life_hash_load_bits(&life_h, &life, LIFE_X0, LIFE_Y0) != 0 ||
+		    life_hash_advance(&life_h, hash_jump) != 0) {
+			printf( "ERROR: hashlife node pool too small...\n" );
+			return(1);
+		}
+		life_hash_render(&life_h, &life, LIFE_X0, LIFE_Y0);
+		life_bits_swap(&life);
+	}
+	// so does the sparse engine, with the grid at the plane's origin
+	if (engine == ENGINE_SPARSE && !resumed && life_sparse_load_bits(&life_s, &life, 0, 0) != 0) {
+		printf( "ERROR: could not allocate the chunk pool...\n" );
+		return(1);
+	}
 	
 	// rand seed from time of day
 	//gettimeofday(&t1,NULL);
@@ -177,303 +679,950 @@ int main(void)
 	// init the main state array
 	// for (i=50; i<589; i++) {
 		// for (j=50; j<459; j++) {
-			// life[i][j] = (rand() & 0xb11) == 1 ;
-			// if (i==320) life[i][j] = 1;
-			// if (j==240) life[i][j] = 1;
+			// life_set(i, j, (rand() & 0xb11) == 1);
+			// if (i==320) life_set(i, j, 1);
+			// if (j==240) life_set(i, j, 1);
 		// }
 	// }
 	count = 0;
 	// draw the initial pattern
-	for (i=1; i<639; i++) {
-		for (j=1; j<479; j++) {
-			VGA_PIXEL(i,j,0xff*life[i][j]);
+	if (!headless) {
+		draw_view();
+		vga_span_flush(&span);
+	}
+	
+	// snapshots are the current generation's rows, halo words and all
+	snap.width = uni_w;
+	snap.height = uni_h;
+	snap.words = (uni_w + 63) >> 6;
+	snap.stride = snap.words + 2;
+	snap.wrap = wrap;
+	if (pace > 0) {
+		if (life_triple_init(&triple, sizeof(frame_t) +
+				     (size_t)uni_h * snap.stride * sizeof(uint64_t)) != 0) {
+			printf( "ERROR: could not allocate the frame buffers...\n" );
+			return(1);
+		}
+		publish_frame(0);
+		if (pthread_create(&render_tid, NULL, render_main, NULL) != 0) {
+			printf( "ERROR: could not start the render thread...\n" );
+			return(1);
 		}
 	}
 	
-	while(1) 
+	if (cycle_action != CYCLE_OFF) {
+		cycle_forget();
+		life_cycle_add(&cycle, cycle_hash(), generation());
+	}
+	view_publish();
+	if (mouse_path && pthread_create(&input_tid, NULL, input_main, NULL) != 0) {
+		printf( "ERROR: could not start the input thread...\n" );
+		return(1);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &run_t0);
+	while((frames < 0 || count < frames) && !stop_flag && !cycle_done) 
 	{
-		 gettimeofday(&t1, NULL);
-		//leave the edges at zero for all time 
-		for (i=1; i<639; i++) {
-			for (j=1; j<479; j++) {
-				sum = life[i-1][j-1] + life[i][j-1] + life[i+1][j-1] +
-				      life[i-1][j]                  + life[i+1][j] +
-					  life[i-1][j+1] + life[i][j+1] + life[i+1][j+1] ;
-				if (sum == 3) {
-					life_new[i][j] = 1;
-					if(life[i][j]==0) VGA_PIXEL(i,j,0xff);
-				}
-				else if (sum == 2) {
-					life_new[i][j] = life[i][j] ;
+		// the switches pick a preset rule whenever they move
+		if (!headless && (*sw_ptr & 0xf) != sw_rule) {
+			sw_rule = *sw_ptr & 0xf;
+			if (life_rule_preset(&rule, sw_rule) != 0)
+				life_rule_preset(&rule, 0);
+			set_rule(&rule);
+			vga_hud_text(&hud, 1, 5, rule_string);
+			// the generations seen so far went by another rule
+			if (cycle_action != CYCLE_OFF) cycle_forget();
+		}
+		// the mouse's edits, between this generation and the next; the
+		// cursor is off the screen while the cells are drawn
+		if (mouse_path) {
+			if (apply_edits() > 0) redraw = feed_edited = 1;
+			if (pace == 0) cursor_hide();
+		}
+		// the keys pan the view by an eighth of the screen per frame
+		if (pace == 0 && !headless && (keys = *key_ptr & 0xf) != 0) {
+			pan = zoom > 0 ? (80 + zoom - 1) / zoom : -80 * zoom;
+			if (keys & 1) view_x += pan;
+			if (keys & 2) view_x -= pan;
+			if (keys & 4) view_y += pan;
+			if (keys & 8) view_y -= pan;
+			redraw = 1;
+		}
+		// otherwise only the cells that changed are drawn, when
+		// every cell has its own place on the screen
+		redraw |= !view_single() || pace > 0 || headless;
+		loop_t0 = now_ns();
+		if (engine != ENGINE_BYTE) {
+			if (engine == ENGINE_BITS)
+				life_pool_run(&pool, step_bits_band, &life, life.tiles_y);
+			else if (engine == ENGINE_HASH) {
+				// 2^hash_step generations a frame, the last cut short at -n
+				gens = 1LL << hash_step;
+				if (frames >= 0 && frames - count < gens) gens = frames - count;
+				if ((gens == 1LL << hash_step ? life_hash_step_pow2(&life_h, hash_step) :
+				     life_hash_advance(&life_h, gens)) != 0) {
+					printf( "ERROR: hashlife node pool too small...\n" );
+					return(1);
 				}
-				else {
-					life_new[i][j] = 0;
-					if(life[i][j]==1) VGA_PIXEL(i,j,0x00);
+				if (window) life_hash_render(&life_h, &life, LIFE_X0, LIFE_Y0);
+			}
+			else {
+				if (life_sparse_step(&life_s) != 0) {
+					printf( "ERROR: could not allocate the chunk pool...\n" );
+					return(1);
 				}
+				if (window) life_sparse_render(&life_s, &life, 0, 0);
 			}
+			
+			// draw only the cells that changed
+			loop_t1 = now_ns();
+			if (!redraw) draw_changes_bits();
+			
+			// the hash of next, from the words that changed
+			if (cycle_action != CYCLE_OFF && engine == ENGINE_BITS && cycle.period == 0)
+				cycle_h = life_cycle_bits_next(&life, cycle_h);
+			
+			// update the main state array
+			if (engine == ENGINE_BITS || window) life_bits_swap(&life);
 		}
-		
-		// update the main state array
-		// for (i=1; i<639; i++) {
-			// for (j=1; j<479; j++) {
-				// life[i][j] = life_new[i][j] ;
-			// }
-		// }
-		memcpy(life, life_new, sizeof(life));
-		count++;
-		//VGA_text (10, 1, text_top_row);
-	    //VGA_text (10, 2, text_bottom_row);
+		else {
+			life_pool_run(&pool, step_byte_band, &life_b, life_b.height);
+			
+			// draw the cells that changed
+			loop_t1 = now_ns();
+			if (!redraw) draw_changes_byte();
+			
+			// update the main state array: swap, no copy
+			life_byte_swap(&life_b);
+		}
+		// or the whole view, from the new generation
+		if (pace == 0 && !headless) {
+			if (redraw) draw_view();
+			if (mouse_path) cursor_show();
+			vga_span_flush(&span);
+			if (edit_oldest) {
+				edit_shown(edit_oldest);
+				edit_oldest = 0;
+			}
+		}
+		redraw = 0;
+		count += gens;
+		// a generation seen before: from here on it goes round a loop
+		if (cycle_action != CYCLE_OFF && cycle.period == 0 &&
+		    life_cycle_add(&cycle, cycle_hash(), generation()) != 0)
+			cycle_found();
+		else if (cycle_check && generation() == cycle_check)
+			cycle_confirm();
+		//vga_hud_text(&hud, 10, 1, text_top_row);
+	    //vga_hud_text(&hud, 10, 2, text_bottom_row);
 		
 		// stop timer
-		 gettimeofday(&t2, NULL);
-		 elapsedTime = (t2.tv_sec - t1.tv_sec) * 1000.0;      // sec to ms
-		 elapsedTime += (t2.tv_usec - t1.tv_usec) / 1000.0;   // us to ms
-		// sprintf(num_string, "# = %d     ", total_count);
-		 sprintf(time_string, "T=%3.0fmS gen=%d  ", elapsedTime, count);
-		// VGA_text (10, 3, num_string);
-		 VGA_text (1, 4, time_string);
+		 loop_t2 = now_ns();
+		 step_ms = (loop_t1 - loop_t0) / 1e6;
+		 draw_ms = (loop_t2 - loop_t1) / 1e6;
+		 elapsedTime = step_ms + draw_ms;
+		 last = count == frames || cycle_done || stop_flag;
+		 // every generation, or with feed_hz the one after one fed goes
+		 // too, then none until the next feed is due
+		 if (feed_slots > 0 && (feed_hz == 0 || feed_pair || last ||
+					loop_t2 - feed_at >= 1000000000ULL / feed_hz)) {
+			 feed_pair = feed_hz > 0 && !feed_pair && !last;
+			 if (feed_pair) feed_at = loop_t2;
+			 meta.generation = generation();
+			 meta.population = pack_generation(life_feed_begin(&feed), feed.hdr->words);
+			 meta.step_ms = step_ms;
+			 meta.birth = rule.birth;
+			 meta.survive = rule.survive;
+			 meta.edge = engine == ENGINE_HASH || engine == ENGINE_SPARSE ? LIFE_FEED_WINDOW :
+				     wrap ? LIFE_FEED_TORUS : LIFE_FEED_DEAD;
+			 meta.flags = feed_edited ? LIFE_FEED_EDITED : 0;
+			 feed_edited = 0;
+			 life_feed_end(&feed, &meta);
+		 }
+		 if (snapshot_every > 0 && generation() % snapshot_every == 0 && save_snapshot() != 0)
+			 return(1);
+		 // the render thread takes it from here, as soon as it has the
+		 // last one; the final generation is always handed over
+		 if (pace > 0) {
+			 if (!life_triple_pending(&triple) || last) publish_frame(step_ms);
+			 continue;
+		 }
+		 if (headless || (loop_t2 - hud_at < 1000000000ULL / HUD_HZ && !last)) continue;
+		 hud_at = loop_t2;
+		 hud_status(&line, step_ms, population());
+		 vga_hud_pad(&hud, 1, 4, line.text, 64);
+		 // pixel buffer traffic of this frame
+		 vga_hud_start(&line);
+		 vga_hud_add(&line, "px=");
+		 vga_hud_add_u(&line, span.frame.pixels, 6);
+		 vga_hud_add(&line, " wr=");
+		 vga_hud_add_u(&line, span.frame.writes, 6);
+		 vga_hud_add(&line, " bytes=");
+		 vga_hud_add_u(&line, span.frame.bytes, 7);
+		 vga_hud_add(&line, " spans=");
+		 vga_hud_add_u(&line, span.frame.spans, 5);
+		 vga_hud_add(&line, " draw=");
+		 vga_hud_add_fix(&line, draw_ms, 5, 2);
+		 vga_hud_add(&line, "mS");
+		 vga_hud_pad(&hud, 1, 6, line.text, 64);
 		
 	} // end while(1)
+	clock_gettime(CLOCK_MONOTONIC, &run_t1);
+	// -d idle: the last generation stays up, and can be looked round,
+	// until a signal
+	while (cycle_done && cycle_action == CYCLE_IDLE && !stop_flag) {
+		if (pace == 0 && !headless && (keys = *key_ptr & 0xf) != 0) {
+			pan = zoom > 0 ? (80 + zoom - 1) / zoom : -80 * zoom;
+			if (keys & 1) view_x += pan;
+			if (keys & 2) view_x -= pan;
+			if (keys & 4) view_y += pan;
+			if (keys & 8) view_y -= pan;
+			if (mouse_path) cursor_hide();
+			draw_view();
+			if (mouse_path) cursor_show();
+			vga_span_flush(&span);
+		}
+		usleep(1000000 / 60);
+	}
+	if (mouse_path) {
+		__atomic_store_n(&input_stop, 1, __ATOMIC_RELEASE);
+		pthread_join(input_tid, NULL);
+	}
+	if (pace > 0) {
+		__atomic_store_n(&sim_done, 1, __ATOMIC_RELEASE);
+		pthread_join(render_tid, NULL);
+		life_triple_free(&triple);
+	}
+	if (feed_slots > 0) life_feed_close(&feed);
+	// -W writes the window, which headless runs have left behind
+	if (!window && engine == ENGINE_HASH) life_hash_render(&life_h, &life, LIFE_X0, LIFE_Y0);
+	if (!window && engine == ENGINE_SPARSE) life_sparse_render(&life_s, &life, 0, 0);
+	if (!window && engine != ENGINE_BITS && engine != ENGINE_BYTE) life_bits_swap(&life);
+	if (save_path && save_pattern() != 0) return(1);
+	if (snapshot_path && save_snapshot() != 0) return(1);
+	if (headless) print_summary((run_t1.tv_sec - run_t0.tv_sec) +
+				    (run_t1.tv_nsec - run_t0.tv_nsec) / 1e9);
+	else vga_dev_close(&dev);
+	if (mouse_path) {
+		if (edit_batches > 0)
+			printf( "edits: %ld batches shown, mouse to screen %.2f ms mean, %.2f max, %ld dropped\n",
+				edit_batches, edit_sum_ms / edit_batches, edit_max_ms, edits.dropped );
+		mouse_dev_close(&mouse);
+		life_queue_free(&edits);
+	}
+	return(0);
 } // end main
 
-/****************************************************************************************
- * Subroutine to send a string of text to the VGA monitor 
-****************************************************************************************/
-void VGA_text(int x, int y, char * text_ptr)
-{
-  	volatile char * character_buffer = (char *) vga_char_ptr ;	// VGA character buffer
-	int offset;
-	/* assume that the text string fits on one line */
-	offset = (y << 7) + x;
-	while ( *(text_ptr) )
-	{
-		// write to the character buffer
-		*(character_buffer + offset) = *(text_ptr);	
-		++text_ptr;
-		++offset;
+//////////////////////////////////////////////////////////
+// cell access for whichever engine is running,
+// in universe coordinates, which go round a torus
+//////////////////////////////////////////////////////////
+int wrap_coord(int v, int n){
+	v %= n;
+	return v < 0 ? v + n : v;
+}
+
+void life_set(int x, int y, int alive){
+	if (wrap) {
+		x = wrap_coord(x, uni_w);
+		y = wrap_coord(y, uni_h);
 	}
+	if (engine == ENGINE_BYTE) life_byte_set(&life_b, x, y, alive);
+	else life_bits_set(&life, x, y, alive);
 }
 
-/****************************************************************************************
- * Subroutine to clear text to the VGA monitor 
-****************************************************************************************/
-void VGA_text_clear()
-{
-  	volatile char * character_buffer = (char *) vga_char_ptr ;	// VGA character buffer
-	int offset, x, y;
-	for (x=0; x<70; x++){
-		for (y=0; y<40; y++){
-	/* assume that the text string fits on one line */
-			offset = (y << 7) + x;
-			// write to the character buffer
-			*(character_buffer + offset) = ' ';		
+int life_get(int x, int y){
+	if (wrap) {
+		x = wrap_coord(x, uni_w);
+		y = wrap_coord(y, uni_h);
+	}
+	if (engine == ENGINE_BYTE) return life_byte_get(&life_b, x, y);
+	return life_bits_get(&life, x, y);
+}
+
+void cell_set(void *ctx, int x, int y, int alive){
+	(void)ctx;
+	life_set(x, y, alive);
+}
+
+int cell_get(void *ctx, int x, int y){
+	(void)ctx;
+	return life_get(x, y);
+}
+
+// -l: the pattern file, at -o or in the middle of the universe
+int seed_pattern(void){
+	life_place_t at;
+	int w = pattern_info.width, h = pattern_info.height;
+
+	if (pattern_orient & LIFE_SWAP_XY) {
+		w = pattern_info.height;
+		h = pattern_info.width;
+	}
+	at.set = cell_set;
+	at.ctx = NULL;
+	at.x = pattern_placed ? pattern_x : (uni_w - w) / 2;
+	at.y = pattern_placed ? pattern_y : (uni_h - h) / 2;
+	at.orient = pattern_orient;
+	if (life_pattern_load(pattern_path, &at, &pattern_info) != 0) {
+		printf( "ERROR: could not read pattern \"%s\", line %d...\n", pattern_path,
+			pattern_info.line );
+		return(1);
+	}
+	return(0);
+}
+
+// -W: the universe as it is now (the hash and sparse engines' window)
+int save_pattern(void){
+	FILE *f;
+	int n = strlen(save_path), err;
+
+	if ((f = fopen(save_path, "w")) == NULL) {
+		printf( "ERROR: could not create \"%s\"...\n", save_path );
+		return(1);
+	}
+	if (n > 6 && strcmp(save_path + n - 6, ".cells") == 0)
+		err = life_pattern_write_cells(f, cell_get, NULL, 0, 0, uni_w, uni_h);
+	else err = life_pattern_write_rle(f, cell_get, NULL, 0, 0, uni_w, uni_h, &rule);
+	if (fclose(f) != 0 || err != 0) {
+		printf( "ERROR: could not write \"%s\"...\n", save_path );
+		return(1);
+	}
+	return(0);
+}
+
+// -S: the cells of the snapshot in place of a pattern; the grids were
+// made its size. the rule stays the one picked in main
+int resume_snapshot(void){
+	const uint64_t *row;
+	int x, y, err = 0;
+
+	if (engine == ENGINE_SPARSE) {
+		err = life_snap_load_sparse(&resume, &life_s);
+		// the window, from the plane
+		life_sparse_render(&life_s, &life, 0, 0);
+		life_bits_swap(&life);
+	}
+	else if (engine == ENGINE_BYTE) {
+		for (y=0; y<uni_h; y++) {
+			row = life_snap_row(&resume, y);
+			for (x=0; x<uni_w; x++)
+				if ((row[x >> 6] >> (x & 63)) & 1) life_byte_set(&life_b, x, y, 1);
 		}
 	}
+	else err = life_snap_load_bits(&resume, &life);
+	life_snap_close(&resume);
+	if (err != 0) {
+		printf( "ERROR: could not load \"%s\"...\n", snapshot_path );
+		return(1);
+	}
+	set_rule(&rule);
+	return(0);
 }
 
-/****************************************************************************************
- * Draw a filled rectangle on the VGA monitor 
-****************************************************************************************/
-#define SWAP(X,Y) do{int temp=X; X=Y; Y=temp;}while(0) 
+// -S and -C: the whole universe, or every chunk of the sparse plane
+int save_snapshot(void){
+	uint64_t *rows;
+	int words = (uni_w + 63) >> 6, err;
 
-void VGA_box(int x1, int y1, int x2, int y2, short pixel_color)
-{
-	char  *pixel_ptr ; 
-	int row, col;
-
-	/* check and fix box coordinates to be valid */
-	if (x1>639) x1 = 639;
-	if (y1>479) y1 = 479;
-	if (x2>639) x2 = 639;
-	if (y2>479) y2 = 479;
-	if (x1<0) x1 = 0;
-	if (y1<0) y1 = 0;
-	if (x2<0) x2 = 0;
-	if (y2<0) y2 = 0;
-	if (x1>x2) SWAP(x1,x2);
-	if (y1>y2) SWAP(y1,y2);
-	for (row = y1; row <= y2; row++)
-		for (col = x1; col <= x2; ++col)
-		{
-			//640x480
-			pixel_ptr = (char *)vga_pixel_ptr + (row<<10)    + col ;
-			// set pixel color
-			*(char *)pixel_ptr = pixel_color;		
+	if (engine == ENGINE_SPARSE) err = life_snap_write_sparse(snapshot_path, &life_s);
+	else if (engine == ENGINE_BITS) err = life_snap_write_bits(snapshot_path, &life, generation());
+	else {
+		// the byte engine's cells, packed first
+		if ((rows = malloc((size_t)uni_h * words * sizeof(uint64_t))) == NULL) {
+			printf( "ERROR: could not allocate the snapshot...\n" );
+			return(1);
 		}
+		pack_generation(rows, words);
+		err = life_snap_write_rows(snapshot_path, rows, words, uni_w, uni_h, wrap, &rule,
+					   generation());
+		free(rows);
+	}
+	if (err != 0) {
+		printf( "ERROR: could not write \"%s\"...\n", snapshot_path );
+		return(1);
+	}
+	return(0);
 }
 
-/****************************************************************************************
- * Draw a filled circle on the VGA monitor 
-****************************************************************************************/
+void bits_set(void *g, int x, int y, int alive){
+	life_bits_set((life_bits_t *)g, x, y, alive);
+}
 
-void VGA_disc(int x, int y, int r, short pixel_color)
-{
-	char  *pixel_ptr ; 
-	int row, col, rsqr, xc, yc;
-	
-	rsqr = r*r;
-	
-	for (yc = -r; yc <= r; yc++)
-		for (xc = -r; xc <= r; xc++)
-		{
-			col = xc;
-			row = yc;
-			// add the r to make the edge smoother
-			if(col*col+row*row <= rsqr+r){
-				col += x; // add the center point
-				row += y; // add the center point
-				//check for valid 640x480
-				if (col>639) col = 639;
-				if (row>479) row = 479;
-				if (col<0) col = 0;
-				if (row<0) row = 0;
-				pixel_ptr = (char *)vga_pixel_ptr + (row<<10) + col ;
-				// set pixel color
-				*(char *)pixel_ptr = pixel_color;
+void sparse_set(void *s, int x, int y, int alive){
+	life_sparse_set((life_sparse_t *)s, x, y, alive);
+}
+
+//////////////////////////////////////////////////////////
+// the view: universe cells onto the 640x480 screen
+//////////////////////////////////////////////////////////
+// universe cells [lo, hi) seen along one axis from v on, vis of them;
+// on a torus the range can wrap round into a second one
+int view_range(int v, int n, int vis, int *lo, int *hi){
+	if (!wrap) {
+		lo[0] = v < 0 ? 0 : v;
+		hi[0] = v + vis > n ? n : v + vis;
+		return hi[0] > lo[0];
+	}
+	lo[0] = wrap_coord(v, n);
+	hi[0] = lo[0] + vis;
+	if (hi[0] <= n) return 1;
+	lo[1] = 0;
+	hi[1] = hi[0] - n;
+	hi[0] = n;
+	return 2;
+}
+
+// every visible cell has one block of pixels of its own, so drawing
+// the cells that changed keeps the screen up to date
+int view_single(void){
+	return zoom > 0 && (!wrap || ((640 + zoom - 1) / zoom <= uni_w &&
+				      (480 + zoom - 1) / zoom <= uni_h));
+}
+
+// redraw every pixel; through the shadow screen, so only the
+// pixels that differ reach the pixel buffer
+void draw_view(void){
+	int sx, sy, cx, cy;
+
+	view_publish();
+	if (engine != ENGINE_BYTE) {
+		life_view_draw(&life, &span, view_x, view_y, zoom);
+		return;
+	}
+	for (sy=0; sy<480; sy++) {
+		cy = zoom > 0 ? view_y + sy / zoom : view_y - sy * zoom;
+		for (sx=0; sx<640; sx++) {
+			cx = zoom > 0 ? view_x + sx / zoom : view_x - sx * zoom;
+			vga_span_put(&span, sx, sy, 0xff*life_get(cx, cy));
+		}
+	}
+}
+
+// the origin about to be drawn is the one the mouse points into
+void view_publish(void){
+	__atomic_store_n(&view_shown, (uint64_t)(uint32_t)view_x << 32 | (uint32_t)view_y,
+			 __ATOMIC_RELEASE);
+}
+
+// a visible cell as its zoom x zoom block
+void draw_cell(int cx, int cy, int alive){
+	int sx = cx - view_x, sy = cy - view_y, x, y;
+
+	if (wrap) {
+		sx = wrap_coord(sx, uni_w);
+		sy = wrap_coord(sy, uni_h);
+	}
+	sx *= zoom;
+	sy *= zoom;
+	for (y=sy; y<sy+zoom && y<480; y++)
+		for (x=sx; x<sx+zoom && x<640; x++)
+			vga_span_put(&span, x, y, alive ? 0xff : 0x00);
+}
+
+// the visible cells that differ between cur and next: xor old and new
+// words of the tiles that changed, then walk the set bits
+void draw_changes_bits(void){
+	int xl[2], xh[2], yl[2], yh[2], nx, ny, a, b, x, y, w, k;
+	uint64_t diff, cell;
+
+	nx = view_range(view_x, uni_w, (640 + zoom - 1) / zoom, xl, xh);
+	ny = view_range(view_y, uni_h, (480 + zoom - 1) / zoom, yl, yh);
+	for (b=0; b<ny; b++) {
+		for (y=yl[b]; y<yh[b]; y++) {
+			for (a=0; a<nx; a++) {
+				for (w=xl[a]>>6; w<=(xh[a]-1)>>6; w++) {
+					if (!LIFE_BITS_TILE(&life, life.dirty_next, w, y/LIFE_TILE_ROWS))
+						continue;
+					diff = LIFE_BITS_ROW(&life, life.cur, y)[w] ^
+					       LIFE_BITS_ROW(&life, life.next, y)[w] ;
+					cell = LIFE_BITS_ROW(&life, life.next, y)[w] ;
+					// only the cells inside the range
+					x = xl[a] - (w << 6);
+					if (x > 0) diff &= ~0ULL << x;
+					x = xh[a] - (w << 6);
+					if (x < 64) diff &= (1ULL << x) - 1;
+					while (diff) {
+						k = __builtin_ctzll(diff);
+						draw_cell((w<<6)+k, y, (cell>>k) & 1);
+						diff &= diff - 1;
+					}
+				}
 			}
-					
 		}
+	}
 }
 
-// =============================================
-// === Draw a line
-// =============================================
-//plot a line 
-//at x1,y1 to x2,y2 with color 
-//Code is from David Rodgers,
-//"Procedural Elements of Computer Graphics",1985
-void VGA_line(int x1, int y1, int x2, int y2, short c) {
-	int e;
-	signed int dx,dy,j, temp;
-	signed int s1,s2, xchange;
-     signed int x,y;
-	char *pixel_ptr ;
-	
-	/* check and fix line coordinates to be valid */
-	if (x1>639) x1 = 639;
-	if (y1>479) y1 = 479;
-	if (x2>639) x2 = 639;
-	if (y2>479) y2 = 479;
-	if (x1<0) x1 = 0;
-	if (y1<0) y1 = 0;
-	if (x2<0) x2 = 0;
-	if (y2<0) y2 = 0;
-        
-	x = x1;
-	y = y1;
-	
-	//take absolute value
-	if (x2 < x1) {
-		dx = x1 - x2;
-		s1 = -1;
+// the same, cell by cell like the pixel buffer itself
+void draw_changes_byte(void){
+	int xl[2], xh[2], yl[2], yh[2], nx, ny, a, b, x, y;
+	uint8_t *old, *new;
+
+	nx = view_range(view_x, uni_w, (640 + zoom - 1) / zoom, xl, xh);
+	ny = view_range(view_y, uni_h, (480 + zoom - 1) / zoom, yl, yh);
+	for (b=0; b<ny; b++) {
+		for (y=yl[b]; y<yh[b]; y++) {
+			old = LIFE_BYTE_ROW(&life_b, life_b.cur, y);
+			new = LIFE_BYTE_ROW(&life_b, life_b.next, y);
+			for (a=0; a<nx; a++)
+				for (x=xl[a]; x<xh[a]; x++)
+					if (old[x] != new[x]) draw_cell(x, y, new[x]);
+		}
 	}
+}
+
+//////////////////////////////////////////////////////////
+// simulation to display
+//////////////////////////////////////////////////////////
+// the current generation's rows into dst, pitch words apart, 64 cells
+// to a word without the halo; the byte engine's cells are packed into
+// bits on the way. returns the population
+long pack_generation(uint64_t *dst, int pitch){
+	int words = (uni_w + 63) >> 6, x, y, w;
+	const uint64_t *src;
+	const uint8_t *cell;
+	uint64_t v;
+	long pop = 0;
 
-	else if (x2 == x1) {
-		dx = 0;
-		s1 = 0;
+	for (y=0; y<uni_h; y++, dst+=pitch) {
+		if (engine == ENGINE_BYTE) {
+			cell = LIFE_BYTE_ROW(&life_b, life_b.cur, y);
+			for (w=0; w<words; w++) {
+				for (x=w<<6, v=0; x<(w<<6)+64 && x<uni_w; x++)
+					v |= (uint64_t)(cell[x] != 0) << (x & 63);
+				dst[w] = v;
+				pop += __builtin_popcountll(v);
+			}
+			continue;
+		}
+		src = LIFE_BITS_ROW(&life, life.cur, y);
+		for (w=0; w<words; w++) {
+			dst[w] = src[w];
+			pop += __builtin_popcountll(src[w]);
+		}
 	}
+	return pop;
+}
 
-	else {
-		dx = x2 - x1;
-		s1 = 1;
+// generations since the start, for whichever engine
+uint64_t generation(void){
+	if (engine == ENGINE_HASH) return life_h.generation;
+	if (engine == ENGINE_SPARSE) return life_s.generation;
+	return gen0 + count;
+}
+
+// copy the current generation and its status line into the back frame
+// and hand it over
+void publish_frame(double ms){
+	frame_t *f = life_triple_back(&triple);
+	vga_hud_line_t line;
+	long pop;
+
+	pop = pack_generation(f->cells, snap.stride);
+	f->gen = generation();
+	// every published frame is taken, so the edits are timed once
+	f->edited = edit_oldest;
+	edit_oldest = 0;
+	hud_status(&line, ms, pop);
+	memcpy(f->status, line.text, line.len + 1);
+	life_triple_publish(&triple);
+}
+
+// the render thread: wakes pace times a second, and if there is a newer
+// generation, or the keys moved the view, draws the view of it through
+// the shadow screen, so only the pixels that changed are written. a tick
+// that comes late is not made up for, the next one is a period later
+void *render_main(void *arg){
+	struct timespec next, t0, t1;
+	long period = 1000000000L / pace;
+	frame_t *f;
+	int fresh, done, keys, pan;
+	vga_hud_line_t line;
+
+	(void)arg;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (1) {
+		next.tv_nsec += period;
+		while (next.tv_nsec >= 1000000000L) {
+			next.tv_nsec -= 1000000000L;
+			next.tv_sec++;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		if (t0.tv_sec > next.tv_sec || (t0.tv_sec == next.tv_sec && t0.tv_nsec > next.tv_nsec))
+			next = t0;
+		else clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+		// seen before the take, so the last frame is in hand when done
+		done = __atomic_load_n(&sim_done, __ATOMIC_ACQUIRE);
+		f = life_triple_front(&triple, &fresh);
+		if ((keys = *key_ptr & 0xf) != 0) {
+			pan = zoom > 0 ? (80 + zoom - 1) / zoom : -80 * zoom;
+			if (keys & 1) view_x += pan;
+			if (keys & 2) view_x -= pan;
+			if (keys & 4) view_y += pan;
+			if (keys & 8) view_y -= pan;
+			fresh = 1;
+		}
+		// the mouse moved
+		if (mouse_path && __atomic_load_n(&cursor, __ATOMIC_RELAXED) != cursor_at) fresh = 1;
+		if (fresh) {
+			clock_gettime(CLOCK_MONOTONIC, &t0);
+			snap.cur = f->cells;
+			if (mouse_path) cursor_hide();
+			view_publish();
+			life_view_draw(&snap, &span, view_x, view_y, zoom);
+			if (mouse_path) cursor_show();
+			vga_span_flush(&span);
+			if (f->edited) {
+				edit_shown(f->edited);
+				f->edited = 0;
+			}
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			vga_hud_pad(&hud, 1, 4, f->status, 64);
+			vga_hud_start(&line);
+			vga_hud_add(&line, "px=");
+			vga_hud_add_u(&line, span.frame.pixels, 6);
+			vga_hud_add(&line, " wr=");
+			vga_hud_add_u(&line, span.frame.writes, 6);
+			vga_hud_add(&line, " draw=");
+			vga_hud_add_fix(&line, (t1.tv_sec - t0.tv_sec) * 1000.0 +
+					(t1.tv_nsec - t0.tv_nsec) / 1000000.0, 5, 2);
+			vga_hud_add(&line, "mS");
+			vga_hud_pad(&hud, 1, 6, line.text, 64);
+		}
+		if (done) break;
 	}
+	return NULL;
+}
 
-	if (y2 < y1) {
-		dy = y1 - y2;
-		s2 = -1;
+//////////////////////////////////////////////////////////
+// headless runs
+//////////////////////////////////////////////////////////
+// SIGINT and SIGTERM: finish the generation, then stop as -n would
+void stop_run(int sig){
+	(void)sig;
+	stop_flag = 1;
+}
+
+// live cells of the current generation, from whichever engine has it
+uint64_t population(void){
+	if (engine == ENGINE_BITS) return life_bits_population(&life);
+	if (engine == ENGINE_BYTE) return life_byte_population(&life_b);
+	if (engine == ENGINE_HASH) return life_hash_population(&life_h);
+	return life_sparse_population(&life_s);
+}
+
+// the status line: generation, population, step time, and what the
+// engine has in use
+void hud_status(vga_hud_line_t *l, double ms, uint64_t pop){
+	vga_hud_start(l);
+	vga_hud_add(l, "gen=");
+	vga_hud_add_u(l, generation(), 0);
+	vga_hud_add(l, " pop=");
+	vga_hud_add_u(l, pop, 0);
+	vga_hud_add(l, " step=");
+	vga_hud_add_fix(l, ms, 0, 2);
+	vga_hud_add(l, "mS ");
+	if (engine == ENGINE_BITS) {
+		vga_hud_add(l, "tiles=");
+		vga_hud_add_u(l, life.active_tiles, 0);
+		vga_hud_add(l, "/");
+		vga_hud_add_u(l, life.tiles_x * life.tiles_y, 0);
+	}
+	else if (engine == ENGINE_HASH) {
+		vga_hud_add(l, "nodes=");
+		vga_hud_add_u(l, life_h.used, 0);
 	}
+	else if (engine == ENGINE_SPARSE) {
+		vga_hud_add(l, "chunks=");
+		vga_hud_add_u(l, life_s.used, 0);
+	}
+}
 
-	else if (y2 == y1) {
-		dy = 0;
-		s2 = 0;
+// one line per figure, for scripts to pick out
+void print_summary(double secs){
+	unsigned long long pop = population();
+	char name[40];
+	uint64_t gens = count - cycle_skip;
+
+	life_rule_format(&rule, name, sizeof(name));
+	printf( "rule:        %s\n", name );
+	printf( "generation:  %llu\n", (unsigned long long)generation() );
+	printf( "stepped:     %llu%s\n", (unsigned long long)gens, stop_flag ? " (stopped)" : "" );
+	if (cycle.period)
+		printf( "period:      %llu, from generation %llu\n", (unsigned long long)cycle.period,
+			(unsigned long long)(cycle.first - cycle.period) );
+	if (cycle_skip)
+		printf( "jumped:      %ld\n", cycle_skip );
+	printf( "population:  %llu\n", pop );
+	printf( "time:        %.3f s\n", secs );
+	printf( "gens/s:      %.1f\n", secs > 0 ? gens / secs : 0.0 );
+}
+
+//////////////////////////////////////////////////////////
+// cycles
+//////////////////////////////////////////////////////////
+// the hash of the current generation: the bits engine's is kept up to
+// date as it steps, the others are hashed whole
+uint64_t cycle_hash(void){
+	if (engine == ENGINE_BITS) return cycle_h;
+	if (engine == ENGINE_BYTE) return life_cycle_hash_byte(&life_b);
+	return life_cycle_hash_sparse(&life_s);
+}
+
+// start over from the current generation, whole: after a change of rule
+// or of cells, or a hash that matched without the cells being the same
+void cycle_forget(void){
+	life_cycle_reset(&cycle);
+	cycle_check = 0;
+	if (engine == ENGINE_BITS) cycle_h = life_cycle_hash_bits(&life);
+}
+
+// generation cycle.first has the hash of the one period before: say so
+// (on the screen; headless, in the summary), and stop. jump only keeps
+// the cells, for cycle_confirm() to make sure of a period later
+void cycle_found(void){
+	char text[64];
+
+	if (cycle_action == CYCLE_JUMP) {
+		if (engine == ENGINE_SPARSE) {
+			if (life_sparse_copy(&cycle_s, &life_s) != 0) {
+				cycle_forget();
+				return;
+			}
+		}
+		else pack_generation(cycle_cells, (uni_w + 63) >> 6);
+		cycle_check = generation() + cycle.period;
+		return;
 	}
+	cycle_done = 1;
+	if (headless) return;
+	snprintf(text, sizeof(text), "period %llu from gen %llu  ",
+		 (unsigned long long)cycle.period,
+		 (unsigned long long)(cycle.first - cycle.period));
+	printf( "%s\n", text );
+	vga_hud_text(&hud, 1, 7, text);
+}
 
+// -d jump, a period after the match: the same cells again, and so for
+// good, then jump over every whole period still to go; other cells, and
+// the hashes only happened to match
+void cycle_confirm(void){
+	long words = (uni_w + 63) >> 6, skip = 0;
+	char text[64];
+	int same;
+
+	cycle_check = 0;
+	if (engine == ENGINE_SPARSE) same = life_sparse_same(&life_s, &cycle_s);
 	else {
-		dy = y2 - y1;
-		s2 = 1;
-	}
-
-	xchange = 0;   
-
-	if (dy>dx) {
-		temp = dx;
-		dx = dy;
-		dy = temp;
-		xchange = 1;
-	} 
-
-	e = ((int)dy<<1) - dx;  
-	 
-	for (j=0; j<=dx; j++) {
-		//video_pt(x,y,c); //640x480
-		pixel_ptr = (char *)vga_pixel_ptr + (y<<10)+ x; 
-		// set pixel color
-		*(char *)pixel_ptr = c;	
-		 
-		if (e>=0) {
-			if (xchange==1) x = x + s1;
-			else y = y + s2;
-			e = e - ((int)dx<<1);
+		pack_generation(cycle_cells + words * uni_h, words);
+		same = memcmp(cycle_cells, cycle_cells + words * uni_h,
+			      sizeof(uint64_t) * words * uni_h) == 0;
+	}
+	if (!same) {
+		cycle_forget();
+		life_cycle_add(&cycle, cycle_hash(), generation());
+		return;
+	}
+	if (frames >= 0) {
+		skip = (frames - count) / (long)cycle.period * (long)cycle.period;
+		count += skip;
+		cycle_skip += skip;
+		if (engine == ENGINE_SPARSE) life_s.generation += skip;
+	}
+	if (headless) return;
+	snprintf(text, sizeof(text), "period %llu from gen %llu, +%ld  ",
+		 (unsigned long long)cycle.period,
+		 (unsigned long long)(cycle.first - cycle.period), skip);
+	printf( "%s\n", text );
+	vga_hud_text(&hud, 1, 7, text);
+}
+
+//////////////////////////////////////////////////////////
+// live editing
+//////////////////////////////////////////////////////////
+uint64_t now_ns(void){
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+// an edit at screen pixel (sx, sy), onto the queue for the universe
+// cell under it in the view last drawn; a full queue drops it
+void post_edit(int op, int sx, int sy, int arg, const char *rle){
+	uint64_t shown = __atomic_load_n(&view_shown, __ATOMIC_ACQUIRE);
+	int vx = (int32_t)(shown >> 32), vy = (int32_t)shown;
+	life_cmd_t c;
+
+	c.op = op;
+	c.x = zoom > 0 ? vx + sx / zoom : vx - sx * zoom;
+	c.y = zoom > 0 ? vy + sy / zoom : vy - sy * zoom;
+	c.arg = arg;
+	c.rle = rle;
+	c.posted = now_ns();
+	life_queue_post(&edits, &c);
+}
+
+// the input thread: sleeps until the mouse moves, then turns the
+// presses, in order and where they happened, into edits, and moves
+// the cursor. a tenth of a second at most between looks at input_stop
+void *input_main(void *arg){
+	int sx = 320, sy = 240, ex, ey, px, py, held = 0, k, z = zoom > 1 ? zoom : 1;
+	mouse_event_t *e;
+
+	(void)arg;
+	__atomic_store_n(&cursor, sy << 16 | sx, __ATOMIC_RELAXED);
+	while (!__atomic_load_n(&input_stop, __ATOMIC_ACQUIRE)) {
+		if (mouse_dev_wait(&mouse, 100) < 0) break;
+		if (mouse.packets == 0) continue;
+		// (px, py): the last left press of this wakeup, flipped already
+		px = py = -1;
+		for (k=0; k<mouse.nevents; k++) {
+			e = &mouse.event[k];
+			if (e->down) held |= e->button;
+			else held &= ~e->button;
+			if (!e->down) continue;
+			ex = sx + e->dx < 0 ? 0 : sx + e->dx > 639 ? 639 : sx + e->dx;
+			ey = sy - e->dy < 0 ? 0 : sy - e->dy > 479 ? 479 : sy - e->dy;
+			if (e->button == MOUSE_LEFT) {
+				post_edit(LIFE_CMD_FLIP, ex, ey, 0, NULL);
+				px = ex;
+				py = ey;
+			}
+			else if (e->button == MOUSE_RIGHT && (held & MOUSE_LEFT))
+				post_edit(LIFE_CMD_CLEAR, ex, ey, 0, NULL);
+			else if (e->button == MOUSE_RIGHT)
+				post_edit(LIFE_CMD_STAMP, ex, ey, 0, life_pattern_gosper_gun);
+			else post_edit(LIFE_CMD_STAMP, ex, ey, 0, life_pattern_pi);
 		}
+		sx += mouse.dx;
+		sy -= mouse.dy;
+		sx = sx < 0 ? 0 : sx > 639 ? 639 : sx;
+		sy = sy < 0 ? 0 : sy > 479 ? 479 : sy;
+		// dragging with the left button held paints, but not over the cell
+		// that press flipped when the move ends still inside it
+		if ((held & MOUSE_LEFT) && (mouse.dx || mouse.dy) &&
+		    (px < 0 || px / z != sx / z || py / z != sy / z))
+			post_edit(LIFE_CMD_SET, sx, sy, 1, NULL);
+		__atomic_store_n(&cursor, sy << 16 | sx, __ATOMIC_RELAXED);
+	}
+	return NULL;
+}
+
+// cells for edits: the sparse engine's live on its plane, the others'
+// in the grid, round the torus if there is one
+void edit_set(void *ctx, int x, int y, int alive){
+	(void)ctx;
+	if (engine == ENGINE_SPARSE) life_sparse_set(&life_s, x, y, alive);
+	else life_set(x, y, alive);
+}
 
-		if (xchange==1) y = y + s2;
-		else x = x + s1;
+int edit_get(int x, int y){
+	if (engine == ENGINE_SPARSE) return life_sparse_get(&life_s, x, y);
+	return life_get(x, y);
+}
 
-		e = e + ((int)dy<<1);
+void edit_clear(void){
+	uint64_t gen = life_s.generation;
+	int y;
+
+	if (engine == ENGINE_SPARSE) {
+		life_sparse_clear(&life_s);
+		life_s.generation = gen;
+	}
+	else if (engine == ENGINE_BYTE) {
+		for (y=0; y<uni_h; y++) memset(LIFE_BYTE_ROW(&life_b, life_b.cur, y), 0, uni_w);
+		life_byte_set_wrap(&life_b, wrap);
+	}
+	else life_bits_clear(&life);
+}
+
+// the stepping thread, between generations: every edit waiting. returns
+// how many, and keeps the oldest post time for the frame that shows them
+int apply_edits(void){
+	life_cmd_t c;
+	life_place_t at;
+	life_pattern_info_t info;
+	int n = 0;
+
+	while (life_queue_take(&edits, &c)) {
+		if (c.op == LIFE_CMD_SET) edit_set(NULL, c.x, c.y, c.arg);
+		else if (c.op == LIFE_CMD_FLIP) edit_set(NULL, c.x, c.y, !edit_get(c.x, c.y));
+		else if (c.op == LIFE_CMD_CLEAR) edit_clear();
+		else if (c.op == LIFE_CMD_STAMP) {
+			at.set = edit_set;
+			at.ctx = NULL;
+			at.x = c.x;
+			at.y = c.y;
+			at.orient = 0;
+			life_pattern_parse(c.rle, &at, &info);
+		}
+		if (edit_oldest == 0 || c.posted < edit_oldest) edit_oldest = c.posted;
+		n++;
 	}
+	// the universe is not where it was, nor is the bits engine's hash
+	if (n > 0 && cycle_action != CYCLE_OFF) cycle_forget();
+	return n;
+}
+
+// the frame with edits posted at posted in it is on the screen
+void edit_shown(uint64_t posted){
+	vga_hud_line_t line;
+
+	edit_last_ms = (now_ns() - posted) / 1e6;
+	if (edit_last_ms > edit_max_ms) edit_max_ms = edit_last_ms;
+	edit_sum_ms += edit_last_ms;
+	edit_batches++;
+	vga_hud_start(&line);
+	vga_hud_add(&line, "edit=");
+	vga_hud_add_fix(&line, edit_last_ms, 5, 1);
+	vga_hud_add(&line, "mS max=");
+	vga_hud_add_fix(&line, edit_max_ms, 5, 1);
+	vga_hud_add(&line, "mS n=");
+	vga_hud_add_u(&line, edit_batches, 0);
+	vga_hud_pad(&hud, 1, 8, line.text, 40);
+}
+
+// the cursor is one red pixel through the shadow screen; hidden, the
+// pixel it covered is back
+void cursor_hide(void){
+	if (!cursor_shown) return;
+	vga_span_put(&span, cursor_at & 0xffff, cursor_at >> 16, cursor_under);
+	cursor_shown = 0;
+}
+
+void cursor_show(void){
+	int c = __atomic_load_n(&cursor, __ATOMIC_RELAXED), x = c & 0xffff, y = c >> 16;
+
+	cursor_at = c;
+	if (c < 0) return;
+	cursor_under = span.shadow[(long)y * span.width + x];
+	vga_span_put(&span, x, y, 0xe0);
+	cursor_shown = 1;
 }
 
 //////////////////////////////////////////////////////////
-// glider gun
+// rule for whichever engine is running
 //////////////////////////////////////////////////////////
-// x, y is the base postion
-// x_orient and y_orient must be 1 or -1
-// the -1 flips the orientation
-void glider_gun(int x, int y, int x_orient, int y_orient){
-	int xd=0, yd=0, xs=1, ys=1;
-	if (x_orient==-1) {
-		xd = 37;
-		xs = -1;
-	}
-	if (y_orient==-1) {
-		yd = 9;
-		ys = -1;
-	}
-	life[xd+x+xs*1][yd+y+ys*5]=1;
-	life[xd+x+xs*1][yd+y+ys*6]=1;
-	life[xd+x+xs*2][yd+y+ys*5]=1;
-	life[xd+x+xs*2][yd+y+ys*6]=1;
-	life[xd+x+xs*11][yd+y+ys*5]=1;
-	life[xd+x+xs*11][yd+y+ys*6]=1;
-	life[xd+x+xs*11][yd+y+ys*7]=1;
-	life[xd+x+xs*12][yd+y+ys*4]=1;
-	life[xd+x+xs*12][yd+y+ys*8]=1;
-	life[xd+x+xs*13][yd+y+ys*3]=1;
-	life[xd+x+xs*13][yd+y+ys*9]=1;
-	life[xd+x+xs*14][yd+y+ys*3]=1;
-	life[xd+x+xs*14][yd+y+ys*9]=1;
-	life[xd+x+xs*15][yd+y+ys*6]=1;
-	life[xd+x+xs*16][yd+y+ys*4]=1;
-	life[xd+x+xs*16][yd+y+ys*8]=1;
-	life[xd+x+xs*17][yd+y+ys*5]=1;
-	life[xd+x+xs*17][yd+y+ys*6]=1;
-	life[xd+x+xs*17][yd+y+ys*7]=1;
-	life[xd+x+xs*18][yd+y+ys*6]=1;
-	life[xd+x+xs*21][yd+y+ys*3]=1;
-	life[xd+x+xs*21][yd+y+ys*4]=1;
-	life[xd+x+xs*21][yd+y+ys*5]=1;
-	life[xd+x+xs*22][yd+y+ys*3]=1;
-	life[xd+x+xs*22][yd+y+ys*4]=1;
-	life[xd+x+xs*22][yd+y+ys*5]=1;
-	life[xd+x+xs*23][yd+y+ys*2]=1;
-	life[xd+x+xs*23][yd+y+ys*6]=1;
-	life[xd+x+xs*25][yd+y+ys*1]=1;
-	life[xd+x+xs*25][yd+y+ys*2]=1;
-	life[xd+x+xs*25][yd+y+ys*6]=1;
-	life[xd+x+xs*25][yd+y+ys*7]=1;
-	life[xd+x+xs*35][yd+y+ys*3]=1;
-	life[xd+x+xs*35][yd+y+ys*4]=1;
-	life[xd+x+xs*36][yd+y+ys*3]=1;
-	life[xd+x+xs*36][yd+y+ys*4]=1;	
-	
+void set_rule(const life_rule_t *r){
+	int n;
+	if (engine == ENGINE_BYTE) life_byte_set_rule(&life_b, r);
+	else life_bits_set_rule(&life, r);
+	if (engine == ENGINE_HASH) life_hash_set_rule(&life_h, r);
+	if (engine == ENGINE_SPARSE) life_sparse_set_rule(&life_s, r);
+	life_rule_format(r, rule_string, sizeof(rule_string));
+	// pad over a longer previous rule
+	for (n=strlen(rule_string); n<24; n++) rule_string[n] = ' ';
+	rule_string[n] = 0;
+}
+
+//////////////////////////////////////////////////////////
+// one band of a parallel step
+//////////////////////////////////////////////////////////
+void step_bits_band(void *g, int lo, int hi){
+	life_bits_step_tiles((life_bits_t *)g, lo, hi);
+}
+
+void step_byte_band(void *g, int lo, int hi){
+	life_byte_step_rows((life_byte_t *)g, lo, hi);
 }
@@ -0,0 +1,189 @@
+///////////////////////////////////////
+/// Bit grid to screen at any zoom:
+/// row fills zooming in, popcount
+/// density shading zooming out
+///////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "life_view.h"
+
+#define LIFE_VIEW_MAX_W 2048
+
+uint8_t life_view_shade(int live, int cells)
+{
+	int l;
+
+	if (live <= 0) return 0x00;
+	l = (live * 7 + cells - 1) / cells;     // 1..7, rounded up
+	if (l > 7) l = 7;
+	return (l << 5) | (l << 2) | (l >> 1);
+}
+
+static int life_view_mod(long v, int n)
+{
+	v %= n;
+	return v < 0 ? v + n : v;
+}
+
+static int life_view_cell(const life_bits_t *g, long x, long y)
+{
+	if (g->wrap) {
+		x = life_view_mod(x, g->width);
+		y = life_view_mod(y, g->height);
+	}
+	else if (x < 0 || y < 0 || x >= g->width || y >= g->height)
+		return 0;
+	return (LIFE_BITS_ROW(g, g->cur, y)[x >> 6] >> (x & 63)) & 1;
+}
+
+// live cells in [x, x+n) of row p, inside the grid
+static int life_view_count(const uint64_t *p, long x, long n)
+{
+	int c = 0, s;
+	uint64_t m;
+
+	while (n > 0) {
+		s = 64 - (x & 63);
+		if (s > n) s = n;
+		m = s == 64 ? ~0ULL : ((1ULL << s) - 1) << (x & 63);
+		c += __builtin_popcountll(p[x >> 6] & m);
+		x += s;
+		n -= s;
+	}
+	return c;
+}
+
+/****************************************************************************************
+ * Zoomed in: a row of cells is expanded once, then stored on zoom rows
+****************************************************************************************/
+static void life_view_zoom_in(const life_bits_t *g, vga_span_t *s, long x, long y, int zoom)
+{
+	uint8_t row[LIFE_VIEW_MAX_W];
+	int sy, sx, k, n;
+	long cy = y - 1;
+
+	for (sy=0; sy<s->height; sy++) {
+		if (y + sy / zoom != cy) {
+			cy = y + sy / zoom;
+			for (sx=0, k=0; sx<s->width; sx+=zoom, k++) {
+				n = s->width - sx < zoom ? s->width - sx : zoom;
+				memset(row + sx, life_view_cell(g, x + k, cy) ? 0xff : 0x00, n);
+			}
+		}
+		vga_span_row(s, 0, sy, row, s->width);
+	}
+}
+
+/****************************************************************************************
+ * Zoomed out: each screen row adds up the n cell rows of its blocks
+ * on a dead-edged grid the rows are first summed down each bit column into
+ * bit planes (plane k holds bit k of every column's count), four rows per
+ * pass, so that each block needs a few popcounts per plane instead of a few
+ * per cell row; every screen column's words and edge masks are worked out
+ * once, up front. a torus can wrap inside a block and takes the slower,
+ * general count
+****************************************************************************************/
+static void life_view_zoom_out(const life_bits_t *g, vga_span_t *s, long x, long y, int n)
+{
+	int w0[LIFE_VIEW_MAX_W], w1[LIFE_VIEW_MAX_W], cnt[LIFE_VIEW_MAX_W];
+	uint64_t m0[LIFE_VIEW_MAX_W], m1[LIFE_VIEW_MAX_W];
+	uint8_t row[LIFE_VIEW_MAX_W];
+	const uint64_t *p, *src[4];
+	uint64_t *plane = NULL, *q, carry, t, u, v[3];
+	long a, b, k, cx, cy, r;
+	int sx, sy, w, c, planes, wlo = g->words, whi = -1, nw = 0;
+
+	for (planes=1; (n >> planes) != 0; planes++);
+	for (sx=0; sx<s->width; sx++) {
+		a = x + (long)sx * n;
+		b = a + n;
+		if (g->wrap) {
+			w0[sx] = life_view_mod(a, g->width);
+			continue;
+		}
+		if (a < 0) a = 0;
+		if (b > g->width) b = g->width;
+		if (b <= a) {
+			// nothing of the grid under this column
+			w0[sx] = w1[sx] = -1;
+			continue;
+		}
+		w0[sx] = a >> 6;
+		w1[sx] = (b - 1) >> 6;
+		m0[sx] = ~0ULL << (a & 63);
+		m1[sx] = ~0ULL >> (63 - ((b - 1) & 63));
+		if (w0[sx] == w1[sx]) m0[sx] = m1[sx] = m0[sx] & m1[sx];
+		if (w0[sx] < wlo) wlo = w0[sx];
+		if (w1[sx] > whi) whi = w1[sx];
+	}
+	if (!g->wrap && whi >= wlo) {
+		nw = whi - wlo + 1;
+		if ((plane = calloc((size_t)(planes + 1) * nw, sizeof(uint64_t))) == NULL) return;
+	}
+
+	for (sy=0; sy<s->height; sy++) {
+		memset(cnt, 0, s->width * sizeof(int));
+		if (plane) memset(plane, 0, (size_t)planes * nw * sizeof(uint64_t));
+		if (g->wrap) {
+			for (r=0; r<n; r++) {
+				// round the torus, as many times as the block needs
+				p = LIFE_BITS_ROW(g, g->cur, life_view_mod(y + (long)sy * n + r, g->height));
+				for (sx=0; sx<s->width; sx++) {
+					for (b=n, cx=w0[sx]; b>0; b-=k, cx=0) {
+						k = g->width - cx < b ? g->width - cx : b;
+						cnt[sx] += life_view_count(p, cx, k);
+					}
+				}
+			}
+		}
+		for (r=0; plane && r<n; r+=4) {
+			// four rows at a time through a full and a half adder, rows
+			// off the grid reading as the zero row after the planes
+			for (k=0; k<4; k++) {
+				cy = y + (long)sy * n + r + k;
+				if (r + k >= n || cy < 0 || cy >= g->height) src[k] = plane + planes * nw;
+				else src[k] = LIFE_BITS_ROW(g, g->cur, cy) + wlo;
+			}
+			for (w=0; w<nw; w++) {
+				u = src[0][w] ^ src[1][w];
+				t = u ^ src[2][w];
+				carry = (src[0][w] & src[1][w]) | (u & src[2][w]);
+				v[0] = t ^ src[3][w];
+				u = t & src[3][w];
+				v[1] = carry ^ u;
+				v[2] = carry & u;
+				// and the 3-bit sum into the planes; n < 2^planes, no overflow
+				for (k=0, carry=0, q=plane+w; k<planes; k++, q+=nw) {
+					t = k < 3 ? v[k] : 0;
+					if (k >= 3 && !carry) break;
+					u = *q ^ t;
+					t = (*q & t) | (carry & u);
+					*q = u ^ carry;
+					carry = t;
+				}
+			}
+		}
+		for (sx=0; plane && sx<s->width; sx++) {
+			if (w0[sx] < 0) continue;
+			for (k=0, q=plane-wlo; k<planes; k++, q+=nw) {
+				c = __builtin_popcountll(q[w0[sx]] & m0[sx]);
+				if (w1[sx] != w0[sx]) {
+					for (w=w0[sx]+1; w<w1[sx]; w++) c += __builtin_popcountll(q[w]);
+					c += __builtin_popcountll(q[w1[sx]] & m1[sx]);
+				}
+				cnt[sx] += c << k;
+			}
+		}
+		for (sx=0; sx<s->width; sx++) row[sx] = life_view_shade(cnt[sx], n * n);
+		vga_span_row(s, 0, sy, row, s->width);
+	}
+	free(plane);
+}
+
+void life_view_draw(const life_bits_t *g, vga_span_t *s, int x, int y, int zoom)
+{
+	if (s->width > LIFE_VIEW_MAX_W) return;
+	if (zoom >= 1) life_view_zoom_in(g, s, x, y, zoom);
+	else if (zoom <= -2) life_view_zoom_out(g, s, x, y, -zoom);
+	else life_view_zoom_in(g, s, x, y, 1);
+}
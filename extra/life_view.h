@@ -0,0 +1,33 @@
+/* Drawing a bit grid onto the screen at any zoom.
+ *
+ * The view puts universe cell (x, y) at the top left of a vga_span_t
+ * screen and either magnifies, every cell a zoom x zoom block of pixels,
+ * or shrinks, every pixel standing for the N x N block of cells under it
+ * (zoom = -N) and shaded by how many of them are alive.
+ *
+ * Both are drawn a screen row at a time through vga_span_row().  Zooming in
+ * expands a row of cells into pixels once and repeats it on zoom screen
+ * rows.  Zooming out first adds the N cell rows under a screen row down
+ * every bit column, bit-sliced into log2(N) planes with plain logic ops on
+ * the packed words, then counts each block with a popcount or two per plane,
+ * the word range and edge masks of every screen column worked out once per
+ * frame.
+ *
+ * Cells outside a dead-edged grid count as dead; on a torus the view
+ * wraps around.
+ */
+#ifndef LIFE_VIEW_H
+#define LIFE_VIEW_H
+
+#include <stdint.h>
+#include "life_bits.h"
+#include "vga_span.h"
+
+// 8-bit colour (RRRGGGBB) for live of cells alive: black to white in
+// eight grey steps, any live cell at all at least the first step
+uint8_t life_view_shade(int live, int cells);
+
+// draw the whole screen of s; zoom >= 1 magnifies, zoom <= -2 shrinks
+void life_view_draw(const life_bits_t *g, vga_span_t *s, int x, int y, int zoom);
+
+#endif
@@ -4,14 +4,15 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 #include "address_map_arm_brl4.h"
+#include "vga_dev.h"
+#include "vga_hud.h"
+#include "vga_raster.h"
+// compile with gcc media_brl4_2.c vga_hud.c vga_raster.c vga_fill.c ../vga_dev.c -I.. -o media_brl4_2
 // VGA, keys, and LEDs
 
 #define SWAP(X,Y) do{int temp=X; X=Y; Y=temp;}while(0) 
 
 /* function prototypes */
-void VGA_text (int, int, char *);
-void VGA_box (int, int, int, int, short);
-void VGA_line(int, int, int, int, short) ;
 
 // virtual to real address pointers
 
@@ -24,7 +25,8 @@ void *vga_pixel_virtual_base;
 volatile unsigned int * vga_char_ptr = NULL ;
 void *vga_char_virtual_base;
 
-int fd;
+vga_dev_t dev;
+vga_raster_t raster;
 
 int x1, y1, x2, y2;
 
@@ -34,52 +36,19 @@ int main(void)
 	// instead of regular memory loads and stores) 
 
   	
-	// === need to mmap: =======================
-	// FPGA_CHAR_BASE
-	// FPGA_ONCHIP_BASE      
-	// HW_REGS_BASE        
-  
 	// === get FPGA addresses ==================
-    // Open /dev/mem
-	if( ( fd = open( "/dev/mem", ( O_RDWR | O_SYNC ) ) ) == -1 ) 	{
-		printf( "ERROR: could not open \"/dev/mem\"...\n" );
-		return( 1 );
-	}
-    
-    // get virtual addr that maps to physical
-	h2p_lw_virtual_base = mmap( NULL, HW_REGS_SPAN, ( PROT_READ 		| PROT_WRITE ), MAP_SHARED, fd, HW_REGS_BASE );	
-	if( h2p_lw_virtual_base == MAP_FAILED ) {
-		printf( "ERROR: mmap1() failed...\n" );
-		close( fd );
-		return(1);
-	}
+	// /dev/mem, or plain memory when DE1_SIM is set (see vga_dev.h)
+	if (vga_dev_open(&dev, NULL) != 0) return(1);
+	h2p_lw_virtual_base = dev.regs_base;
     
     // Get the address that maps to the FPGA LED control 
 	red_LED_ptr =(unsigned int *)(h2p_lw_virtual_base +  	 			LEDR_BASE);
 
-	// === get VGA char addr =====================
-	// get virtual addr that maps to physical
-	vga_char_virtual_base = mmap( NULL, FPGA_CHAR_SPAN, ( 	PROT_READ 	| PROT_WRITE ), MAP_SHARED, fd, FPGA_CHAR_BASE );	
-	if( vga_char_virtual_base == MAP_FAILED ) {
-		printf( "ERROR: mmap2() failed...\n" );
-		close( fd );
-		return(1);
-	}
-    
-    // Get the address that maps to the FPGA LED control 
+	vga_char_virtual_base = dev.char_base;
 	vga_char_ptr =(unsigned int *)(vga_char_virtual_base);
-
-	// === get VGA pixel addr ====================
-	// get virtual addr that maps to physical
-	vga_pixel_virtual_base = mmap( NULL, FPGA_ONCHIP_SPAN, ( 	PROT_READ 	| PROT_WRITE ), MAP_SHARED, fd, 			FPGA_ONCHIP_BASE);	
-	if( vga_pixel_virtual_base == MAP_FAILED ) {
-		printf( "ERROR: mmap3() failed...\n" );
-		close( fd );
-		return(1);
-	}
-    
-    // Get the address that maps to the FPGA LED control 
+	vga_pixel_virtual_base = dev.pixel_base;
 	vga_pixel_ptr =(unsigned int *)(vga_pixel_virtual_base);
+	vga_raster_init(&raster, vga_pixel_ptr, 1024, 320, 240, 2);
 
 	// ===========================================
 
@@ -88,14 +57,14 @@ int main(void)
 	char text_top_row[40] = "Altera DE1-SoC\0";
 	char text_bottom_row[40] = "Cornell ece5760\0";
 
-	VGA_text (34, 29, text_top_row);
-	VGA_text (34, 30, text_bottom_row);
+	vga_hud_write(vga_char_ptr, 34, 29, text_top_row);
+	vga_hud_write(vga_char_ptr, 34, 30, text_bottom_row);
 	// clear the screen
-	VGA_box (0, 0, 319, 239, 0);
+	vga_raster_box(&raster, 0, 0, 319, 239, 0);
 	// x1 y1 x2 y2	320x240					
-	//VGA_box (33*4, 28*4, 49*4, 32*4, 0x187F);
-	//VGA_box (100, 210, 300, 220, 0xffe0);
-	//VGA_line(10, 20, 100, 50, 0xf000) ;
+	//vga_raster_box(&raster, 33*4, 28*4, 49*4, 32*4, 0x187F);
+	//vga_raster_box(&raster, 100, 210, 300, 220, 0xffe0);
+	//vga_raster_line(&raster, 10, 20, 100, 50, 0xf000) ;
 
 	short color ;
 	while(1)
@@ -111,121 +80,7 @@ int main(void)
 		if (y2>319) y2 = 239;
 		if (x1>x2) SWAP(x1,x2);
 		if (y1>y2) SWAP(y1,y2);
-		VGA_box (x1,y1,x2,y2, rand() & 0xffff);
+		vga_raster_box(&raster, x1,y1,x2,y2, rand() & 0xffff);
 		*(red_LED_ptr) = 0x0;		// turn off LEDR_0							
 	}
 }
-
-/****************************************************************************************
- * Subroutine to send a string of text to the VGA monitor 
-****************************************************************************************/
-void VGA_text(int x, int y, char * text_ptr)
-{
-	int offset;
-  	volatile char * character_buffer = (char *) vga_char_ptr ;	// VGA character buffer
-
-	/* assume that the text string fits on one line */
-	offset = (y << 7) + x;
-	while ( *(text_ptr) )
-	{
-		// write to the character buffer
-		*(character_buffer + offset) = *(text_ptr);	
-		++text_ptr;
-		++offset;
-	}
-}
-
-/****************************************************************************************
- * Draw a filled rectangle on the VGA monitor 
-****************************************************************************************/
-void VGA_box(int x1, int y1, int x2, int y2, short pixel_color)
-{
-	int *pixel_ptr, row, col;
-
-	/* assume that the box coordinates are valid */
-	for (row = y1; row <= y2; row++)
-		for (col = x1; col <= x2; ++col)
-		{
-			pixel_ptr = (char *)vga_pixel_ptr + (row << 10)    + (col << 1); 
-			// set pixel color
-			*(short *)pixel_ptr = pixel_color;		
-		}
-}
-
-// =============================================
-// === Draw a line
-// =============================================
-//plot a line 
-//at x1,y1 to x2,y2 with color 
-//Code is from David Rodgers,
-//"Procedural Elements of Computer Graphics",1985
-void VGA_line(int x1, int y1, int x2, int y2, short c) {
-	int e;
-	signed int dx,dy,j, temp;
-	signed int s1,s2, xchange;
-     signed int x,y;
-	int *pixel_ptr ;
-        
-	x = x1;
-	y = y1;
-	
-	//take absolute value
-	if (x2 < x1) {
-		dx = x1 - x2;
-		s1 = -1;
-	}
-
-	else if (x2 == x1) {
-		dx = 0;
-		s1 = 0;
-	}
-
-	else {
-		dx = x2 - x1;
-		s1 = 1;
-	}
-
-	if (y2 < y1) {
-		dy = y1 - y2;
-		s2 = -1;
-	}
-
-	else if (y2 == y1) {
-		dy = 0;
-		s2 = 0;
-	}
-
-	else {
-		dy = y2 - y1;
-		s2 = 1;
-	}
-
-	xchange = 0;   
-
-	if (dy>dx) {
-		temp = dx;
-		dx = dy;
-		dy = temp;
-		xchange = 1;
-	} 
-
-	e = ((int)dy<<1) - dx;  
-	 
-	for (j=0; j<=dx; j++) {
-		//video_pt(x,y,c);
-		pixel_ptr = (char *)vga_pixel_ptr + (y<<10)+ (x<< 1); 
-		// set pixel color
-		*(short *)pixel_ptr = c;	
-		 
-		if (e>=0) {
-			if (xchange==1) x = x + s1;
-			else y = y + s2;
-			e = e - ((int)dx<<1);
-		}
-
-		if (xchange==1) y = y + s2;
-		else x = x + s1;
-
-		e = e + ((int)dy<<1);
-	}
-}
\ No newline at end of file
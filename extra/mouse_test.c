@@ -1,48 +1,107 @@
 ///////////////////////////////////////////////////////////////////////
-// Mouse test from 
+// Mouse test, after
 // http://stackoverflow.com/questions/11451618/how-do-you-read-the-mouse-button-state-from-dev-input-mice
+// now through ../mouse_dev.h: one line per wakeup, not per packet
 //
-// Native ARM GCC Compile: gcc mouse_test.c -o mouse
+// Native ARM GCC Compile: gcc mouse_test.c ../mouse_dev.c -I.. -o mouse
+// usage: mouse [-c] [device]
+//   device defaults to $DE1_MOUSE, then /dev/input/mice; a FIFO works:
+//     mkfifo /tmp/mice; DE1_MOUSE=/tmp/mice ./mouse &
+//     printf '\x09\x05\xfb' > /tmp/mice
+//   -c feeds packets through a pipe and checks what comes out
 //
 ///////////////////////////////////////////////////////////////////////
 
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <assert.h>
+#include "mouse_dev.h"
+
+int self_check(void);
 
 int main(int argc, char** argv)
 {
-    int fd, bytes;
-    unsigned char data[3];
+    mouse_dev_t mouse;
+    int k;
+
+    if (argc > 1 && strcmp(argv[1], "-c") == 0) return self_check();
 
-    const char *pDevice = "/dev/input/mice";
+    // Open Mouse, and tick once a second
+    if (mouse_dev_open(&mouse, argc > 1 ? argv[1] : NULL, 1) != 0) return -1;
 
-    // Open Mouse
-    fd = open(pDevice, O_RDWR);
-    if(fd == -1)
+    // sleeps until there is something to print
+    while (mouse_dev_wait(&mouse, -1) >= 0)
     {
-        printf("ERROR Opening %s\n", pDevice);
-        return -1;
+        if (mouse.packets == 0) continue;
+        printf("packets=%d dx=%d dy=%d held=%d\n", mouse.packets, mouse.dx, mouse.dy,
+               mouse.buttons);
+        for (k = 0; k < mouse.nevents; k++)
+            printf("  %s %s at dx=%d dy=%d\n",
+                   mouse.event[k].button == MOUSE_LEFT ? "left" :
+                   mouse.event[k].button == MOUSE_RIGHT ? "right" : "middle",
+                   mouse.event[k].down ? "down" : "up", mouse.event[k].dx, mouse.event[k].dy);
     }
+    mouse_dev_close(&mouse);
+    return 0;
+}
 
-    int left, middle, right;
-    signed char x, y;
-    while(1)
-    {
-        // Read Mouse     
-        bytes = read(fd, data, sizeof(data));
-
-        if(bytes > 0)
-        {
-            left = data[0] & 0x1;
-            right = data[0] & 0x2;
-            middle = data[0] & 0x4;
-
-            x = data[1];
-            y = data[2];
-            printf("x=%d, y=%d, left=%d, middle=%d, right=%d\n", x, y, left, middle, right);
-        }   
+// packets written into a pipe come out of one wait summed, with each
+// button change where it happened; a stray byte is skipped, a packet
+// split across writes is put back together, more changes than one wait
+// holds spill into the next, and closing the pipe ends the input
+int self_check(void)
+{
+    mouse_dev_t mouse;
+    unsigned char burst[] = {
+        0x08, 5, 1,                     // move
+        0x42,                           // not a packet start
+        0x09, 3, 0xff,                  // left down, (3, -1)
+        0x08, 0xfe, 2,                  // left up
+        0x0a, 0, 0,                     // right down
+    };
+    unsigned char many[3 * 40];
+    int fd[2], k;
+
+    assert(pipe(fd) == 0);
+    assert(mouse_dev_open_fd(&mouse, fd[0], 0) == 0);
+    assert(mouse_dev_wait(&mouse, 0) == 0);
+
+    assert(write(fd[1], burst, sizeof(burst)) == sizeof(burst));
+    assert(mouse_dev_wait(&mouse, -1) == 1);
+    assert(mouse.packets == 4 && mouse.dx == 6 && mouse.dy == 2);
+    assert(mouse.nevents == 3 && mouse.buttons == MOUSE_RIGHT);
+    assert(mouse.event[0].button == MOUSE_LEFT && mouse.event[0].down);
+    assert(mouse.event[0].dx == 8 && mouse.event[0].dy == 0);
+    assert(mouse.event[1].button == MOUSE_LEFT && !mouse.event[1].down);
+    assert(mouse.event[2].button == MOUSE_RIGHT && mouse.event[2].down);
+
+    // half a packet, then the rest
+    assert(write(fd[1], "\x08\x07", 2) == 2);
+    assert(mouse_dev_wait(&mouse, -1) == 0 && mouse.packets == 0);
+    assert(write(fd[1], "\x01", 1) == 1);
+    assert(mouse_dev_wait(&mouse, -1) == 1 && mouse.packets == 1);
+    assert(mouse.dx == 7 && mouse.dy == 1 && mouse.nevents == 1 && !mouse.event[0].down);
+
+    // 40 clicks, 80 changes, in one write
+    for (k = 0; k < 40; k++) {
+        many[3*k] = k & 1 ? 0x08 : 0x0c;
+        many[3*k+1] = 1;
+        many[3*k+2] = 0;
     }
-    return 0; 
+    assert(write(fd[1], many, sizeof(many)) == sizeof(many));
+    for (k = 0; k < 40; k += mouse.packets) {
+        assert(mouse_dev_wait(&mouse, -1) == 1);
+        assert(mouse.nevents == mouse.packets && mouse.dx == mouse.packets);
+        assert(mouse.event[0].button == MOUSE_MIDDLE && mouse.event[0].down == !(k & 1));
+    }
+    assert(k == 40 && mouse.buttons == 0);
+
+    close(fd[1]);
+    assert(mouse_dev_wait(&mouse, -1) == -1 && mouse.eof);
+    mouse_dev_close(&mouse);
+    close(fd[0]);
+    printf("mouse ok\n");
+    return 0;
 }
-	
@@ -0,0 +1,307 @@
+///////////////////////////////////////
+/// Primitives per second: the old
+/// VGA_box/VGA_line/VGA_disc against
+/// vga_raster, drawn one by one and
+/// through a command list
+/// compile with
+/// gcc raster_bench.c vga_raster.c vga_fill.c ../vga_dev.c -I.. -o raster_bench -O2 -mfpu=neon
+/// usage: raster_bench [-n count] [-r reps] [-s seed] [-b rows]
+///   draws count random primitives of each kind (small boxes, large
+///   boxes, lines, discs) into the pixel buffer, all inside the 640x480
+///   screen so every routine sets the same pixels, and prints one JSON
+///   document on stdout, progress on stderr; the best of reps runs.
+///   the pixel buffer is /dev/mem, or plain memory with DE1_SIM set
+///   (see vga_dev.h). -b sets the command list's band, in rows; 0
+///   is one band for the whole screen. defaults: 20000 of each, 3
+///   repetitions, -b 0
+///////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "vga_dev.h"
+#include "vga_raster.h"
+
+#define SWAP(X,Y) do{int temp=X; X=Y; Y=temp;}while(0)
+
+volatile unsigned int * vga_pixel_ptr = NULL ;
+
+/****************************************************************************************
+ * The routines as the programs carried them, 8-bit 640x480
+****************************************************************************************/
+void VGA_box(int x1, int y1, int x2, int y2, short pixel_color)
+{
+	char  *pixel_ptr ;
+	int row, col;
+
+	/* check and fix box coordinates to be valid */
+	if (x1>639) x1 = 639;
+	if (y1>479) y1 = 479;
+	if (x2>639) x2 = 639;
+	if (y2>479) y2 = 479;
+	if (x1<0) x1 = 0;
+	if (y1<0) y1 = 0;
+	if (x2<0) x2 = 0;
+	if (y2<0) y2 = 0;
+	if (x1>x2) SWAP(x1,x2);
+	if (y1>y2) SWAP(y1,y2);
+	for (row = y1; row <= y2; row++)
+		for (col = x1; col <= x2; ++col)
+		{
+			//640x480
+			pixel_ptr = (char *)vga_pixel_ptr + (row<<10)    + col ;
+			// set pixel color
+			*(char *)pixel_ptr = pixel_color;
+		}
+}
+
+void VGA_disc(int x, int y, int r, short pixel_color)
+{
+	char  *pixel_ptr ;
+	int row, col, rsqr, xc, yc;
+
+	rsqr = r*r;
+
+	for (yc = -r; yc <= r; yc++)
+		for (xc = -r; xc <= r; xc++)
+		{
+			col = xc;
+			row = yc;
+			// add the r to make the edge smoother
+			if(col*col+row*row <= rsqr+r){
+				col += x; // add the center point
+				row += y; // add the center point
+				//check for valid 640x480
+				if (col>639) col = 639;
+				if (row>479) row = 479;
+				if (col<0) col = 0;
+				if (row<0) row = 0;
+				pixel_ptr = (char *)vga_pixel_ptr + (row<<10) + col ;
+				// set pixel color
+				*(char *)pixel_ptr = pixel_color;
+			}
+		}
+}
+
+void VGA_line(int x1, int y1, int x2, int y2, short c) {
+	int e;
+	signed int dx,dy,j, temp;
+	signed int s1,s2, xchange;
+	signed int x,y;
+	char *pixel_ptr ;
+
+	/* check and fix line coordinates to be valid */
+	if (x1>639) x1 = 639;
+	if (y1>479) y1 = 479;
+	if (x2>639) x2 = 639;
+	if (y2>479) y2 = 479;
+	if (x1<0) x1 = 0;
+	if (y1<0) y1 = 0;
+	if (x2<0) x2 = 0;
+	if (y2<0) y2 = 0;
+
+	x = x1;
+	y = y1;
+
+	//take absolute value
+	if (x2 < x1) {
+		dx = x1 - x2;
+		s1 = -1;
+	}
+	else if (x2 == x1) {
+		dx = 0;
+		s1 = 0;
+	}
+	else {
+		dx = x2 - x1;
+		s1 = 1;
+	}
+
+	if (y2 < y1) {
+		dy = y1 - y2;
+		s2 = -1;
+	}
+	else if (y2 == y1) {
+		dy = 0;
+		s2 = 0;
+	}
+	else {
+		dy = y2 - y1;
+		s2 = 1;
+	}
+
+	xchange = 0;
+
+	if (dy>dx) {
+		temp = dx;
+		dx = dy;
+		dy = temp;
+		xchange = 1;
+	}
+
+	e = ((int)dy<<1) - dx;
+
+	for (j=0; j<=dx; j++) {
+		//video_pt(x,y,c); //640x480
+		pixel_ptr = (char *)vga_pixel_ptr + (y<<10)+ x;
+		// set pixel color
+		*(char *)pixel_ptr = c;
+
+		if (e>=0) {
+			if (xchange==1) x = x + s1;
+			else y = y + s2;
+			e = e - ((int)dx<<1);
+		}
+
+		if (xchange==1) y = y + s2;
+		else x = x + s1;
+
+		e = e + ((int)dy<<1);
+	}
+}
+
+/****************************************************************************************
+ * One kind of primitive, three ways
+****************************************************************************************/
+#define KIND_BOX_SMALL 0
+#define KIND_BOX_LARGE 1
+#define KIND_LINE      2
+#define KIND_DISC      3
+#define KINDS          4
+
+static const char *kind_names[KINDS] = { "box-small", "box-large", "line", "disc" };
+
+typedef struct prim { int x1, y1, x2, y2, color; } prim_t;
+
+vga_raster_t raster;
+vga_raster_list_t list;
+
+// random ones of a kind, wholly on the screen
+static void make_prims(prim_t *p, int n, int kind)
+{
+	int k, w;
+
+	for (k=0; k<n; k++) {
+		p[k].color = rand() & 0xff;
+		if (kind == KIND_DISC) {
+			p[k].x2 = rand() % 40;
+			p[k].x1 = p[k].x2 + rand() % (640 - 2 * p[k].x2);
+			p[k].y1 = p[k].x2 + rand() % (480 - 2 * p[k].x2);
+			continue;
+		}
+		p[k].x1 = rand() % 640;
+		p[k].y1 = rand() % 480;
+		if (kind == KIND_LINE) {
+			p[k].x2 = rand() % 640;
+			p[k].y2 = rand() % 480;
+			continue;
+		}
+		w = kind == KIND_BOX_SMALL ? 32 : 320;
+		p[k].x2 = p[k].x1 + rand() % w;
+		p[k].y2 = p[k].y1 + rand() % w;
+		if (p[k].x2 > 639) p[k].x2 = 639;
+		if (p[k].y2 > 479) p[k].y2 = 479;
+	}
+}
+
+// way 0: the old routine, 1: vga_raster, 2: vga_raster through the list
+static void draw_prims(const prim_t *p, int n, int kind, int way)
+{
+	int k;
+
+	for (k=0; k<n; k++) {
+		if (way == 0) {
+			if (kind == KIND_DISC) VGA_disc(p[k].x1, p[k].y1, p[k].x2, p[k].color);
+			else if (kind == KIND_LINE) VGA_line(p[k].x1, p[k].y1, p[k].x2, p[k].y2, p[k].color);
+			else VGA_box(p[k].x1, p[k].y1, p[k].x2, p[k].y2, p[k].color);
+		}
+		else if (way == 1) {
+			if (kind == KIND_DISC) vga_raster_disc(&raster, p[k].x1, p[k].y1, p[k].x2, p[k].color);
+			else if (kind == KIND_LINE) vga_raster_line(&raster, p[k].x1, p[k].y1, p[k].x2, p[k].y2, p[k].color);
+			else vga_raster_box(&raster, p[k].x1, p[k].y1, p[k].x2, p[k].y2, p[k].color);
+		}
+		else {
+			if (kind == KIND_DISC) vga_raster_add_disc(&list, p[k].x1, p[k].y1, p[k].x2, p[k].color);
+			else if (kind == KIND_LINE) vga_raster_add_line(&list, p[k].x1, p[k].y1, p[k].x2, p[k].y2, p[k].color);
+			else vga_raster_add_box(&list, p[k].x1, p[k].y1, p[k].x2, p[k].y2, p[k].color);
+		}
+	}
+	if (way == 2) vga_raster_flush(&list);
+}
+
+static double now_s(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+	static const char *way_names[3] = { "old", "raster", "batched" };
+	vga_dev_t dev;
+	prim_t *p;
+	uint8_t *seen[3];
+	double best[3], t;
+	int opt, n = 20000, reps = 3, seed = 5760, band = 0, kind, way, r, y, same;
+
+	while ((opt = getopt(argc, argv, "n:r:s:b:")) != -1) {
+		switch (opt) {
+		case 'n': n = atoi(optarg); break;
+		case 'r': reps = atoi(optarg); break;
+		case 's': seed = atoi(optarg); break;
+		case 'b': band = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-n count] [-r reps] [-s seed] [-b rows]\n", argv[0]);
+			return(1);
+		}
+	}
+	if (n < 1 || reps < 1 || band < 0) {
+		fprintf(stderr, "ERROR: need -n >= 1, -r >= 1, -b >= 0...\n");
+		return(1);
+	}
+	if (vga_dev_open(&dev, NULL) != 0) return(1);
+	vga_pixel_ptr = (unsigned int *)dev.pixel_base;
+	p = malloc(n * sizeof(prim_t));
+	for (way=0; way<3; way++) seen[way] = malloc(640 * 480);
+	if (p == NULL || seen[0] == NULL || seen[1] == NULL || seen[2] == NULL ||
+	    vga_raster_init(&raster, vga_pixel_ptr, 1024, 640, 480, 1) != 0 ||
+	    vga_raster_list_init(&list, &raster, 256, band) != 0) {
+		fprintf(stderr, "ERROR: could not allocate the primitives...\n");
+		return(1);
+	}
+
+	printf("{\"benchmark\": \"raster\", \"count\": %d, \"reps\": %d, \"band\": %d,\n \"results\": [",
+	       n, reps, 1 << list.shift);
+	for (kind=0; kind<KINDS; kind++) {
+		srand(seed + kind);
+		make_prims(p, n, kind);
+		for (way=0; way<3; way++) {
+			best[way] = 0;
+			for (r=0; r<reps; r++) {
+				vga_raster_box(&raster, 0, 0, 639, 479, 0);
+				t = now_s();
+				draw_prims(p, n, kind, way);
+				t = now_s() - t;
+				if (best[way] == 0 || t < best[way]) best[way] = t;
+			}
+			// what the last run left on the screen
+			for (y=0; y<480; y++)
+				memcpy(seen[way] + y * 640, (uint8_t *)dev.pixel_base + y * 1024, 640);
+			fprintf(stderr, "%s %s: %.0f/s\n", kind_names[kind], way_names[way], n / best[way]);
+		}
+		same = memcmp(seen[0], seen[1], 640 * 480) == 0 && memcmp(seen[0], seen[2], 640 * 480) == 0;
+		printf("%s\n    {\"primitive\": \"%s\", \"old_per_s\": %.0f, \"raster_per_s\": %.0f, "
+		       "\"batched_per_s\": %.0f, \"same_pixels\": %s}", kind ? "," : "", kind_names[kind],
+		       n / best[0], n / best[1], n / best[2], same ? "true" : "false");
+		fflush(stdout);
+	}
+	printf("\n ]}\n");
+	vga_raster_list_free(&list);
+	for (way=0; way<3; way++) free(seen[way]);
+	free(p);
+	vga_dev_close(&dev);
+	return(0);
+}
@@ -1,13 +1,20 @@
 /* Simple demo file to experiment with the VGA controller on the DE1-SoC
  * Computer System by Altera.
+ *
+ * gcc vga_demo.c ../mouse_dev.c -I.. -o vga_demo
+ * usage: vga_demo [-v]
+ *   -v prints where the cursor went after each wakeup; mouse_test shows
+ *   the packets themselves
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/shm.h>
 #include "address_map_arm_brl4.h"
+#include "mouse_dev.h"
 
 #define PIXEL_COLS  (unsigned int)640
 #define PIXEL_ROWS  (unsigned int)480
@@ -22,8 +29,10 @@ void draw_rect(volatile unsigned char *, unsigned short,
                unsigned int, unsigned int,
                unsigned int, unsigned int);
 
-int main()
+int main(int argc, char** argv)
 {
+    int verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
     // Create a file descriptor for "/dev/mem"
     int fd_mem;
     if ((fd_mem = open("/dev/mem", (O_RDWR|O_SYNC))) == -1) {
@@ -32,15 +41,9 @@ int main()
         return 1;
     }
 
-    // Create a file descriptor for "/dev/input/mice"
-    int fd_mouse;
-    if ((fd_mouse = open("/dev/input/mice", (O_RDWR|O_SYNC))) == -1) {
-        printf("Error: failed to open \"/dev/input/mice\".\n");
-        close(fd_mouse);
-        return 1;
-    }
-    int flags = fcntl(fd_mouse, F_GETFL, 0);
-    fcntl(fd_mouse, F_SETFL, flags | O_NONBLOCK);
+    // "/dev/input/mice", or $DE1_MOUSE (see mouse_dev.h)
+    mouse_dev_t mouse;
+    if (mouse_dev_open(&mouse, NULL, 0) != 0) return 1;
 
     // Map the pixel buffer to a virtual address
     void *pixel_buffer_addr;
@@ -58,41 +61,34 @@ int main()
     volatile unsigned char *pixel_end = (unsigned char *)(pixel_buffer_addr +
                                                           FPGA_ONCHIP_SPAN);
 
-    // Read data from the mouse
-    int bytes;
-    int left, middle, right;
-    int x, y = 0;
-    signed char data[3];
+    // Read data from the mouse: sleeps until it moves, then takes
+    // every packet waiting as one move
+    int x = 0, y = 0;
 
-    while (1) {
-        bytes = read(fd_mouse, data, sizeof(data));
+    while (mouse_dev_wait(&mouse, -1) >= 0) {
+        if (mouse.packets == 0) continue;
 
-        if (bytes > 0) {
-            left = data[0] & 0x1;   // first bit
-            middle = data[0] & 0x2; // second bit
-            right = data[0] & 0x4;  // third bit
+        draw_rect(pixel, BLACK, x-2, y-2, x+2, y+2);
 
-            draw_rect(pixel, BLACK, x-2, y-2, x+2, y+2);
+        x += mouse.dx;
+        if (x < 0) x = 0;
+        else if (x > PIXEL_COLS) x = PIXEL_COLS;
+        y -= mouse.dy;
+        if (y < 0) y = 0;
+        else if (y > PIXEL_ROWS) y = PIXEL_ROWS;
 
-            x += data[1];
-            if (x < 0) x = 0;
-            else if (x > PIXEL_COLS) x = PIXEL_COLS;
-            y -= data[2];
-            if (y < 0) y = 0;
-            else if (y > PIXEL_ROWS) y = PIXEL_ROWS;
-
-            draw_rect(pixel, WHITE, x-2, y-2, x+2, y+2);
-            printf("x: %d\ty: %d\n", x, y);
-        }
+        draw_rect(pixel, WHITE, x-2, y-2, x+2, y+2);
+        if (verbose) printf("x: %d\ty: %d\t(%d packets)\n", x, y, mouse.packets);
     }
 
+    mouse_dev_close(&mouse);
     return 0;
 }
 
-inline unsigned int max(unsigned int x1, unsigned int x2)
+static inline unsigned int max(unsigned int x1, unsigned int x2)
 { return x1 > x2 ? x1 : x2; }
 
-inline unsigned int min(unsigned int x1, unsigned int x2)
+static inline unsigned int min(unsigned int x1, unsigned int x2)
 { return x1 < x2 ? x1 : x2; }
 
 void draw_rect(volatile unsigned char *addr_base, unsigned short color,
@@ -0,0 +1,107 @@
+///////////////////////////////////////
+/// Bulk pixel buffer fills: single bytes
+/// and a word to an aligned head and from
+/// the tail, 16-byte stores in between
+/// for NEON on the A9 compile with
+/// -mfpu=neon
+///////////////////////////////////////
+#include <stdint.h>
+#include "vga_fill.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define VGA_FILL_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define VGA_FILL_SSE2 1
+#endif
+
+/****************************************************************************************
+ * One row of n bytes from p on. pat holds the bytes of an aligned 8-byte
+ * word, so the byte at address a is byte a & 7 of pat, whether it is
+ * stored alone or in a wide store
+****************************************************************************************/
+static void fill_row(volatile uint8_t *p, long n, uint64_t pat)
+{
+#if defined(VGA_FILL_NEON)
+	uint8x16_t v = vreinterpretq_u8_u64(vdupq_n_u64(pat));
+#elif defined(VGA_FILL_SSE2)
+	__m128i v = _mm_set1_epi64x((long long)pat);
+#endif
+	volatile uint8_t *end = p + n;
+
+	for (; p < end && ((uintptr_t)p & 7); p++)
+		*p = pat >> (((uintptr_t)p & 7) << 3);
+	if (end - p >= 8 && ((uintptr_t)p & 15)) {
+		*(volatile uint64_t *)p = pat;
+		p += 8;
+	}
+	for (; end - p >= 16; p += 16) {
+#if defined(VGA_FILL_NEON)
+		vst1q_u8((uint8_t *)p, v);
+#elif defined(VGA_FILL_SSE2)
+		_mm_store_si128((__m128i *)p, v);
+#else
+		((volatile uint64_t *)p)[0] = pat;
+		((volatile uint64_t *)p)[1] = pat;
+#endif
+	}
+	if (end - p >= 8) {
+		*(volatile uint64_t *)p = pat;
+		p += 8;
+	}
+	for (; p < end; p++)
+		*p = pat >> (((uintptr_t)p & 7) << 3);
+}
+
+void vga_fill(volatile void *fb, int pitch, int x, int y, int w, int h, uint8_t color)
+{
+	volatile uint8_t *row = (volatile uint8_t *)fb + (long)y * pitch + x;
+	uint64_t pat = color * 0x0101010101010101ULL;
+
+	if (w < 1) return;
+	for (; h > 0; h--, row += pitch) fill_row(row, w, pat);
+}
+
+void vga_fill16(volatile void *fb, int pitch, int x, int y, int w, int h, uint16_t color)
+{
+	volatile uint8_t *row = (volatile uint8_t *)fb + (long)y * pitch + 2L * x;
+	uint64_t pat;
+
+	if (w < 1) return;
+	// the low byte of a pixel goes to the even offsets from fb, which are
+	// the odd addresses when fb itself is odd
+	if ((uintptr_t)fb & 1) color = (uint16_t)(color << 8 | color >> 8);
+	pat = color * 0x0001000100010001ULL;
+	for (; h > 0; h--, row += pitch) fill_row(row, 2L * w, pat);
+}
+
+/****************************************************************************************
+ * Corners in any order, clipped to the screen
+****************************************************************************************/
+static int fill_clip(int width, int height, int *x1, int *y1, int *x2, int *y2)
+{
+	int t;
+
+	if (*x1 > *x2) { t = *x1; *x1 = *x2; *x2 = t; }
+	if (*y1 > *y2) { t = *y1; *y1 = *y2; *y2 = t; }
+	if (*x1 < 0) *x1 = 0;
+	if (*y1 < 0) *y1 = 0;
+	if (*x2 > width-1) *x2 = width-1;
+	if (*y2 > height-1) *y2 = height-1;
+	return *x1 <= *x2 && *y1 <= *y2;
+}
+
+void vga_fill_box(volatile void *fb, int pitch, int width, int height,
+		  int x1, int y1, int x2, int y2, uint8_t color)
+{
+	if (fill_clip(width, height, &x1, &y1, &x2, &y2))
+		vga_fill(fb, pitch, x1, y1, x2-x1+1, y2-y1+1, color);
+}
+
+void vga_fill_box16(volatile void *fb, int pitch, int width, int height,
+		    int x1, int y1, int x2, int y2, uint16_t color)
+{
+	if (fill_clip(width, height, &x1, &y1, &x2, &y2))
+		vga_fill16(fb, pitch, x1, y1, x2-x1+1, y2-y1+1, color);
+}
@@ -0,0 +1,29 @@
+/* Bulk fills of the VGA pixel buffer.
+ *
+ * The pixel buffer has 1024 bytes per row, of which a 640 pixel screen
+ * uses the first 640 (or 320 two-byte pixels); the rest of each row is
+ * never touched.  A fill stores single bytes up to the first 16-byte
+ * boundary of each row, then 16 bytes at a time (NEON or SSE2, else two
+ * 64-bit words) to the last boundary, then single bytes again, so any
+ * rectangle at any alignment costs about one store per 16 pixels instead
+ * of one per pixel.
+ */
+#ifndef VGA_FILL_H
+#define VGA_FILL_H
+
+#include <stdint.h>
+
+// w x h one-byte pixels from (x, y) on, pitch bytes per row. the
+// rectangle must lie in the buffer; nothing is done when w or h < 1
+void vga_fill(volatile void *fb, int pitch, int x, int y, int w, int h, uint8_t color);
+// the same with two-byte pixels, x and w counted in pixels
+void vga_fill16(volatile void *fb, int pitch, int x, int y, int w, int h, uint16_t color);
+
+// VGA_box() of the programs here: corners (x1, y1) and (x2, y2) included,
+// in either order, clipped to a width x height screen
+void vga_fill_box(volatile void *fb, int pitch, int width, int height,
+		  int x1, int y1, int x2, int y2, uint8_t color);
+void vga_fill_box16(volatile void *fb, int pitch, int width, int height,
+		    int x1, int y1, int x2, int y2, uint16_t color);
+
+#endif
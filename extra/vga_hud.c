@@ -0,0 +1,135 @@
+///////////////////////////////////////
+/// Text overlay: a shadow of the character
+/// buffer, only changed bytes stored, and
+/// numbers formatted without sprintf
+///////////////////////////////////////
+#include <string.h>
+#include "vga_hud.h"
+
+void vga_hud_init(vga_hud_t *h, volatile void *fb)
+{
+	memset(h->shadow, ' ', sizeof(h->shadow));
+	h->fb = (volatile uint8_t *)fb;
+	h->stores = h->kept = 0;
+	if (h->fb == NULL) return;
+	vga_hud_blank(h->fb);
+	h->stores = VGA_HUD_ROWS * VGA_HUD_PITCH;
+}
+
+/****************************************************************************************
+ * Compare with the shadow, store what differs. Two threads may write
+ * different rows at once, so the counts are added atomically, once a call
+****************************************************************************************/
+void vga_hud_pad(vga_hud_t *h, int x, int y, const char *s, int width)
+{
+	uint8_t *p, c;
+	long stored = 0, kept = 0;
+	int end = x + width;
+
+	if (y < 0 || y >= VGA_HUD_ROWS) return;
+	if (end > VGA_HUD_COLS) end = VGA_HUD_COLS;
+	p = h->shadow + y * VGA_HUD_PITCH;
+	for (; x < VGA_HUD_COLS && (*s || x < end); x++) {
+		c = *s ? (uint8_t)*s++ : ' ';
+		if (x < 0) continue;
+		if (p[x] == c) {
+			kept++;
+			continue;
+		}
+		p[x] = c;
+		if (h->fb) h->fb[y * VGA_HUD_PITCH + x] = c;
+		stored++;
+	}
+	__atomic_add_fetch(&h->stores, stored, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&h->kept, kept, __ATOMIC_RELAXED);
+}
+
+void vga_hud_text(vga_hud_t *h, int x, int y, const char *s)
+{
+	vga_hud_pad(h, x, y, s, 0);
+}
+
+void vga_hud_write(volatile void *fb, int x, int y, const char *s)
+{
+	volatile uint8_t *row = (volatile uint8_t *)fb + y * VGA_HUD_PITCH;
+
+	if (y < 0 || y >= VGA_HUD_ROWS) return;
+	for (; *s && x < VGA_HUD_COLS; x++, s++)
+		if (x >= 0) row[x] = *s;
+}
+
+void vga_hud_blank(volatile void *fb)
+{
+	int k;
+
+	for (k=0; k<VGA_HUD_ROWS * VGA_HUD_PITCH; k++) ((volatile uint8_t *)fb)[k] = ' ';
+}
+
+/****************************************************************************************
+ * Line building
+****************************************************************************************/
+void vga_hud_start(vga_hud_line_t *l)
+{
+	l->len = 0;
+	l->text[0] = 0;
+}
+
+void vga_hud_add(vga_hud_line_t *l, const char *s)
+{
+	while (*s && l->len < VGA_HUD_COLS) l->text[l->len++] = *s++;
+	l->text[l->len] = 0;
+}
+
+// v in decimal, ending just before end: its first digit, *n of them
+static char *hud_digits(char *end, uint64_t v, int *n)
+{
+	char *p = end;
+
+	do {
+		*--p = '0' + v % 10;
+		v /= 10;
+	} while (v);
+	*n = end - p;
+	return p;
+}
+
+void vga_hud_add_u(vga_hud_line_t *l, uint64_t v, int width)
+{
+	char buf[24], *p;
+	int n;
+
+	p = hud_digits(buf + sizeof(buf) - 1, v, &n);
+	buf[sizeof(buf) - 1] = 0;
+	for (; n < width && l->len < VGA_HUD_COLS; n++) l->text[l->len++] = ' ';
+	l->text[l->len] = 0;
+	vga_hud_add(l, p);
+}
+
+void vga_hud_add_fix(vga_hud_line_t *l, double v, int width, int decimals)
+{
+	char buf[48], *p = buf + sizeof(buf) - 1;
+	uint64_t scale = 1, n;
+	int k, d, neg = v < 0;
+
+	if (decimals > 9) decimals = 9;
+	if (v != v) v = 0;
+	for (k=0; k<decimals; k++) scale *= 10;
+	if (neg) v = -v;
+	// past 2^63 the digits would be noise anyway
+	if (v * scale > 9.2e18) v = 9.2e18 / scale;
+	n = (uint64_t)(v * scale + 0.5);
+	// no -0.00
+	neg &= n != 0;
+	*p = 0;
+	for (k=0; k<decimals; k++) {
+		*--p = '0' + n % 10;
+		n /= 10;
+	}
+	if (decimals > 0) *--p = '.';
+	p = hud_digits(p, n, &d);
+	if (neg) *--p = '-';
+	for (d = buf + sizeof(buf) - 1 - p; d < width && l->len < VGA_HUD_COLS; d++)
+		l->text[l->len++] = ' ';
+	l->text[l->len] = 0;
+	vga_hud_add(l, p);
+}
@@ -0,0 +1,56 @@
+/* Text overlay through a shadow of the VGA character buffer.
+ *
+ * The character buffer holds 128 bytes per row, of which the 80 x 60
+ * screen shows the first 80 of the first 60 rows.  It sits across the
+ * bridge, uncached, so every byte stored costs a bus transaction.  The
+ * HUD keeps what it last wrote in ordinary memory and stores only the
+ * bytes that come out different: a status line that is rewritten every
+ * frame costs the few digits that moved, not the whole line.
+ *
+ * Lines are put together in a vga_hud_line_t with the vga_hud_add*()
+ * functions, which format numbers by hand into a fixed buffer: no
+ * sprintf(), no allocation.
+ */
+#ifndef VGA_HUD_H
+#define VGA_HUD_H
+
+#include <stdint.h>
+
+#define VGA_HUD_PITCH 128       // bytes per row of the character buffer
+#define VGA_HUD_COLS  80        // shown
+#define VGA_HUD_ROWS  60
+
+typedef struct vga_hud {
+	volatile uint8_t *fb;   // character buffer, NULL: the shadow only
+	uint8_t shadow[VGA_HUD_ROWS * VGA_HUD_PITCH];
+	long stores;            // bytes stored to fb
+	long kept;              // bytes that were there already
+} vga_hud_t;
+
+// blanks the whole screen, the only time every byte is stored
+void vga_hud_init(vga_hud_t *h, volatile void *fb);
+
+// s at column x of row y, clipped to the screen
+void vga_hud_text(vga_hud_t *h, int x, int y, const char *s);
+// the same, then spaces up to width columns, over whatever was longer
+void vga_hud_pad(vga_hud_t *h, int x, int y, const char *s, int width);
+
+// without a shadow, for programs that write their text once: s at column
+// x of row y, clipped, and the whole screen blank
+void vga_hud_write(volatile void *fb, int x, int y, const char *s);
+void vga_hud_blank(volatile void *fb);
+
+typedef struct vga_hud_line {
+	char text[VGA_HUD_COLS + 1];    // always terminated
+	int len;
+} vga_hud_line_t;
+
+// what does not fit in VGA_HUD_COLS is cut off
+void vga_hud_start(vga_hud_line_t *l);
+void vga_hud_add(vga_hud_line_t *l, const char *s);
+// v in decimal, right aligned in width columns (0: as wide as it is)
+void vga_hud_add_u(vga_hud_line_t *l, uint64_t v, int width);
+// v rounded to decimals places, right aligned in width columns
+void vga_hud_add_fix(vga_hud_line_t *l, double v, int width, int decimals);
+
+#endif
@@ -0,0 +1,393 @@
+///////////////////////////////////////
+/// Clipped boxes, lines and discs, drawn
+/// at once or batched by scanline
+///////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "vga_fill.h"
+#include "vga_raster.h"
+
+int vga_raster_init(vga_raster_t *r, volatile void *fb, int pitch, int width, int height,
+		    int bpp)
+{
+	memset(r, 0, sizeof(*r));
+	if ((bpp != 1 && bpp != 2) || width < 1 || height < 1 || pitch < width * bpp) return -1;
+	r->fb = (volatile uint8_t *)fb;
+	r->pitch = pitch;
+	r->width = width;
+	r->height = height;
+	r->bpp = bpp;
+	vga_raster_clip(r, 0, 0, width-1, height-1);
+	return 0;
+}
+
+void vga_raster_clip(vga_raster_t *r, int x1, int y1, int x2, int y2)
+{
+	int t;
+
+	if (x1 > x2) { t = x1; x1 = x2; x2 = t; }
+	if (y1 > y2) { t = y1; y1 = y2; y2 = t; }
+	r->cx1 = x1 < 0 ? 0 : x1;
+	r->cy1 = y1 < 0 ? 0 : y1;
+	r->cx2 = x2 > r->width-1 ? r->width-1 : x2;
+	r->cy2 = y2 > r->height-1 ? r->height-1 : y2;
+}
+
+// columns x1..x2 of row y, already clipped
+static inline void raster_span(vga_raster_t *r, int x1, int x2, int y, int h, uint16_t color)
+{
+	if (r->bpp == 1) vga_fill(r->fb, r->pitch, x1, y, x2-x1+1, h, color);
+	else vga_fill16(r->fb, r->pitch, x1, y, x2-x1+1, h, color);
+}
+
+/****************************************************************************************
+ * Box: corners sorted and clipped, then every row at once
+****************************************************************************************/
+void vga_raster_box(vga_raster_t *r, int x1, int y1, int x2, int y2, uint16_t color)
+{
+	int t;
+
+	if (x1 > x2) { t = x1; x1 = x2; x2 = t; }
+	if (y1 > y2) { t = y1; y1 = y2; y2 = t; }
+	if (x1 < r->cx1) x1 = r->cx1;
+	if (y1 < r->cy1) y1 = r->cy1;
+	if (x2 > r->cx2) x2 = r->cx2;
+	if (y2 > r->cy2) y2 = r->cy2;
+	if (x1 <= x2 && y1 <= y2) raster_span(r, x1, x2, y1, y2-y1+1, color);
+}
+
+/****************************************************************************************
+ * Line: Bresenham as the old VGA_line() stepped it, along the major axis
+ * a, the minor axis b moving by one whenever the error term e comes out
+ * >= 0. After j steps b has moved m(j) = floor((2 j db + da - bias) / (2 da))
+ * and e = 2 (j+1) db - da - bias - 2 da m(j), so the steps that land inside
+ * the clip rectangle are a range j0..j1 that can be worked out beforehand,
+ * and the walk can start at j0 as if it had come from the end. bias is 0
+ * for the old walk; walked from the other end with bias 1, ties go the
+ * other way and the line sets the same pixels
+****************************************************************************************/
+// the walk from (x1, y1) to (x2, y2) inside the clip; 0 when nothing is
+static int raster_line_setup(vga_raster_t *r, int x1, int y1, int x2, int y2, int bias,
+			     vga_raster_walk_t *w)
+{
+	int64_t da, db, j0, j1, lo, hi, m;
+	int a, b, sa, sb, amin, amax, bmin, bmax, xchange;
+
+	// products of the clip bounds and the lengths must fit int64_t
+	if (x1 < -(1 << 24) || x1 > (1 << 24) || y1 < -(1 << 24) || y1 > (1 << 24) ||
+	    x2 < -(1 << 24) || x2 > (1 << 24) || y2 < -(1 << 24) || y2 > (1 << 24))
+		return 0;
+	da = (int64_t)x2 - x1;
+	db = (int64_t)y2 - y1;
+	xchange = llabs(db) > llabs(da);
+	if (xchange) {
+		da = (int64_t)y2 - y1;
+		db = (int64_t)x2 - x1;
+		a = y1; b = x1;
+		amin = r->cy1; amax = r->cy2;
+		bmin = r->cx1; bmax = r->cx2;
+	}
+	else {
+		a = x1; b = y1;
+		amin = r->cx1; amax = r->cx2;
+		bmin = r->cy1; bmax = r->cy2;
+	}
+	sa = da > 0 ? 1 : da < 0 ? -1 : 0;
+	sb = db > 0 ? 1 : db < 0 ? -1 : 0;
+	da = llabs(da);
+	db = llabs(db);
+
+	// the steps whose a is inside
+	lo = sa >= 0 ? (int64_t)amin - a : (int64_t)a - amax;
+	hi = sa >= 0 ? (int64_t)amax - a : (int64_t)a - amin;
+	j0 = lo > 0 ? lo : 0;
+	j1 = hi < da ? hi : da;
+	// and whose b is: step m along b is taken at the first j with
+	// 2 j db + da - bias >= 2 da m
+	if (db == 0) {
+		if (b < bmin || b > bmax) return 0;
+	}
+	else {
+		lo = sb > 0 ? (int64_t)bmin - b : (int64_t)b - bmax;
+		hi = sb > 0 ? (int64_t)bmax - b : (int64_t)b - bmin;
+		if (hi < 0 || lo > db) return 0;
+		if (lo > 0 && (2*da*lo - da + bias + 2*db - 1) / (2*db) > j0)
+			j0 = (2*da*lo - da + bias + 2*db - 1) / (2*db);
+		if (hi < db && (2*da*(hi+1) - da + bias + 2*db - 1) / (2*db) - 1 < j1)
+			j1 = (2*da*(hi+1) - da + bias + 2*db - 1) / (2*db) - 1;
+	}
+	if (j0 > j1) return 0;
+
+	m = da ? (2*j0*db + da - bias) / (2*da) : 0;
+	w->j = j0;
+	w->j1 = j1;
+	w->e = 2*(j0+1)*db - da - bias - 2*da*m;
+	w->da = da;
+	w->db = db;
+	w->bias = bias;
+	w->ymajor = xchange;
+	a += sa * j0;
+	b += sb * m;
+	w->y = xchange ? a : b;
+	// from here on a pointer, stepped by the bytes one move along each axis is
+	w->at = xchange ? (long)a * r->pitch + (long)b * r->bpp : (long)b * r->pitch + (long)a * r->bpp;
+	w->stepa = xchange ? (long)sa * r->pitch : (long)sa * r->bpp;
+	w->stepb = xchange ? (long)sb * r->bpp : (long)sb * r->pitch;
+	return 1;
+}
+
+// n steps from *row, or fewer if the minor axis would move more than
+// moves times: the steps not taken
+static inline int64_t raster_line_steps(volatile uint8_t **row, int64_t *e, int64_t n,
+					int64_t moves, long stepa, long stepb, int64_t da2,
+					int64_t db2, uint16_t color, int bpp)
+{
+	volatile uint8_t *p = *row;
+	int64_t err = *e;
+
+	for (; n > 0; n--) {
+		if (bpp == 1) *p = color;
+		else *(volatile uint16_t *)p = color;
+		if (err >= 0) {
+			if (moves-- == 0) {
+				p += stepa + stepb;
+				err += db2 - da2;
+				n--;
+				break;
+			}
+			p += stepb;
+			err -= da2;
+		}
+		p += stepa;
+		err += db2;
+	}
+	*row = p;
+	*e = err;
+	return n;
+}
+
+// the steps left of a walk down the screen on rows up to ymax, or of
+// any walk, all of them, with ymax -1
+static void raster_line_walk(vga_raster_t *r, vga_raster_walk_t *w, int ymax, uint16_t color)
+{
+	volatile uint8_t *row = r->fb + w->at;
+	int64_t n = w->j1 - w->j + 1, moves = n, left;
+
+	if (ymax >= 0) {
+		if (ymax < w->y) return;
+		// rows are the major axis, one a step, or the minor, one a move
+		if (!w->ymajor) moves = ymax - w->y;
+		else if (ymax - w->y + 1 < n) n = ymax - w->y + 1;
+	}
+	if (r->bpp == 1)
+		left = raster_line_steps(&row, &w->e, n, moves, w->stepa, w->stepb, 2*w->da,
+					 2*w->db, color, 1);
+	else
+		left = raster_line_steps(&row, &w->e, n, moves, w->stepa, w->stepb, 2*w->da,
+					 2*w->db, color, 2);
+	w->j += n - left;
+	// a minor walk stopped short goes on from the row below the band
+	w->y = w->ymajor ? w->y + n - left : ymax + 1;
+	w->at = row - r->fb;
+}
+
+void vga_raster_line(vga_raster_t *r, int x1, int y1, int x2, int y2, uint16_t color)
+{
+	vga_raster_walk_t w;
+
+	if (raster_line_setup(r, x1, y1, x2, y2, 0, &w)) raster_line_walk(r, &w, -1, color);
+}
+
+/****************************************************************************************
+ * Disc: the rows it crosses inside the clip, each one span. The half
+ * width is the integer square root of rad^2 + rad - dy^2, found once and
+ * then walked from row to row
+****************************************************************************************/
+static int64_t raster_isqrt(int64_t v)
+{
+	int64_t x, y;
+
+	if (v <= 0) return 0;
+	x = v;
+	y = (x + 1) / 2;
+	while (y < x) {
+		x = y;
+		y = (x + v / x) / 2;
+	}
+	return x;
+}
+
+// rows lo..hi of the disc at (x, y), *h the half width of the row above
+// lo or of lo itself, columns cx1..cx2
+static void raster_disc_rows(vga_raster_t *r, int x, int y, int64_t rr, int64_t *h, int cx1,
+			     int cx2, int64_t lo, int64_t hi, uint16_t color)
+{
+	int64_t rem, dy, left, right, w = *h;
+
+	for (dy=lo-y; dy<=hi-y; dy++) {
+		rem = rr - dy * dy;
+		while ((w+1) * (w+1) <= rem) w++;
+		while (w > 0 && w * w > rem) w--;
+		left = x - w > cx1 ? x - w : cx1;
+		right = x + w < cx2 ? x + w : cx2;
+		if (left <= right) raster_span(r, left, right, y + dy, 1, color);
+	}
+	*h = w;
+}
+
+void vga_raster_disc(vga_raster_t *r, int x, int y, int rad, uint16_t color)
+{
+	int64_t rr, h, top, bottom;
+
+	if (rad < 0) return;
+	rr = (int64_t)rad * rad + rad;
+	top = (int64_t)r->cy1 - y > -rad ? (int64_t)r->cy1 - y : -rad;
+	bottom = (int64_t)r->cy2 - y < rad ? (int64_t)r->cy2 - y : rad;
+	if (top > bottom) return;
+	h = raster_isqrt(rr - top * top);
+	raster_disc_rows(r, x, y, rr, &h, r->cx1, r->cx2, y + top, y + bottom, color);
+}
+
+/****************************************************************************************
+ * Command lists
+****************************************************************************************/
+int vga_raster_list_init(vga_raster_list_t *l, vga_raster_t *r, int size, int band)
+{
+	memset(l, 0, sizeof(*l));
+	if (size < 1 || band < 0) return -1;
+	l->r = r;
+	l->size = size;
+	if (band == 0 || band > r->height) band = r->height;
+	while ((1 << l->shift) < band) l->shift++;
+	l->cmd = calloc(size, sizeof(vga_raster_cmd_t));
+	l->order = calloc(size, sizeof(int));
+	l->active = calloc(size, sizeof(int));
+	l->rows = calloc(r->height + 1, sizeof(int));
+	if (l->cmd == NULL || l->order == NULL || l->active == NULL || l->rows == NULL) {
+		vga_raster_list_free(l);
+		return -1;
+	}
+	return 0;
+}
+
+void vga_raster_list_free(vga_raster_list_t *l)
+{
+	free(l->cmd);
+	free(l->order);
+	free(l->active);
+	free(l->rows);
+	memset(l, 0, sizeof(*l));
+}
+
+// a command on rows top..bottom, cut to the clip; NULL when none are left
+static vga_raster_cmd_t *raster_add(vga_raster_list_t *l, int op, uint16_t color, int64_t top,
+				    int64_t bottom)
+{
+	vga_raster_cmd_t *c;
+
+	if (top < l->r->cy1) top = l->r->cy1;
+	if (bottom > l->r->cy2) bottom = l->r->cy2;
+	if (top > bottom) return NULL;
+	if (l->n == l->size) vga_raster_flush(l);
+	c = &l->cmd[l->n++];
+	c->op = op;
+	c->color = color;
+	c->top = top;
+	c->bottom = bottom;
+	return c;
+}
+
+void vga_raster_add_box(vga_raster_list_t *l, int x1, int y1, int x2, int y2, uint16_t color)
+{
+	vga_raster_cmd_t *c;
+	int t;
+
+	if (x1 > x2) { t = x1; x1 = x2; x2 = t; }
+	if (y1 > y2) { t = y1; y1 = y2; y2 = t; }
+	if (x1 < l->r->cx1) x1 = l->r->cx1;
+	if (x2 > l->r->cx2) x2 = l->r->cx2;
+	if (x1 > x2 || (c = raster_add(l, VGA_RASTER_BOX, color, y1, y2)) == NULL) return;
+	c->x1 = x1;
+	c->x2 = x2;
+}
+
+// walked down the screen, so each band carries on from the one above
+void vga_raster_add_line(vga_raster_list_t *l, int x1, int y1, int x2, int y2, uint16_t color)
+{
+	vga_raster_walk_t w;
+	vga_raster_cmd_t *c;
+	int64_t top, bottom;
+	int up = y2 < y1;
+
+	if (!(up ? raster_line_setup(l->r, x2, y2, x1, y1, 1, &w) :
+		   raster_line_setup(l->r, x1, y1, x2, y2, 0, &w)))
+		return;
+	// the row of the last step: the first's, and a move per step or per
+	// rise of the error term
+	top = w.y;
+	bottom = w.ymajor ? w.y + w.j1 - w.j :
+		 w.y + (w.da ? (2*(w.j1 - w.j)*w.db + w.e + 2*w.da - 2*w.db) / (2*w.da) : 0);
+	if ((c = raster_add(l, VGA_RASTER_LINE, color, top, bottom)) != NULL) c->walk = w;
+}
+
+void vga_raster_add_disc(vga_raster_list_t *l, int x, int y, int rad, uint16_t color)
+{
+	vga_raster_cmd_t *c;
+
+	if (rad < 0 || (c = raster_add(l, VGA_RASTER_DISC, color, (int64_t)y - rad,
+				       (int64_t)y + rad)) == NULL)
+		return;
+	c->x = x;
+	c->y = y;
+	c->x1 = l->r->cx1;
+	c->x2 = l->r->cx2;
+	c->rr = (int64_t)rad * rad + rad;
+	c->h = raster_isqrt(c->rr - ((int64_t)c->top - y) * ((int64_t)c->top - y));
+}
+
+/****************************************************************************************
+ * Flush: the commands sorted by the band their top row is in, keeping
+ * the order they were added in, then band after band. the ones starting
+ * in a band are merged into the active ones, still in that order, and a
+ * command leaves after the band it ends in; so where two overlap the
+ * later one wins, as drawn one by one
+****************************************************************************************/
+void vga_raster_flush(vga_raster_list_t *l)
+{
+	vga_raster_t *r = l->r;
+	vga_raster_cmd_t *c;
+	int bands = ((r->height - 1) >> l->shift) + 1;
+	int k, i, m, b, y0, y1, lo, hi, next = 0, na = 0;
+
+	if (l->n == 0) return;
+	memset(l->rows, 0, (bands + 1) * sizeof(int));
+	for (k=0; k<l->n; k++) l->rows[(l->cmd[k].top >> l->shift) + 1]++;
+	for (b=0; b<bands; b++) l->rows[b+1] += l->rows[b];
+	for (k=0; k<l->n; k++) l->order[l->rows[l->cmd[k].top >> l->shift]++] = k;
+
+	while (next < l->n || na > 0) {
+		// a gap with nothing in it: on to the next command's band
+		if (na == 0) b = l->cmd[l->order[next]].top >> l->shift;
+		y0 = b << l->shift;
+		y1 = y0 + (1 << l->shift) - 1;
+		// the ones starting here, merged in from the back
+		for (m=next; m<l->n && l->cmd[l->order[m]].top <= y1; m++);
+		for (i=na+m-next-1, k=na-1, na=i+1; i>k; i--)
+			l->active[i] = k >= 0 && l->active[k] > l->order[m-1] ? l->active[k--] :
+									 l->order[--m];
+		next = l->rows[b];
+		for (k=i=0; k<na; k++) {
+			c = &l->cmd[l->active[k]];
+			lo = c->top > y0 ? c->top : y0;
+			hi = c->bottom < y1 ? c->bottom : y1;
+			if (c->op == VGA_RASTER_BOX) raster_span(r, c->x1, c->x2, lo, hi - lo + 1, c->color);
+			else if (c->op == VGA_RASTER_LINE) raster_line_walk(r, &c->walk, hi, c->color);
+			else raster_disc_rows(r, c->x, c->y, c->rr, &c->h, c->x1, c->x2, lo, hi, c->color);
+			if (c->bottom > y1) l->active[i++] = l->active[k];
+		}
+		na = i;
+		b++;
+	}
+	l->drawn += l->n;
+	l->n = 0;
+}
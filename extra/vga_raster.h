@@ -0,0 +1,107 @@
+/* Boxes, lines and discs in the VGA pixel buffer, clipped.
+ *
+ * One copy of what every program here used to carry its own VGA_box(),
+ * VGA_line() and VGA_disc() for.  Each primitive is clipped once, before
+ * its first pixel, to the raster's clip rectangle (the screen unless
+ * narrowed): a box to the rows and columns left, a disc to the rows it
+ * crosses and each row's span to the columns, a line to the range of
+ * Bresenham steps that fall inside, entered with the error term it would
+ * have had there.  So nothing off the screen is drawn, or smeared onto
+ * the edge, and the pixels on it are the ones the unclipped primitive
+ * would have set.  Boxes and disc rows are filled with vga_fill()'s wide
+ * stores.
+ *
+ * A vga_raster_list_t batches commands and draws them a band of
+ * scanlines at a time, top to bottom, each band with every command that
+ * crosses it in the order they were added: the same picture, with the
+ * stores sorted by scanline.  A command is clipped to the clip rectangle
+ * and set up once, when it is added, and each band only carries on
+ * drawing it: a box's rows, a disc's rows with its half width walked on
+ * from the last band, a line's Bresenham walk resumed where the band
+ * before left it.  A line going up the screen is queued from its lower
+ * end, with its ties broken the other way, which sets the same pixels.
+ *
+ * Each band a command crosses is another call, and nothing on these
+ * targets pays that back: the DE1's pixel buffer is not cached, and the
+ * simulated one fits in the cache whole.  raster_bench measured 16-row
+ * bands at 0.6 of the direct rate for lines and 0.65 for small boxes, so
+ * by default a list has one band, the whole screen, and costs only the
+ * queueing (0.9 to 1.0 of the direct rate); narrower bands are there for
+ * a target whose pixel buffer is cached and bigger than the cache.
+ */
+#ifndef VGA_RASTER_H
+#define VGA_RASTER_H
+
+#include <stdint.h>
+
+typedef struct vga_raster {
+	volatile uint8_t *fb;   // pixel buffer, pitch bytes per row
+	int pitch;
+	int width, height;      // pixels
+	int bpp;                // bytes per pixel, 1 or 2
+	int cx1, cy1, cx2, cy2; // clip rectangle, corners included
+} vga_raster_t;
+
+// bpp 1 (8-bit colour, 640x480) or 2 (16-bit, 320x240); -1 otherwise
+int  vga_raster_init(vga_raster_t *r, volatile void *fb, int pitch, int width, int height,
+		     int bpp);
+// the clip rectangle, within the screen; corners in any order
+void vga_raster_clip(vga_raster_t *r, int x1, int y1, int x2, int y2);
+
+// corners included, in any order
+void vga_raster_box(vga_raster_t *r, int x1, int y1, int x2, int y2, uint16_t color);
+// both ends included; ends more than 2^24 from the origin draw nothing
+void vga_raster_line(vga_raster_t *r, int x1, int y1, int x2, int y2, uint16_t color);
+// every pixel with dx*dx + dy*dy <= rad*rad + rad from the centre
+void vga_raster_disc(vga_raster_t *r, int x, int y, int rad, uint16_t color);
+
+#define VGA_RASTER_BOX  1
+#define VGA_RASTER_LINE 2
+#define VGA_RASTER_DISC 3
+
+// a line's walk: its steps j..j1 are the ones left inside the clip
+typedef struct vga_raster_walk {
+	int64_t j, j1;          // next step, last step
+	int64_t e, da, db;      // error term; lengths along the major and minor axes
+	int64_t y;              // row of step j, for a walk down the screen
+	long at, stepa, stepb;  // byte offset of step j; one move along each axis
+	int bias;               // 1: ties go the other way, for a line walked backwards
+	int ymajor;             // the major axis is the rows
+} vga_raster_walk_t;
+
+typedef struct vga_raster_cmd {
+	int op;                 // VGA_RASTER_*
+	uint16_t color;
+	int top, bottom;        // rows it touches, clipped
+	int x1, x2;             // box and disc: columns, clipped
+	int x, y;               // disc: the centre
+	int64_t rr, h;          // disc: rad^2 + rad, half width of the row last drawn
+	vga_raster_walk_t walk; // line
+} vga_raster_cmd_t;
+
+typedef struct vga_raster_list {
+	vga_raster_t *r;
+	vga_raster_cmd_t *cmd;
+	int n, size;
+	int *order;             // by band, then as added
+	int *active;            // crossing the band being drawn, as added
+	int *rows;              // counting sort by band
+	int shift;              // bands of 1 << shift rows
+	long drawn;             // commands flushed
+} vga_raster_list_t;
+
+// size commands; bands of band rows, rounded up to a power of two, or
+// band == 0 for one band covering the screen
+int  vga_raster_list_init(vga_raster_list_t *l, vga_raster_t *r, int size, int band);
+void vga_raster_list_free(vga_raster_list_t *l);
+
+// queued, clipped to the clip rectangle now; a full list is flushed
+// first. nothing is queued for a command wholly outside the clip
+void vga_raster_add_box(vga_raster_list_t *l, int x1, int y1, int x2, int y2, uint16_t color);
+void vga_raster_add_line(vga_raster_list_t *l, int x1, int y1, int x2, int y2, uint16_t color);
+void vga_raster_add_disc(vga_raster_list_t *l, int x, int y, int rad, uint16_t color);
+
+// draw everything queued, band by band, and empty the list
+void vga_raster_flush(vga_raster_list_t *l);
+
+#endif
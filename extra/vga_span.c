@@ -0,0 +1,118 @@
+///////////////////////////////////////
+/// Dirty-span writer: shadow screen,
+/// changed pixels flushed as aligned
+/// 32- or 64-bit stores, a scanline at a time
+///////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "vga_span.h"
+
+int vga_span_init(vga_span_t *s, volatile void *fb, int pitch, int width, int height,
+		  int word_bytes)
+{
+	memset(s, 0, sizeof(*s));
+	if (word_bytes != 4 && word_bytes != 8) return -1;
+	if ((width | pitch) & (word_bytes-1) || width < 1 || height < 1 || pitch < width)
+		return -1;
+
+	s->fb = (volatile uint8_t *)fb;
+	s->pitch = pitch;
+	s->width = width;
+	s->height = height;
+	s->shift = word_bytes == 8 ? 3 : 2;
+	s->words = width >> s->shift;
+	s->masks = (s->words + 63) >> 6;
+	s->shadow = calloc((size_t)width * height, 1);
+	s->dirty = calloc((size_t)s->masks * height, sizeof(uint64_t));
+	s->row_dirty = calloc(height, 1);
+	if (s->shadow == NULL || s->dirty == NULL || s->row_dirty == NULL) {
+		vga_span_free(s);
+		return -1;
+	}
+	return 0;
+}
+
+void vga_span_free(vga_span_t *s)
+{
+	free(s->shadow);
+	free(s->dirty);
+	free(s->row_dirty);
+	memset(s, 0, sizeof(*s));
+}
+
+/****************************************************************************************
+ * Copy a run of pixels into the shadow, one screen word at a time
+ * only the words that come out different are flagged
+****************************************************************************************/
+void vga_span_row(vga_span_t *s, int x, int y, const uint8_t *src, int n)
+{
+	uint8_t *p = s->shadow + (long)y * s->width;
+	uint64_t *dirty = s->dirty + (long)y * s->masks;
+	int w, end, k, diff;
+
+	while (n > 0) {
+		w = x >> s->shift;
+		end = (w + 1) << s->shift;
+		if (end > x + n) end = x + n;
+		for (k=x, diff=0; k<end; k++) diff += p[k] != src[k-x];
+		if (diff) {
+			memcpy(p + x, src, end - x);
+			dirty[w >> 6] |= 1ULL << (w & 63);
+			s->row_dirty[y] = 1;
+			s->acc.pixels += diff;
+		}
+		src += end - x;
+		n -= end - x;
+		x = end;
+	}
+}
+
+/****************************************************************************************
+ * Store the flagged words of every flagged row
+ * a pixel put back to its old colour still flags its word; that costs a
+ * redundant store at worst, never a wrong one
+****************************************************************************************/
+long vga_span_flush(vga_span_t *s)
+{
+	int y, m, w, end;
+	uint64_t bits, run, v64;
+	const uint8_t *src;
+	uint32_t v32;
+	volatile uint8_t *dst;
+
+	for (y=0; y<s->height; y++) {
+		if (!s->row_dirty[y]) continue;
+		s->row_dirty[y] = 0;
+		src = s->shadow + (long)y * s->width;
+		dst = s->fb + (long)y * s->pitch;
+		for (m=0; m<s->masks; m++) {
+			bits = s->dirty[(long)y * s->masks + m];
+			s->dirty[(long)y * s->masks + m] = 0;
+			while (bits) {
+				// one run of adjacent flagged words
+				w = __builtin_ctzll(bits);
+				run = ~(bits >> w);
+				end = run ? w + __builtin_ctzll(run) : 64;
+				bits = end < 64 ? bits & (~0ULL << end) : 0;
+				s->acc.spans++;
+				s->acc.writes += end - w;
+				if (s->shift == 3) {
+					for (; w<end; w++) {
+						memcpy(&v64, src + (((m << 6) + w) << 3), 8);
+						((volatile uint64_t *)dst)[(m << 6) + w] = v64;
+					}
+				}
+				else {
+					for (; w<end; w++) {
+						memcpy(&v32, src + (((m << 6) + w) << 2), 4);
+						((volatile uint32_t *)dst)[(m << 6) + w] = v32;
+					}
+				}
+			}
+		}
+	}
+	s->acc.bytes = s->acc.writes << s->shift;
+	s->frame = s->acc;
+	memset(&s->acc, 0, sizeof(s->acc));
+	return s->frame.writes;
+}
@@ -0,0 +1,63 @@
+/* Dirty-span writer for the VGA pixel buffer.
+ *
+ * Pixels are drawn into a shadow copy of the screen in ordinary memory;
+ * every word (4 or 8 pixels) that ends up different from what the screen holds is
+ * flagged.  vga_span_flush() then walks each scanline's flagged words in
+ * runs and stores them into the pixel buffer as aligned 32-bit (or 64-bit)
+ * words, so a frame costs one bridge transaction per changed word instead of
+ * one per changed pixel.
+ *
+ * The shadow starts all zero, i.e. it assumes the screen was just cleared
+ * to black.
+ */
+#ifndef VGA_SPAN_H
+#define VGA_SPAN_H
+
+#include <stdint.h>
+
+typedef struct vga_span_stats {
+	long pixels;            // pixels changed, one store each the old way
+	long writes;            // word stores to the pixel buffer
+	long bytes;             // bytes stored
+	long spans;             // runs of adjacent words
+} vga_span_stats_t;
+
+typedef struct vga_span {
+	volatile uint8_t *fb;   // pixel buffer, pitch bytes per row
+	int pitch;
+	int width, height;      // pixels, width a multiple of the word
+	int shift;              // log2 of the word size, 2 or 3
+	int words;              // words per row
+	int masks;              // uint64_t dirty masks per row
+	uint8_t *shadow;        // width bytes per row
+	uint64_t *dirty;        // bit w of row y: word w differs from the screen
+	uint8_t *row_dirty;     // any bit of the row set
+	vga_span_stats_t acc;   // since the last flush
+	vga_span_stats_t frame; // what the last flush wrote
+} vga_span_t;
+
+// word_bytes is the store width, 4 or 8
+int  vga_span_init(vga_span_t *s, volatile void *fb, int pitch, int width, int height,
+		   int word_bytes);
+void vga_span_free(vga_span_t *s);
+
+static inline void vga_span_put(vga_span_t *s, int x, int y, uint8_t color)
+{
+	uint8_t *p = s->shadow + (long)y * s->width + x;
+
+	if (*p == color) return;
+	*p = color;
+	x >>= s->shift;
+	s->dirty[(long)y * s->masks + (x >> 6)] |= 1ULL << (x & 63);
+	s->row_dirty[y] = 1;
+	s->acc.pixels++;
+}
+
+// n pixels from src at (x, y) on, compared with the shadow a word at a
+// time: the fast way to draw whole rows
+void vga_span_row(vga_span_t *s, int x, int y, const uint8_t *src, int n);
+
+// write every flagged word, return the number of stores
+long vga_span_flush(vga_span_t *s);
+
+#endif
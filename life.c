@@ -3,6 +3,10 @@
  * Rules can be found here:
  * http://mathworld.wolfram.com/GameofLife.html
  * 
+ * gcc life.c vga_dev.c mouse_dev.c extra/life_pattern.c extra/life_rule.c -Iextra -o life
+ *
+ * Off the board: DE1_SIM="" DE1_MOUSE=/tmp/mice ./life, with /tmp/mice a
+ * FIFO of mouse packets (see mouse_dev.h)
  */
 
 #include <stdio.h>
@@ -11,6 +15,9 @@
 #include <sys/mman.h>
 #include <sys/shm.h>
 #include "address_map_arm_brl4.h"
+#include "vga_dev.h"
+#include "mouse_dev.h"
+#include "life_pattern.h"
 
 #define PIXEL_COLS  (unsigned int)640
 #define PIXEL_ROWS  (unsigned int)480
@@ -31,51 +38,25 @@ void draw_pi(unsigned char *,
 void draw_gun(unsigned char *,
 	      volatile unsigned char *, unsigned int, unsigned int);
 
-inline unsigned int index(unsigned int, unsigned int);
+static inline unsigned int index(unsigned int, unsigned int);
+
+int clamp(int, int);
 
 
 int main()
 {
-    // Create a file descriptor for "/dev/mem"
-    int fd_mem;
-    if ((fd_mem = open("/dev/mem", (O_RDWR|O_SYNC))) == -1) {
-        printf("Error: failed to open \"/dev/mem\".\n");
-        close(fd_mem);
-        return 1;
-    }
+    // Map the pixel buffer and the FPGA switches: /dev/mem, or plain
+    // memory when DE1_SIM is set (see vga_dev.h)
+    vga_dev_t dev;
+    if (vga_dev_open(&dev, NULL) != 0) return 1;
 
-    // Create a non-blocking file descriptor for "/dev/input/mice"
-    int fd_mouse;
-    if ((fd_mouse = open("/dev/input/mice", (O_RDWR|O_SYNC))) == -1) {
-        printf("Error: failed to open \"/dev/input/mice\".\n");
-        close(fd_mouse);
-        return 1;
-    }
-    int flags = fcntl(fd_mouse, F_GETFL, 0);
-    fcntl(fd_mouse, F_SETFL, flags | O_NONBLOCK);
-
-    // Map the pixel buffer to a virtual address
-    void *pixel_buffer_addr;
-    if ((pixel_buffer_addr = mmap(NULL, FPGA_ONCHIP_SPAN,
-                                  (PROT_READ|PROT_WRITE),
-                                  MAP_SHARED, fd_mem, FPGA_ONCHIP_BASE))
-            == MAP_FAILED)
-    {
-        printf("Error: failed to map the pixel buffer.\n");
-        close(fd_mem);
-        return 1;
-    }
+    // The mouse, "/dev/input/mice" or $DE1_MOUSE, waited on rather
+    // than polled
+    mouse_dev_t mouse;
+    if (mouse_dev_open(&mouse, NULL, 0) != 0) return 1;
 
-    // Map the FPGA switches
-    void *switch_addr;
-    if ((switch_addr = mmap(NULL, HW_REGS_SPAN, (PROT_READ|PROT_WRITE),
-                            MAP_SHARED, fd_mem, HW_REGS_BASE))
-            == MAP_FAILED)
-    {
-        printf("Error: failed to map FPGA switches.\n");
-        close(fd_mem);
-        return 1;
-    }
+    void *pixel_buffer_addr = dev.pixel_base;
+    void *switch_addr = dev.regs_base;
 
     volatile unsigned char *switches = (unsigned char *)(switch_addr+SW_BASE);
 
@@ -83,217 +64,109 @@ int main()
     volatile unsigned char *pixel_end = (unsigned char *)
 					(pixel_buffer_addr + FPGA_ONCHIP_SPAN);
 
-    // Read data from the mouse
-    int bytes;
-    int left, middle, right;
-    unsigned int x, y = 0;
-    unsigned char drawn_arr[PIXEL_COLS*PIXEL_ROWS];
-    signed char data[3];
-
-    while (1) {
-        bytes = read(fd_mouse, data, sizeof(data));
-
-        if (bytes > 0) {
-            left = data[0] & 0x1;   // first bit
-            right = data[0] & 0x2; // second bit
-            middle = data[0] & 0x4;  // third bit
-	    
-	    if (drawn_arr[index(x, y)] == 0) draw_pixel(pixel, BLACK, x, y);
-
-            x += data[1];
-            if (x < 0) x = 0;
-            else if (x > PIXEL_COLS) x = PIXEL_COLS;
-            y -= data[2];
-            if (y < 0) y = 0;
-            else if (y > PIXEL_ROWS) y = PIXEL_ROWS;
-
-	    if (left && drawn_arr[index(x, y)] == 0 && *(switches) != 2) {
-		drawn_arr[index(x, y)] = 1;
-	    }
-	    else if (left && *(switches) != 2) drawn_arr[index(x, y)] = 0;
-	    else if (left && *(switches) == 2) draw_pi(drawn_arr, pixel, x, y);
-
-	    if (right) draw_gun(drawn_arr, pixel, x, y); 
-
- 	    draw_pixel(pixel, OFF_WHITE, x, y);
+    // Read data from the mouse: each wakeup brings every packet since
+    // the last one, their moves summed and the button presses in order
+    int k, ex, ey, px, py;
+    int x = PIXEL_COLS/2, y = PIXEL_ROWS/2;
+    static unsigned char drawn_arr[PIXEL_COLS*PIXEL_ROWS];
+    mouse_event_t *e;
+
+    while (mouse_dev_wait(&mouse, -1) >= 0) {
+        if (mouse.packets == 0) continue;
+
+        if (drawn_arr[index(x, y)] == 0) draw_pixel(pixel, BLACK, x, y);
+
+        // presses, where the cursor was at the time; (px, py) is the
+        // last left one's, which the drag below must not flip back
+        px = py = -1;
+        for (k = 0; k < mouse.nevents; k++) {
+            e = &mouse.event[k];
+            if (!e->down) continue;
+            ex = clamp(x + e->dx, PIXEL_COLS);
+            ey = clamp(y - e->dy, PIXEL_ROWS);
+            if (e->button == MOUSE_LEFT) {
+                px = ex;
+                py = ey;
+            }
+            if (e->button == MOUSE_LEFT && *(switches) != 2)
+                drawn_arr[index(ex, ey)] ^= 1;
+            else if (e->button == MOUSE_LEFT) draw_pi(drawn_arr, pixel, ex, ey);
+            else if (e->button == MOUSE_RIGHT) draw_gun(drawn_arr, pixel, ex, ey);
         }
+
+        x = clamp(x + mouse.dx, PIXEL_COLS);
+        y = clamp(y - mouse.dy, PIXEL_ROWS);
+
+        // dragging with the left button held flips the cells it ends on,
+        // unless it ends where it was pressed in this same wakeup
+        if ((mouse.buttons & MOUSE_LEFT) && (mouse.dx || mouse.dy) && *(switches) != 2 &&
+            (x != px || y != py))
+            drawn_arr[index(x, y)] ^= 1;
+
+        draw_pixel(pixel, OFF_WHITE, x, y);
     }
 
+    mouse_dev_close(&mouse);
+    vga_dev_close(&dev);
     return 0;
 }
 
-inline unsigned int index(unsigned int x, unsigned int y)
-{ return x + (PIXEL_COLS*(y-1)); }
+// 0..max-1, a column or row of the screen and of drawn_arr
+int clamp(int v, int max)
+{ return v < 0 ? 0 : v > max - 1 ? max - 1 : v; }
+
+static inline unsigned int index(unsigned int x, unsigned int y)
+{ return x + PIXEL_COLS*y; }
 
-inline unsigned int max(unsigned int x1, unsigned int x2)
+static inline unsigned int max(unsigned int x1, unsigned int x2)
 { return x1 > x2 ? x1 : x2; }
 
-inline unsigned int min(unsigned int x1, unsigned int x2)
+static inline unsigned int min(unsigned int x1, unsigned int x2)
 { return x1 < x2 ? x1 : x2; }
 
 void draw_pixel(volatile unsigned char *addr_base, unsigned char color,
 		unsigned int x, unsigned int y)
 {
-    if (x > PIXEL_COLS || y > PIXEL_ROWS) return;
+    if (x >= PIXEL_COLS || y >= PIXEL_ROWS) return;
     *(addr_base + x + (y<<10)) = color;
 }
 
-void draw_pi(unsigned char *drawn_arr, volatile unsigned char *pixel,
-	     unsigned int x, unsigned int y)
-{
-    unsigned int cpx1 = x;
-    unsigned int cpy1 = y;
-    unsigned int cpx2 = x+1;
-    unsigned int cpy2 = y+1;
-    unsigned int cpx3 = x+2;
-    unsigned int cpy3 = y+2;
-
-    if (cpx3 > PIXEL_COLS || cpy3 > PIXEL_ROWS) return;    
-
-    draw_pixel(pixel, OFF_WHITE, cpx1, cpy1);
-    drawn_arr[index(cpx1, cpy1)] = 1;
+// where a pattern's cells go: the screen, and the array of drawn cells
+typedef struct {
+    unsigned char *drawn_arr;
+    volatile unsigned char *pixel;
+} draw_target_t;
 
-    draw_pixel(pixel, OFF_WHITE, cpx2, cpy1);
-    drawn_arr[index(cpx2, cpy1)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, cpx3, cpy1);
-    drawn_arr[index(cpx3, cpy1)] = 1;
+void draw_pattern_cell(void *ctx, int x, int y, int alive)
+{
+    draw_target_t *t = ctx;
 
-    draw_pixel(pixel, OFF_WHITE, cpx1, cpy2);
-    drawn_arr[index(cpx1, cpy2)] = 1;
+    (void)alive;
+    draw_pixel(t->pixel, OFF_WHITE, x, y);
+    t->drawn_arr[index(x, y)] = 1;
+}
 
-    draw_pixel(pixel, OFF_WHITE, cpx1, cpy3);
-    drawn_arr[index(cpx1, cpy3)] = 1;
+// an RLE pattern with its top left at x, y, if all of it fits
+void draw_pattern(const char *rle, unsigned char *drawn_arr,
+		  volatile unsigned char *pixel, unsigned int x, unsigned int y)
+{
+    draw_target_t t = { drawn_arr, pixel };
+    life_place_t at = { draw_pattern_cell, &t, x, y, 0 };
+    life_pattern_info_t info;
 
-    draw_pixel(pixel, OFF_WHITE, cpx3, cpy2);
-    drawn_arr[index(cpx3, cpy2)] = 1;
+    if (life_pattern_parse(rle, NULL, &info) != 0) return;
+    if (x + info.width > PIXEL_COLS || y + info.height > PIXEL_ROWS) return;
+    life_pattern_parse(rle, &at, &info);
+}
 
-    draw_pixel(pixel, OFF_WHITE, cpx3, cpy3);
-    drawn_arr[index(cpx3, cpy3)] = 1;
+void draw_pi(unsigned char *drawn_arr, volatile unsigned char *pixel,
+	     unsigned int x, unsigned int y)
+{
+    draw_pattern(life_pattern_pi, drawn_arr, pixel, x, y);
 }
 
 void draw_gun(unsigned char *drawn_arr, volatile unsigned char *pixel,
 	      unsigned int x, unsigned int y)
 {
-    unsigned int right_bound = x+35;
-    unsigned int bottom_bound = y+8;
-
-    if (right_bound > PIXEL_COLS || bottom_bound > PIXEL_ROWS) return;
-
-    // row 1
-    draw_pixel(pixel, OFF_WHITE, x+24, y);
-    drawn_arr[index(x+24, y)] = 1;
-
-    // row 2
-    draw_pixel(pixel, OFF_WHITE, x+22, y+1);
-    drawn_arr[index(x+22, y+1)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+24, y+1);
-    drawn_arr[index(x+24, y+1)] = 1;
-
-    // row 3
-    draw_pixel(pixel, OFF_WHITE, x+12, y+2);
-    drawn_arr[index(x+12, y+2)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+13, y+2);
-    drawn_arr[index(x+13, y+2)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+20, y+2);
-    drawn_arr[index(x+20, y+2)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+21, y+2);
-    drawn_arr[index(x+21, y+2)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+34, y+2);
-    drawn_arr[index(x+34, y+2)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+35, y+2);
-    drawn_arr[index(x+35, y+2)] = 1;
-
-    // row 4
-    draw_pixel(pixel, OFF_WHITE, x+11, y+3);
-    drawn_arr[index(x+11, y+3)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+15, y+3);
-    drawn_arr[index(x+15, y+3)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+20, y+3);
-    drawn_arr[index(x+20, y+3)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+21, y+3);
-    drawn_arr[index(x+21, y+3)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+34, y+3);
-    drawn_arr[index(x+34, y+3)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+35, y+3);
-    drawn_arr[index(x+35, y+3)] = 1;
-
-    // row 5
-    draw_pixel(pixel, OFF_WHITE, x, y+4);
-    drawn_arr[index(x, y+4)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+1, y+4);
-    drawn_arr[index(x+1, y+4)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+10, y+4);
-    drawn_arr[index(x+10, y+4)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+16, y+4);
-    drawn_arr[index(x+16, y+4)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+20, y+4);
-    drawn_arr[index(x+20, y+4)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+21, y+4);
-    drawn_arr[index(x+21, y+4)] = 1;
-
-    // row 6
-    draw_pixel(pixel, OFF_WHITE, x, y+5);
-    drawn_arr[index(x, y+5)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+1, y+5);
-    drawn_arr[index(x+1, y+5)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+10, y+5);
-    drawn_arr[index(x+10, y+5)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+14, y+5);
-    drawn_arr[index(x+14, y+5)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+16, y+5);
-    drawn_arr[index(x+16, y+5)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+17, y+5);
-    drawn_arr[index(x+17, y+5)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+22, y+5);
-    drawn_arr[index(x+22, y+5)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+24, y+5);
-    drawn_arr[index(x+24, y+5)] = 1;
-
-    // row 7
-    draw_pixel(pixel, OFF_WHITE, x+10, y+6);
-    drawn_arr[index(x+10, y+6)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+16, y+6);
-    drawn_arr[index(x+16, y+6)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+24, y+6);
-    drawn_arr[index(x+24, y+6)] = 1;
-
-    // row 8
-    draw_pixel(pixel, OFF_WHITE, x+11, y+7);
-    drawn_arr[index(x+11, y+7)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+15, y+7);
-    drawn_arr[index(x+15, y+7)] = 1;
-
-    // row 9
-    draw_pixel(pixel, OFF_WHITE, x+12, y+8);
-    drawn_arr[index(x+12, y+8)] = 1;
-
-    draw_pixel(pixel, OFF_WHITE, x+13, y+8);
-    drawn_arr[index(x+13, y+8)] = 1;
+    draw_pattern(life_pattern_gosper_gun, drawn_arr, pixel, x, y);
 }
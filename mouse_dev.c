@@ -0,0 +1,158 @@
+///////////////////////////////////////
+/// Mouse packets, waited for with
+/// epoll instead of a read() spin
+///////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include "mouse_dev.h"
+
+/****************************************************************************************
+ * Open: the mouse non-blocking, since epoll says when to read it, and the
+ * timer ticking tick_hz times a second
+****************************************************************************************/
+int mouse_dev_open_fd(mouse_dev_t *m, int fd, int tick_hz)
+{
+	struct epoll_event ev;
+	struct itimerspec its;
+
+	memset(m, 0, sizeof(*m));
+	m->fd = fd;
+	m->timer = -1;
+	if ((m->ep = epoll_create1(0)) < 0) {
+		printf( "ERROR: epoll_create1() failed...\n" );
+		return -1;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+	if (epoll_ctl(m->ep, EPOLL_CTL_ADD, fd, &ev) != 0) {
+		printf( "ERROR: the mouse cannot be waited for...\n" );
+		mouse_dev_close(m);
+		return -1;
+	}
+	if (tick_hz > 0) {
+		memset(&its, 0, sizeof(its));
+		its.it_interval.tv_sec = tick_hz == 1;
+		its.it_interval.tv_nsec = tick_hz == 1 ? 0 : 1000000000L / tick_hz;
+		its.it_value = its.it_interval;
+		ev.data.fd = m->timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+		if (m->timer < 0 || timerfd_settime(m->timer, 0, &its, NULL) != 0 ||
+		    epoll_ctl(m->ep, EPOLL_CTL_ADD, m->timer, &ev) != 0) {
+			printf( "ERROR: could not start the mouse timer...\n" );
+			mouse_dev_close(m);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int mouse_dev_open(mouse_dev_t *m, const char *path, int tick_hz)
+{
+	int fd;
+
+	if (path == NULL) path = getenv("DE1_MOUSE");
+	if (path == NULL) path = "/dev/input/mice";
+	// read and write, as the programs always opened the mouse: a FIFO
+	// then opens at once and does not end when a writer goes away
+	if ((fd = open(path, O_RDWR | O_NONBLOCK)) == -1) {
+		printf( "ERROR: could not open \"%s\"...\n", path );
+		return -1;
+	}
+	if (mouse_dev_open_fd(m, fd, tick_hz) != 0) {
+		close(fd);
+		return -1;
+	}
+	m->own = 1;
+	return 0;
+}
+
+void mouse_dev_close(mouse_dev_t *m)
+{
+	if (m->own && m->fd >= 0) close(m->fd);
+	if (m->timer >= 0) close(m->timer);
+	if (m->ep >= 0) close(m->ep);
+	m->fd = m->timer = m->ep = -1;
+	m->own = 0;
+}
+
+/****************************************************************************************
+ * One whole packet: its move onto the sum, a button that changed onto
+ * the events
+****************************************************************************************/
+static void mouse_dev_packet(mouse_dev_t *m)
+{
+	mouse_event_t *e;
+	int b, now = m->pkt[0] & 7;
+
+	m->dx += (signed char)m->pkt[1];
+	m->dy += (signed char)m->pkt[2];
+	m->packets++;
+	for (b=MOUSE_LEFT; b<=MOUSE_MIDDLE; b<<=1) {
+		if (!((now ^ m->buttons) & b)) continue;
+		e = &m->event[m->nevents++];
+		e->button = b;
+		e->down = (now & b) != 0;
+		e->dx = m->dx;
+		e->dy = m->dy;
+	}
+	m->buttons = now;
+}
+
+// everything waiting, until there may be no room for the events of
+// another packet; the rest stays in buf for the next wait
+static void mouse_dev_drain(mouse_dev_t *m)
+{
+	unsigned char c;
+	int r;
+
+	while (1) {
+		if (m->pos == m->len) {
+			r = read(m->fd, m->buf, sizeof(m->buf));
+			if (r == 0) m->eof = 1;
+			if (r <= 0) return;
+			m->pos = 0;
+			m->len = r;
+		}
+		while (m->pos < m->len) {
+			if (m->nevents + 3 > MOUSE_EVENTS) return;
+			c = m->buf[m->pos++];
+			if (m->have == 0 && !(c & 0x08)) continue;
+			m->pkt[m->have++] = c;
+			if (m->have == 3) {
+				m->have = 0;
+				mouse_dev_packet(m);
+			}
+		}
+	}
+}
+
+/****************************************************************************************
+ * Wait for the mouse or the timer
+****************************************************************************************/
+int mouse_dev_wait(mouse_dev_t *m, int timeout_ms)
+{
+	struct epoll_event ev[2];
+	uint64_t n;
+	int k, got, input = 0;
+
+	m->dx = m->dy = m->packets = m->ticks = m->nevents = 0;
+	if (m->eof && m->pos == m->len) return -1;
+	// bytes left over from the last wait are there to take now
+	got = epoll_wait(m->ep, ev, 2, m->pos < m->len ? 0 : timeout_ms);
+	if (got < 0 && errno != EINTR) return -1;
+	for (k=0; k<got; k++) {
+		if (ev[k].data.fd != m->timer) input = 1;
+		else if (read(m->timer, &n, sizeof(n)) == sizeof(n)) m->ticks += n;
+	}
+	if (input || m->pos < m->len) mouse_dev_drain(m);
+	if (m->packets || m->ticks) return 1;
+	return m->eof ? -1 : 0;
+}
@@ -0,0 +1,66 @@
+/* Mouse input for the DE1-SoC programs, without spinning on read().
+ *
+ * /dev/input/mice delivers 3-byte PS/2 packets: the buttons (bit 0 left,
+ * bit 1 right, bit 2 middle, bit 3 always set) and signed x and y moves,
+ * y up.  mouse_dev_wait() sleeps in epoll_wait() until the mouse has
+ * something to say or a tick of the optional timer is due, then reads
+ * every packet that is waiting: their moves are added up into one delta
+ * and every button that went down or up is reported as an event, in
+ * order, with the move up to that packet so it can be placed exactly.
+ * A byte that cannot start a packet (bit 3 clear) is dropped, which puts
+ * a stream joined halfway through back in step.
+ *
+ * Anything that reads like the mouse will do: mouse_dev_open() takes a
+ * path, or $DE1_MOUSE, before /dev/input/mice, say a FIFO that a test
+ * writes packets into (it is opened read-write, so writers can come and
+ * go), and mouse_dev_open_fd() takes the read end of a pipe, which ends
+ * when the write end is closed.
+ */
+#ifndef MOUSE_DEV_H
+#define MOUSE_DEV_H
+
+#define MOUSE_LEFT   0x1
+#define MOUSE_RIGHT  0x2
+#define MOUSE_MIDDLE 0x4
+
+#define MOUSE_EVENTS 32         // per wait; more are left for the next
+
+typedef struct mouse_event {
+	int button;             // MOUSE_LEFT, MOUSE_RIGHT or MOUSE_MIDDLE
+	int down;               // 1 pressed, 0 released
+	int dx, dy;             // the wait's move up to and with this packet
+} mouse_event_t;
+
+typedef struct mouse_dev {
+	int fd;                 // the mouse, -1 if none
+	int own;                // fd was opened here, and is closed here
+	int ep;                 // epoll instance
+	int timer;              // timerfd of the ticks, -1 without
+	unsigned char buf[384]; // read but not yet taken apart
+	int pos, len;
+	unsigned char pkt[3];   // a packet split across reads
+	int have;
+	int buttons;            // held, MOUSE_* bits
+
+	// what the last wait found
+	int dx, dy;             // summed move, y up
+	int packets;
+	int ticks;              // timer ticks since the last wait
+	int nevents;
+	mouse_event_t event[MOUSE_EVENTS];
+	int eof;                // the other end is gone
+} mouse_dev_t;
+
+// path == NULL: $DE1_MOUSE if set, else /dev/input/mice. tick_hz > 0
+// also wakes the wait that many times a second. prints the error, -1
+// on failure
+int  mouse_dev_open(mouse_dev_t *m, const char *path, int tick_hz);
+int  mouse_dev_open_fd(mouse_dev_t *m, int fd, int tick_hz);
+void mouse_dev_close(mouse_dev_t *m);
+
+// block until packets or a tick, or for timeout_ms (-1: no limit). 1 when
+// something came, 0 on a timeout, -1 on an error or when the input ended
+// (m->eof) and nothing came before it
+int  mouse_dev_wait(mouse_dev_t *m, int timeout_ms);
+
+#endif
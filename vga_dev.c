@@ -0,0 +1,98 @@
+///////////////////////////////////////
+/// DE1-SoC display and I/O regions,
+/// from /dev/mem or simulated in
+/// plain memory
+///////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "vga_dev.h"
+
+#define SIM_PIXEL_OFF 0
+#define SIM_CHAR_OFF  FPGA_ONCHIP_SPAN
+#define SIM_REGS_OFF  (FPGA_ONCHIP_SPAN + FPGA_CHAR_SPAN)
+#define SIM_SIZE      (SIM_REGS_OFF + HW_REGS_SPAN)
+
+static void *vga_dev_map(int fd, size_t span, off_t base)
+{
+	void *p;
+
+	if (fd < 0)
+		p = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	else
+		p = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_SHARED, fd, base);
+	return p == MAP_FAILED ? NULL : p;
+}
+
+/****************************************************************************************
+ * Map the pixel buffer, character buffer and registers
+****************************************************************************************/
+int vga_dev_open(vga_dev_t *d, const char *sim)
+{
+	struct stat st;
+	const char *sw;
+	int fresh = 1;
+
+	memset(d, 0, sizeof(*d));
+	d->fd = -1;
+	if (sim == NULL) sim = getenv("DE1_SIM");
+
+	if (sim == NULL) {
+		if ((d->fd = open("/dev/mem", (O_RDWR | O_SYNC))) == -1) {
+			printf( "ERROR: could not open \"/dev/mem\"...\n" );
+			return -1;
+		}
+		d->regs_base  = vga_dev_map(d->fd, HW_REGS_SPAN, HW_REGS_BASE);
+		d->char_base  = vga_dev_map(d->fd, FPGA_CHAR_SPAN, FPGA_CHAR_BASE);
+		d->pixel_base = vga_dev_map(d->fd, FPGA_ONCHIP_SPAN, FPGA_ONCHIP_BASE);
+	}
+	else {
+		d->sim = 1;
+		if (*sim) {
+			if ((d->fd = open(sim, O_RDWR | O_CREAT, 0666)) == -1) {
+				printf( "ERROR: could not open \"%s\"...\n", sim );
+				return -1;
+			}
+			// an existing file keeps its switches
+			fresh = fstat(d->fd, &st) != 0 || st.st_size < SIM_SIZE;
+			if (fresh && ftruncate(d->fd, SIM_SIZE) != 0) {
+				printf( "ERROR: could not size \"%s\"...\n", sim );
+				vga_dev_close(d);
+				return -1;
+			}
+		}
+		d->pixel_base = vga_dev_map(d->fd, FPGA_ONCHIP_SPAN, SIM_PIXEL_OFF);
+		d->char_base  = vga_dev_map(d->fd, FPGA_CHAR_SPAN, SIM_CHAR_OFF);
+		d->regs_base  = vga_dev_map(d->fd, HW_REGS_SPAN, SIM_REGS_OFF);
+	}
+	if (d->pixel_base == NULL || d->char_base == NULL || d->regs_base == NULL) {
+		printf( "ERROR: mmap() failed...\n" );
+		vga_dev_close(d);
+		return -1;
+	}
+
+	if (d->sim) {
+		// what the 640x480 video controllers report; no buffer swap pending
+		*VGA_DEV_REG(d, VGA_PIXEL_RES) = (480 << 16) | 640;
+		*VGA_DEV_REG(d, VGA_PIXEL_STAT) = 0;
+		*VGA_DEV_REG(d, VGA_CHAR_RES) = (60 << 16) | 80;
+		*VGA_DEV_REG(d, VGA_CHAR_STAT) = 0;
+		if (fresh && (sw = getenv("DE1_SW")) != NULL)
+			*VGA_DEV_REG(d, SW_BASE) = strtoul(sw, NULL, 0);
+	}
+	return 0;
+}
+
+void vga_dev_close(vga_dev_t *d)
+{
+	if (d->pixel_base) munmap(d->pixel_base, FPGA_ONCHIP_SPAN);
+	if (d->char_base) munmap(d->char_base, FPGA_CHAR_SPAN);
+	if (d->regs_base) munmap(d->regs_base, HW_REGS_SPAN);
+	if (d->fd >= 0) close(d->fd);
+	memset(d, 0, sizeof(*d));
+	d->fd = -1;
+}
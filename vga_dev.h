@@ -0,0 +1,47 @@
+/* Display and I/O access for the DE1-SoC Computer System.
+ *
+ * Opens the three regions every program here maps: the pixel buffer
+ * (FPGA_ONCHIP_BASE, 1024 bytes per row), the character buffer
+ * (FPGA_CHAR_BASE, 128 bytes per row) and the lightweight bus registers
+ * (HW_REGS_BASE: LEDs, switches, keys, the video controllers).
+ *
+ * There are two backends.  The real one maps /dev/mem.  The simulated one
+ * maps plain memory laid out the same way, so the programs run unchanged on
+ * any Linux box: the switch, key and LED registers are ordinary words, and
+ * the video controllers' resolution and status registers read back what the
+ * 640x480 hardware reports.  The simulated backend is picked by passing a
+ * path to vga_dev_open(), or by setting DE1_SIM in the environment:
+ *
+ *   DE1_SIM=""        anonymous memory
+ *   DE1_SIM=file      the pixel buffer, character buffer and registers, in
+ *                     that order, in one file that other processes can
+ *                     read, or write to flip the switches
+ *   DE1_SW=value      initial switch setting, when not taken from a file
+ */
+#ifndef VGA_DEV_H
+#define VGA_DEV_H
+
+#include "address_map_arm_brl4.h"
+
+// pixel and character buffer controllers, offsets from HW_REGS_BASE
+#define VGA_PIXEL_RES   (PIXEL_BUF_CTRL_BASE + 0x8)
+#define VGA_PIXEL_STAT  (PIXEL_BUF_CTRL_BASE + 0xc)
+#define VGA_CHAR_RES    (CHAR_BUF_CTRL_BASE + 0x8)
+#define VGA_CHAR_STAT   (CHAR_BUF_CTRL_BASE + 0xc)
+
+typedef struct vga_dev {
+	int sim;                // simulated backend
+	int fd;                 // /dev/mem or the backing file, -1 if none
+	void *pixel_base;       // FPGA_ONCHIP_SPAN bytes, 1024 per row
+	void *char_base;        // FPGA_CHAR_SPAN bytes, 128 per row
+	void *regs_base;        // HW_REGS_SPAN bytes of registers
+} vga_dev_t;
+
+// register at offset off from HW_REGS_BASE (LEDR_BASE, SW_BASE, ...)
+#define VGA_DEV_REG(d, off) ((volatile unsigned int *)((char *)(d)->regs_base + (off)))
+
+// sim == NULL: $DE1_SIM if set, else /dev/mem; prints the error, -1 on failure
+int  vga_dev_open(vga_dev_t *d, const char *sim);
+void vga_dev_close(vga_dev_t *d);
+
+#endif